@@ -599,7 +599,8 @@ ups_get_version(uint32_t *major, uint32_t *minor,
  * as well. Ignored for remote Environments.
  *
  * CRC32 checksums are stored when a page is flushed, and verified
- * when it is fetched from disk if the flag @ref UPS_ENABLE_CRC32 is set.
+ * when it is fetched from disk if the flag @ref UPS_ENABLE_CRC32 is set
+ * (see @ref UPS_PARAM_CRC32_ALGORITHM).
  * API functions will return @ref UPS_INTEGRITY_VIOLATED in case of failed
  * verifications. Not allowed in In-Memory Environments. This flag is not
  * persisted.
@@ -635,6 +636,14 @@ ups_get_version(uint32_t *major, uint32_t *minor,
  *      Environment.
  *     <li>@ref UPS_ENABLE_CRC32</li> Stores (and verifies) CRC32
  *      checksums. Not allowed in combination with @ref UPS_IN_MEMORY.
+ *     <li>@ref UPS_DIRECT_IO</li> Bypasses the operating system's page
+ *      cache (O_DIRECT) when reading or writing the Database file; pages
+ *      are only cached in the upscaledb cache, and @ref UPS_PARAM_CACHE_SIZE
+ *      limits the memory used for pages. Implies @ref UPS_DISABLE_MMAP.
+ *      The page size should be a multiple of 4096. The journal files are
+ *      not affected. Falls back to buffered I/O if the file system does
+ *      not support direct I/O. Not allowed in combination with
+ *      @ref UPS_IN_MEMORY.
  *    </ul>
  *
  * @param mode File access rights for the new file. This is the @a mode
@@ -650,6 +659,100 @@ ups_get_version(uint32_t *major, uint32_t *minor,
  *      posix_fadvise(). Only on supported platforms. Allowed values are
  *      @ref UPS_POSIX_FADVICE_NORMAL (which is the default) or
  *      @ref UPS_POSIX_FADVICE_RANDOM.
+ *    <li>@ref UPS_PARAM_CACHE_SHARDS</li> Splits the cache into several
+ *      shards, each with its own lock and its own LRU list. Pages are
+ *      partitioned by their address. The default is 1.
+ *    <li>@ref UPS_PARAM_CACHE_POLICY</li> The replacement policy of the
+ *      cache; either @ref UPS_CACHE_POLICY_LRU (the default) or
+ *      @ref UPS_CACHE_POLICY_CLOCK or @ref UPS_CACHE_POLICY_SLRU. With
+ *      CLOCK, a cache hit only sets a reference bit instead of moving the
+ *      page in the LRU list. SLRU is scan-resistant: pages read by cursor
+ *      scans or @ref uqi_select_range are only promoted to the protected
+ *      segment if they are accessed by other operations.
+ *    <li>@ref UPS_PARAM_CACHE_INTERNAL_NODES</li> Internal B+tree nodes
+ *      are always purged after leaf nodes and blob pages. This parameter
+ *      reserves a part of the cache (in percent, 0 - 100) for internal
+ *      nodes, which are then not purged at all. The default is 0.
+ *    <li>@ref UPS_PARAM_CACHE_WARMUP</li> If set to a value > 0 then
+ *      the addresses of (up to) this many recently used pages are stored
+ *      in a manifest file ("<filename>.wrm") when the Environment is
+ *      closed. When the Environment is opened again with this parameter,
+ *      a background thread reads these pages into the cache, until the
+ *      cache is full. Ignored for In-Memory Environments. The default is 0.
+ *    <li>@ref UPS_PARAM_PAGE_ARENA</li> Allocates the buffers of pages
+ *      from large pre-allocated memory regions instead of the heap; either
+ *      @ref UPS_PAGE_ARENA_DISABLED (the default),
+ *      @ref UPS_PAGE_ARENA_ENABLED or @ref UPS_PAGE_ARENA_HUGE_PAGES. With
+ *      huge pages, the regions are mapped with MAP_HUGETLB (if huge pages
+ *      are reserved in the system), otherwise transparent huge pages are
+ *      requested.
+ *    <li>@ref UPS_PARAM_CACHE_SAMPLING</li> Estimates the hit ratio of
+ *      the cache for other cache sizes (from 1/8 to 16 times the current
+ *      size), based on a sample of the accessed pages. The value is the
+ *      sampling rate in 1/1000 (0 - 1000); e.g. 10 samples 1% of the
+ *      pages. The estimates are returned by @ref ups_env_get_metrics. Not
+ *      available if the cache is unlimited. The default is 0 (disabled).
+ *    <li>@ref UPS_PARAM_FLUSH_THREADS</li> The number of background
+ *      threads which write dirty pages to the file (1 - 64). The pages
+ *      are partitioned by their address; idle threads take over work from
+ *      busy ones. The default is 1.
+ *    <li>@ref UPS_PARAM_IO_BACKEND</li> Selects how batches of pages are
+ *      read from the file: @ref UPS_IO_BACKEND_PREAD (the default) reads
+ *      them one by one, @ref UPS_IO_BACKEND_IO_URING submits them with
+ *      io_uring (Linux only; falls back to pread if io_uring is not
+ *      available). Ignored for In-Memory Environments.
+ *    <li>@ref UPS_PARAM_FILE_EXTENT_SIZE</li> Reserves disk space for the
+ *      file in extents of this size (in bytes), with fallocate(2), before
+ *      the file grows. Pages are then allocated from mostly contiguous
+ *      disk space. Unused reserved space is released when the Environment
+ *      is closed. Ignored for In-Memory Environments and if the file
+ *      system does not support fallocate. The default is 0 (disabled).
+ *    <li>@ref UPS_PARAM_STRIPE_PATHS</li> A list of additional files,
+ *      separated by ';', across which the Environment is striped (i.e.
+ *      to spread it across several disks). The Environment's own file
+ *      stores the first stripe. The files are not mapped. The same list
+ *      (and @ref UPS_PARAM_STRIPE_SIZE) has to be specified whenever the
+ *      Environment is opened. Not allowed in combination with
+ *      encryption; ignored for In-Memory Environments.
+ *    <li>@ref UPS_PARAM_STRIPE_SIZE</li> The size of a stripe (in bytes)
+ *      if @ref UPS_PARAM_STRIPE_PATHS is set; must be a multiple of the
+ *      page size. The stripes are distributed round-robin across the
+ *      files. The default is the default page size (16kb).
+ *    <li>@ref UPS_PARAM_CRC32_ALGORITHM</li> Selects the checksum of the
+ *      pages if @ref UPS_ENABLE_CRC32 is set: @ref UPS_CRC32_MURMUR3 (the
+ *      default) or @ref UPS_CRC32_CRC32C, which uses the crc32 instruction
+ *      of SSE4.2 if the CPU supports it. The algorithm is stored in the
+ *      header and used whenever the Environment is opened.
+ *    <li>@ref UPS_PARAM_PAGE_COMPRESSION</li> Compresses the pages of
+ *      the Environment's file with @ref UPS_COMPRESSOR_LZF,
+ *      @ref UPS_COMPRESSOR_SNAPPY or @ref UPS_COMPRESSOR_ZLIB. Each page
+ *      is stored in a slot of variable size; the slots are recorded in a
+ *      separate file (the filename plus ".pagemap"). The file is not
+ *      mapped. The same algorithm has to be specified whenever the
+ *      Environment is opened. Not allowed in combination with encryption,
+ *      striping or @ref UPS_DIRECT_IO; ignored for In-Memory Environments.
+ *    <li>@ref UPS_PARAM_JOURNAL_GROUP_COMMIT_DELAY</li> The maximum
+ *      time (in microseconds) a committing Transaction waits for other
+ *      commits before the journal is synced if @ref UPS_ENABLE_FSYNC is
+ *      set. Concurrent commits always share a single sync; a delay
+ *      increases the size of these groups at the cost of latency. The
+ *      default is 0 (no delay).
+ *    <li>@ref UPS_PARAM_JOURNAL_GROUP_COMMIT_SIZE</li> Ends the delay of
+ *      @ref UPS_PARAM_JOURNAL_GROUP_COMMIT_DELAY as soon as this many
+ *      commits are waiting. The default is 32.
+ *    <li>@ref UPS_PARAM_JOURNAL_WRITER_THREAD</li> If set to 1, the
+ *      journal is written (and synced) by a background thread. Inserts,
+ *      erases and commits without @ref UPS_ENABLE_FSYNC then only copy
+ *      their journal entries to a buffer; if the process crashes, such
+ *      commits can be lost even though they returned. The default is 0
+ *      (disabled).
+ *    <li>@ref UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL</li> Writes a
+ *      checkpoint (see @ref ups_env_checkpoint) when a Transaction commits
+ *      and this many seconds passed since the last checkpoint. The default
+ *      is 0 (disabled).
+ *    <li>@ref UPS_PARAM_JOURNAL_CHECKPOINT_SIZE</li> Writes a checkpoint
+ *      when a Transaction commits and this many bytes were appended to
+ *      the journal since the last checkpoint. The default is 0 (disabled).
  *    <li>@ref UPS_PARAM_PAGE_SIZE</li> The size of a file page, in
  *      bytes. It is recommended not to change the default size. The
  *      default size depends on hardware and operating system.
@@ -720,7 +823,8 @@ ups_env_create(ups_env_t **env, const char *filename,
  * persisted.
  *
  * CRC32 checksums are stored when a page is flushed, and verified
- * when it is fetched from disk if the flag @ref UPS_ENABLE_CRC32 is set.
+ * when it is fetched from disk if the flag @ref UPS_ENABLE_CRC32 is set
+ * (see @ref UPS_PARAM_CRC32_ALGORITHM).
  * API functions will return @ref UPS_INTEGRITY_VIOLATED in case of failed
  * verifications. This flag is not persisted.
  *
@@ -754,6 +858,9 @@ ups_env_create(ups_env_t **env, const char *filename,
  *      if necessary.
  *     <li>@ref UPS_ENABLE_CRC32</li> Stores (and verifies) CRC32
  *      checksums.
+ *     <li>@ref UPS_DIRECT_IO</li> Bypasses the operating system's page
+ *      cache (O_DIRECT) when reading or writing the Database file. Implies
+ *      @ref UPS_DISABLE_MMAP. See @ref ups_env_create for details.
  *    </ul>
  * @param param An array of ups_parameter_t structures. The following
  *      parameters are available:
@@ -765,6 +872,100 @@ ups_env_create(ups_env_t **env, const char *filename,
  *      posix_fadvise(). Only on supported platforms. Allowed values are
  *      @ref UPS_POSIX_FADVICE_NORMAL (which is the default) or
  *      @ref UPS_POSIX_FADVICE_RANDOM.
+ *    <li>@ref UPS_PARAM_CACHE_SHARDS</li> Splits the cache into several
+ *      shards, each with its own lock and its own LRU list. Pages are
+ *      partitioned by their address. The default is 1.
+ *    <li>@ref UPS_PARAM_CACHE_POLICY</li> The replacement policy of the
+ *      cache; either @ref UPS_CACHE_POLICY_LRU (the default) or
+ *      @ref UPS_CACHE_POLICY_CLOCK or @ref UPS_CACHE_POLICY_SLRU. With
+ *      CLOCK, a cache hit only sets a reference bit instead of moving the
+ *      page in the LRU list. SLRU is scan-resistant: pages read by cursor
+ *      scans or @ref uqi_select_range are only promoted to the protected
+ *      segment if they are accessed by other operations.
+ *    <li>@ref UPS_PARAM_CACHE_INTERNAL_NODES</li> Internal B+tree nodes
+ *      are always purged after leaf nodes and blob pages. This parameter
+ *      reserves a part of the cache (in percent, 0 - 100) for internal
+ *      nodes, which are then not purged at all. The default is 0.
+ *    <li>@ref UPS_PARAM_CACHE_WARMUP</li> If set to a value > 0 then
+ *      the addresses of (up to) this many recently used pages are stored
+ *      in a manifest file ("<filename>.wrm") when the Environment is
+ *      closed. When the Environment is opened again with this parameter,
+ *      a background thread reads these pages into the cache, until the
+ *      cache is full. Ignored for In-Memory Environments. The default is 0.
+ *    <li>@ref UPS_PARAM_PAGE_ARENA</li> Allocates the buffers of pages
+ *      from large pre-allocated memory regions instead of the heap; either
+ *      @ref UPS_PAGE_ARENA_DISABLED (the default),
+ *      @ref UPS_PAGE_ARENA_ENABLED or @ref UPS_PAGE_ARENA_HUGE_PAGES. With
+ *      huge pages, the regions are mapped with MAP_HUGETLB (if huge pages
+ *      are reserved in the system), otherwise transparent huge pages are
+ *      requested.
+ *    <li>@ref UPS_PARAM_CACHE_SAMPLING</li> Estimates the hit ratio of
+ *      the cache for other cache sizes (from 1/8 to 16 times the current
+ *      size), based on a sample of the accessed pages. The value is the
+ *      sampling rate in 1/1000 (0 - 1000); e.g. 10 samples 1% of the
+ *      pages. The estimates are returned by @ref ups_env_get_metrics. Not
+ *      available if the cache is unlimited. The default is 0 (disabled).
+ *    <li>@ref UPS_PARAM_FLUSH_THREADS</li> The number of background
+ *      threads which write dirty pages to the file (1 - 64). The pages
+ *      are partitioned by their address; idle threads take over work from
+ *      busy ones. The default is 1.
+ *    <li>@ref UPS_PARAM_IO_BACKEND</li> Selects how batches of pages are
+ *      read from the file: @ref UPS_IO_BACKEND_PREAD (the default) reads
+ *      them one by one, @ref UPS_IO_BACKEND_IO_URING submits them with
+ *      io_uring (Linux only; falls back to pread if io_uring is not
+ *      available). Ignored for In-Memory Environments.
+ *    <li>@ref UPS_PARAM_FILE_EXTENT_SIZE</li> Reserves disk space for the
+ *      file in extents of this size (in bytes), with fallocate(2), before
+ *      the file grows. Pages are then allocated from mostly contiguous
+ *      disk space. Unused reserved space is released when the Environment
+ *      is closed. Ignored for In-Memory Environments and if the file
+ *      system does not support fallocate. The default is 0 (disabled).
+ *    <li>@ref UPS_PARAM_STRIPE_PATHS</li> A list of additional files,
+ *      separated by ';', across which the Environment is striped (i.e.
+ *      to spread it across several disks). The Environment's own file
+ *      stores the first stripe. The files are not mapped. The same list
+ *      (and @ref UPS_PARAM_STRIPE_SIZE) has to be specified whenever the
+ *      Environment is opened. Not allowed in combination with
+ *      encryption; ignored for In-Memory Environments.
+ *    <li>@ref UPS_PARAM_STRIPE_SIZE</li> The size of a stripe (in bytes)
+ *      if @ref UPS_PARAM_STRIPE_PATHS is set; must be a multiple of the
+ *      page size. The stripes are distributed round-robin across the
+ *      files. The default is the default page size (16kb).
+ *    <li>@ref UPS_PARAM_PAGE_COMPRESSION</li> Compresses the pages of
+ *      the Environment's file with @ref UPS_COMPRESSOR_LZF,
+ *      @ref UPS_COMPRESSOR_SNAPPY or @ref UPS_COMPRESSOR_ZLIB. Each page
+ *      is stored in a slot of variable size; the slots are recorded in a
+ *      separate file (the filename plus ".pagemap"). The file is not
+ *      mapped. The same algorithm has to be specified whenever the
+ *      Environment is opened. Not allowed in combination with encryption,
+ *      striping or @ref UPS_DIRECT_IO; ignored for In-Memory Environments.
+ *    <li>@ref UPS_PARAM_JOURNAL_GROUP_COMMIT_DELAY</li> The maximum
+ *      time (in microseconds) a committing Transaction waits for other
+ *      commits before the journal is synced if @ref UPS_ENABLE_FSYNC is
+ *      set. Concurrent commits always share a single sync; a delay
+ *      increases the size of these groups at the cost of latency. The
+ *      default is 0 (no delay).
+ *    <li>@ref UPS_PARAM_JOURNAL_GROUP_COMMIT_SIZE</li> Ends the delay of
+ *      @ref UPS_PARAM_JOURNAL_GROUP_COMMIT_DELAY as soon as this many
+ *      commits are waiting. The default is 32.
+ *    <li>@ref UPS_PARAM_JOURNAL_WRITER_THREAD</li> If set to 1, the
+ *      journal is written (and synced) by a background thread. Inserts,
+ *      erases and commits without @ref UPS_ENABLE_FSYNC then only copy
+ *      their journal entries to a buffer; if the process crashes, such
+ *      commits can be lost even though they returned. The default is 0
+ *      (disabled).
+ *    <li>@ref UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL</li> Writes a
+ *      checkpoint (see @ref ups_env_checkpoint) when a Transaction commits
+ *      and this many seconds passed since the last checkpoint. The default
+ *      is 0 (disabled).
+ *    <li>@ref UPS_PARAM_JOURNAL_CHECKPOINT_SIZE</li> Writes a checkpoint
+ *      when a Transaction commits and this many bytes were appended to
+ *      the journal since the last checkpoint. The default is 0 (disabled).
+ *    <li>@ref UPS_PARAM_RECOVERY_THREADS</li> The number of threads
+ *      for the recovery (with @ref UPS_AUTO_RECOVERY). The newest image of
+ *      each page is written by these threads, and compressed journal
+ *      entries are decompressed in parallel. The logical operations are
+ *      still applied in their original order. The default is 1.
  *    <li>@ref UPS_PARAM_FILE_SIZE_LIMIT</li> Sets a file size limit (in bytes).
  *      Disabled by default. If the limit is exceeded, API functions
  *      return @ref UPS_LIMITS_REACHED.
@@ -821,6 +1022,43 @@ ups_env_open(ups_env_t **env, const char *filename,
  *    <li>@ref UPS_PARAM_JOURNAL_COMPRESSION</li> Returns the
  *        selected algorithm for journal compression, or 0 if compression
  *        is disabled
+ *    <li>@ref UPS_PARAM_CACHE_SHARDS</li> Returns the number of cache
+ *        shards
+ *    <li>@ref UPS_PARAM_CACHE_POLICY</li> Returns the replacement policy
+ *        of the cache
+ *    <li>@ref UPS_PARAM_CACHE_INTERNAL_NODES</li> Returns the part of the
+ *        cache (in percent) reserved for internal B+tree nodes
+ *    <li>@ref UPS_PARAM_CACHE_WARMUP</li> Returns the number of pages
+ *        which are recorded for warming up the cache
+ *    <li>@ref UPS_PARAM_PAGE_ARENA</li> Returns how page buffers are
+ *        allocated
+ *    <li>@ref UPS_PARAM_CACHE_SAMPLING</li> Returns the sampling rate
+ *        (in 1/1000) for estimating the hit ratio of the cache
+ *    <li>@ref UPS_PARAM_FLUSH_THREADS</li> Returns the number of threads
+ *        which flush dirty pages
+ *    <li>@ref UPS_PARAM_IO_BACKEND</li> Returns the backend for reading
+ *        pages
+ *    <li>@ref UPS_PARAM_FILE_EXTENT_SIZE</li> Returns the size of the
+ *        extents which are reserved when the file grows
+ *    <li>@ref UPS_PARAM_STRIPE_PATHS</li> Returns the list of additional
+ *        files across which the Environment is striped, or NULL
+ *    <li>@ref UPS_PARAM_STRIPE_SIZE</li> Returns the size of a stripe
+ *    <li>@ref UPS_PARAM_CRC32_ALGORITHM</li> Returns the algorithm of the
+ *        page checksums
+ *    <li>@ref UPS_PARAM_PAGE_COMPRESSION</li> Returns the algorithm
+ *        for page compression, or 0 if compression is disabled
+ *    <li>@ref UPS_PARAM_JOURNAL_GROUP_COMMIT_DELAY</li> Returns the
+ *        maximum delay (in microseconds) of a group commit
+ *    <li>@ref UPS_PARAM_JOURNAL_GROUP_COMMIT_SIZE</li> Returns the number
+ *        of commits which ends the delay of a group commit
+ *    <li>@ref UPS_PARAM_JOURNAL_WRITER_THREAD</li> Returns 1 if the
+ *        journal is written by a background thread, otherwise 0
+ *    <li>@ref UPS_PARAM_RECOVERY_THREADS</li> Returns the number of
+ *        threads for the recovery
+ *    <li>@ref UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL</li> Returns the
+ *        interval (in seconds) of the automatic checkpoints
+ *    <li>@ref UPS_PARAM_JOURNAL_CHECKPOINT_SIZE</li> Returns the number of
+ *        journal bytes which trigger an automatic checkpoint
  *    </ul>
  *
  * @param env A valid Environment handle
@@ -1133,6 +1371,33 @@ ups_env_erase_db(ups_env_t *env, uint16_t name, uint32_t flags);
 ups_status_t
 ups_env_flush(ups_env_t *env, uint32_t flags);
 
+/**
+ * Writes a checkpoint to the journal
+ *
+ * A checkpoint flushes the committed Transactions and records the pages
+ * which are not yet written to the Environment's file, and the oldest
+ * journal entry which is still required. The checkpoint does not wait
+ * till these pages are written. Afterwards, older journal files are
+ * cleared as soon as they are no longer required, and the recovery
+ * skips everything which is covered by the last checkpoint.
+ *
+ * See @ref UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL and
+ * @ref UPS_PARAM_JOURNAL_CHECKPOINT_SIZE for automatic checkpoints.
+ *
+ * If the Environment does not have a journal (i.e. because Transactions
+ * are disabled or the Environment is In-Memory), the function will have
+ * no effect and will return @ref UPS_SUCCESS.
+ *
+ * @param env A valid Environment handle
+ * @param flags Optional flags; unused, set to 0
+ *
+ * @return @ref UPS_SUCCESS upon success
+ * @return @ref UPS_INV_PARAMETER if @a env is NULL
+ * @return @ref UPS_NOT_IMPLEMENTED if @a env is a remote Environment
+ */
+ups_status_t
+ups_env_checkpoint(ups_env_t *env, uint32_t flags);
+
 /* internal use only - don't lock mutex */
 #define UPS_DONT_LOCK        0xf0000000
 
@@ -1404,6 +1669,10 @@ ups_txn_abort(ups_txn_t *txn, uint32_t flags);
  * This flag is non persistent. */
 #define UPS_FLUSH_TRANSACTIONS_IMMEDIATELY          0x08000000
 
+/** Flag for @ref ups_env_open, @ref ups_env_create.
+ * This flag is non persistent. */
+#define UPS_DIRECT_IO                               0x10000000
+
 /**
  * Typedef for a key comparison function
  *
@@ -1793,6 +2062,123 @@ ups_db_get_parameters(ups_db_t *db, ups_parameter_t *param);
 /** Parameter name for @ref ups_env_create_db; sets the record type */
 #define UPS_PARAM_RECORD_TYPE           0x00000112
 
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * number of cache shards */
+#define UPS_PARAM_CACHE_SHARDS          0x00000113
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * replacement policy of the cache */
+#define UPS_PARAM_CACHE_POLICY          0x00000114
+
+/** Value for @ref UPS_PARAM_CACHE_POLICY: least recently used (default) */
+#define UPS_CACHE_POLICY_LRU            0
+
+/** Value for @ref UPS_PARAM_CACHE_POLICY: CLOCK (second chance) */
+#define UPS_CACHE_POLICY_CLOCK          1
+
+/** Value for @ref UPS_PARAM_CACHE_POLICY: segmented LRU; scan-resistant */
+#define UPS_CACHE_POLICY_SLRU           2
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * part of the cache (in percent) which is reserved for internal B+tree
+ * nodes */
+#define UPS_PARAM_CACHE_INTERNAL_NODES  0x00000115
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * number of recently used pages which are recorded when the Environment
+ * is closed, and loaded into the cache when it is opened again */
+#define UPS_PARAM_CACHE_WARMUP          0x00000116
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; allocates
+ * the page buffers from a pooled arena */
+#define UPS_PARAM_PAGE_ARENA            0x00000117
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * rate (in 1/1000) of pages which are sampled to estimate the hit ratio
+ * of the cache at different sizes */
+#define UPS_PARAM_CACHE_SAMPLING        0x00000118
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * number of background threads which flush dirty pages */
+#define UPS_PARAM_FLUSH_THREADS         0x00000119
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; selects the
+ * backend for reading pages */
+#define UPS_PARAM_IO_BACKEND            0x0000011A
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * size of the extents which are reserved when the file grows */
+#define UPS_PARAM_FILE_EXTENT_SIZE      0x0000011B
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets a
+ * list of additional files across which the Environment is striped */
+#define UPS_PARAM_STRIPE_PATHS          0x0000011C
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * size of a stripe */
+#define UPS_PARAM_STRIPE_SIZE           0x0000011D
+
+/** Parameter name for @ref ups_env_create; selects the algorithm of the
+ * page checksums */
+#define UPS_PARAM_CRC32_ALGORITHM       0x0000011E
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; enables
+ * compression for the pages of the Environment's file */
+#define UPS_PARAM_PAGE_COMPRESSION      0x0000011F
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * maximum time (in microseconds) a commit waits for other commits before
+ * the journal is synced */
+#define UPS_PARAM_JOURNAL_GROUP_COMMIT_DELAY  0x00000120
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * number of waiting commits which ends the delay of a group commit */
+#define UPS_PARAM_JOURNAL_GROUP_COMMIT_SIZE   0x00000121
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; enables
+ * the background thread which writes the journal */
+#define UPS_PARAM_JOURNAL_WRITER_THREAD       0x00000122
+
+/** Parameter name for @ref ups_env_open; sets the number of threads for
+ * the recovery */
+#define UPS_PARAM_RECOVERY_THREADS            0x00000123
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * interval (in seconds) of the automatic journal checkpoints */
+#define UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL 0x00000124
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * number of journal bytes which trigger an automatic checkpoint */
+#define UPS_PARAM_JOURNAL_CHECKPOINT_SIZE     0x00000125
+
+/** Value for @ref UPS_PARAM_PAGE_ARENA: each page buffer is allocated
+ * on the heap (default) */
+#define UPS_PAGE_ARENA_DISABLED         0
+
+/** Value for @ref UPS_PARAM_PAGE_ARENA: page buffers are allocated from
+ * the arena */
+#define UPS_PAGE_ARENA_ENABLED          1
+
+/** Value for @ref UPS_PARAM_PAGE_ARENA: page buffers are allocated from
+ * the arena, which is backed by huge pages (if available) */
+#define UPS_PAGE_ARENA_HUGE_PAGES       2
+
+/** Value for @ref UPS_PARAM_IO_BACKEND: pages are read with pread (or
+ * mapped) one by one (default) */
+#define UPS_IO_BACKEND_PREAD            0
+
+/** Value for @ref UPS_PARAM_IO_BACKEND: batches of pages are read
+ * with io_uring */
+#define UPS_IO_BACKEND_IO_URING         1
+
+/** Value for @ref UPS_PARAM_CRC32_ALGORITHM: pages are hashed with
+ * MurmurHash3 (default) */
+#define UPS_CRC32_MURMUR3               0
+
+/** Value for @ref UPS_PARAM_CRC32_ALGORITHM: pages are checksummed with
+ * CRC32C */
+#define UPS_CRC32_CRC32C                1
+
 
 
 
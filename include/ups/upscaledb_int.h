@@ -209,7 +209,10 @@ typedef struct btree_metrics_t {
  * Metrics marked "global" are stored globally and shared between multiple
  * Environments.
  */
-#define UPS_METRICS_VERSION         9
+#define UPS_METRICS_VERSION         12
+
+/* the number of cache sizes for which the hit ratio is estimated */
+#define UPS_CACHE_ADVICE_SIZES      8
 
 typedef struct ups_env_metrics_t {
   /* the version indicator - must be UPS_METRICS_VERSION */
@@ -259,6 +262,32 @@ typedef struct ups_env_metrics_t {
   /* number of cache misses */
   uint64_t cache_misses;
 
+  /* number of buckets in the cache's hash table (summed over all shards) */
+  uint64_t cache_buckets;
+
+  /* average number of pages in each non-empty bucket of the cache */
+  double cache_avg_chain_length;
+
+  /* hypothetical cache sizes, from 1/8 to 16 times the current capacity;
+   * only filled in if UPS_PARAM_CACHE_SAMPLING is enabled */
+  uint64_t cache_advice_size_bytes[UPS_CACHE_ADVICE_SIZES];
+
+  /* the estimated hit ratio (0.0 - 1.0) of a LRU cache with the size
+   * |cache_advice_size_bytes[i]| */
+  double cache_advice_hit_ratio[UPS_CACHE_ADVICE_SIZES];
+
+  /* bytes committed by the page arena (see UPS_PARAM_PAGE_ARENA) */
+  uint64_t page_arena_committed_bytes;
+
+  /* bytes of the page arena which are used by page buffers */
+  uint64_t page_arena_used_bytes;
+
+  /* bytes of the page arena which are backed by huge pages (MAP_HUGETLB) */
+  uint64_t page_arena_hugetlb_bytes;
+
+  /* bytes of the page arena which use transparent huge pages */
+  uint64_t page_arena_thp_bytes;
+
   /* number of blobs allocated */
   uint64_t blob_total_allocated;
 
@@ -286,6 +315,20 @@ typedef struct ups_env_metrics_t {
   /* log/journal bytes after compression */
   uint64_t journal_bytes_after_compression;
 
+  /* number of journal syncs which made committed transactions durable
+   * (with UPS_ENABLE_FSYNC) */
+  uint64_t journal_group_commits;
+
+  /* number of committed transactions which were made durable by these
+   * syncs */
+  uint64_t journal_group_commit_txns;
+
+  /* the largest number of transactions made durable by a single sync */
+  uint64_t journal_group_commit_max_size;
+
+  /* number of checkpoints which were written to the journal */
+  uint64_t journal_checkpoints;
+
   /* record bytes before compression */
   uint64_t record_bytes_before_compression;
 
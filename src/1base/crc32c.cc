@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+#include "0root/root.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#  define UPS_CRC32C_SSE42
+#  include <nmmintrin.h>
+#endif
+
+// Always verify that a file of level N does not include headers > N!
+#include "1base/crc32c.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+// The CRC32C polynomial (reversed)
+static const uint32_t kPolynomial = 0x82f63b78;
+
+// The sizes of the interleaved blocks; must be powers of two
+enum {
+  kLongBlock = 2048,
+  kShortBlock = 256
+};
+
+// Multiplies the GF(2) matrix |mat| with the vector |vec|
+static uint32_t
+gf2_matrix_times(const uint32_t *mat, uint32_t vec)
+{
+  uint32_t sum = 0;
+  while (vec) {
+    if (vec & 1)
+      sum ^= *mat;
+    vec >>= 1;
+    mat++;
+  }
+  return sum;
+}
+
+// Squares the GF(2) matrix |mat|
+static void
+gf2_matrix_square(uint32_t *square, const uint32_t *mat)
+{
+  for (int n = 0; n < 32; n++)
+    square[n] = gf2_matrix_times(mat, mat[n]);
+}
+
+// The lookup tables; they are filled when the library is loaded
+static struct Crc32cTables {
+  Crc32cTables() {
+    // the tables for the byte-wise and the slicing-by-8 algorithm
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t crc = n;
+      for (int k = 0; k < 8; k++)
+        crc = crc & 1 ? (crc >> 1) ^ kPolynomial : crc >> 1;
+      bytes[0][n] = crc;
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t crc = bytes[0][n];
+      for (int k = 1; k < 8; k++) {
+        crc = bytes[0][crc & 0xff] ^ (crc >> 8);
+        bytes[k][n] = crc;
+      }
+    }
+
+    // the operators for shifting a checksum over a block of zeroes
+    fill_zeros(long_zeros, kLongBlock);
+    fill_zeros(short_zeros, kShortBlock);
+  }
+
+  // Creates the operator which appends |len| zero bytes to a checksum;
+  // |len| is a power of two
+  static void zeros_operator(uint32_t *even, size_t len) {
+    uint32_t odd[32];
+
+    // the operator for one zero bit
+    odd[0] = kPolynomial;
+    uint32_t row = 1;
+    for (int n = 1; n < 32; n++) {
+      odd[n] = row;
+      row <<= 1;
+    }
+
+    gf2_matrix_square(even, odd);   // two zero bits
+    gf2_matrix_square(odd, even);   // four zero bits
+
+    // the first square puts the operator for one zero byte in |even|
+    do {
+      gf2_matrix_square(even, odd);
+      len >>= 1;
+      if (len == 0)
+        return;
+      gf2_matrix_square(odd, even);
+      len >>= 1;
+    } while (len);
+
+    ::memcpy(even, odd, sizeof(odd));
+  }
+
+  // Fills a table for shifting a checksum over |len| zero bytes
+  static void fill_zeros(uint32_t zeros[][256], size_t len) {
+    uint32_t op[32];
+    zeros_operator(op, len);
+    for (uint32_t n = 0; n < 256; n++) {
+      zeros[0][n] = gf2_matrix_times(op, n);
+      zeros[1][n] = gf2_matrix_times(op, n << 8);
+      zeros[2][n] = gf2_matrix_times(op, n << 16);
+      zeros[3][n] = gf2_matrix_times(op, n << 24);
+    }
+  }
+
+  uint32_t bytes[8][256];
+  uint32_t long_zeros[4][256];
+  uint32_t short_zeros[4][256];
+} tables;
+
+uint32_t
+crc32c_software(const void *data, size_t len, uint32_t crc)
+{
+  const uint8_t *p = (const uint8_t *)data;
+  crc = ~crc;
+
+  while (len && ((uintptr_t)p & 7) != 0) {
+    crc = tables.bytes[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    len--;
+  }
+
+  while (len >= 8) {
+    uint32_t lo = crc ^ ((uint32_t)p[0] | (uint32_t)p[1] << 8
+                    | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+    uint32_t hi = (uint32_t)p[4] | (uint32_t)p[5] << 8
+                    | (uint32_t)p[6] << 16 | (uint32_t)p[7] << 24;
+    crc = tables.bytes[7][lo & 0xff] ^ tables.bytes[6][(lo >> 8) & 0xff]
+        ^ tables.bytes[5][(lo >> 16) & 0xff] ^ tables.bytes[4][lo >> 24]
+        ^ tables.bytes[3][hi & 0xff] ^ tables.bytes[2][(hi >> 8) & 0xff]
+        ^ tables.bytes[1][(hi >> 16) & 0xff] ^ tables.bytes[0][hi >> 24];
+    p += 8;
+    len -= 8;
+  }
+
+  while (len) {
+    crc = tables.bytes[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    len--;
+  }
+
+  return ~crc;
+}
+
+#ifdef UPS_CRC32C_SSE42
+
+// Applies |zeros| to |crc|
+static inline uint32_t
+shift(const uint32_t zeros[][256], uint32_t crc)
+{
+  return zeros[0][crc & 0xff] ^ zeros[1][(crc >> 8) & 0xff]
+      ^ zeros[2][(crc >> 16) & 0xff] ^ zeros[3][crc >> 24];
+}
+
+// Calculates the checksums of three adjacent blocks of |block| bytes in
+// parallel, then combines them; returns the new checksum
+__attribute__((target("sse4.2")))
+static inline uint64_t
+interleave(const uint8_t *&p, uint64_t crc0, size_t block,
+                const uint32_t zeros[][256])
+{
+  uint64_t crc1 = 0;
+  uint64_t crc2 = 0;
+  const uint8_t *end = p + block;
+  do {
+    uint64_t w0, w1, w2;
+    ::memcpy(&w0, p, 8);
+    ::memcpy(&w1, p + block, 8);
+    ::memcpy(&w2, p + 2 * block, 8);
+    crc0 = _mm_crc32_u64(crc0, w0);
+    crc1 = _mm_crc32_u64(crc1, w1);
+    crc2 = _mm_crc32_u64(crc2, w2);
+    p += 8;
+  } while (p < end);
+
+  crc0 = shift(zeros, (uint32_t)crc0) ^ crc1;
+  crc0 = shift(zeros, (uint32_t)crc0) ^ crc2;
+  p += 2 * block;
+  return crc0;
+}
+
+__attribute__((target("sse4.2")))
+static uint32_t
+crc32c_hardware(const void *data, size_t len, uint32_t crc)
+{
+  const uint8_t *p = (const uint8_t *)data;
+  uint64_t crc0 = ~crc;
+
+  while (len && ((uintptr_t)p & 7) != 0) {
+    crc0 = _mm_crc32_u8((uint32_t)crc0, *p++);
+    len--;
+  }
+
+  while (len >= 3 * kLongBlock) {
+    crc0 = interleave(p, crc0, kLongBlock, tables.long_zeros);
+    len -= 3 * kLongBlock;
+  }
+
+  while (len >= 3 * kShortBlock) {
+    crc0 = interleave(p, crc0, kShortBlock, tables.short_zeros);
+    len -= 3 * kShortBlock;
+  }
+
+  while (len >= 8) {
+    uint64_t w;
+    ::memcpy(&w, p, 8);
+    crc0 = _mm_crc32_u64(crc0, w);
+    p += 8;
+    len -= 8;
+  }
+
+  while (len) {
+    crc0 = _mm_crc32_u8((uint32_t)crc0, *p++);
+    len--;
+  }
+
+  return ~(uint32_t)crc0;
+}
+
+bool
+crc32c_is_hardware_accelerated()
+{
+  static bool available = __builtin_cpu_supports("sse4.2");
+  return available;
+}
+
+uint32_t
+crc32c(const void *data, size_t len, uint32_t crc)
+{
+  if (crc32c_is_hardware_accelerated())
+    return crc32c_hardware(data, len, crc);
+  return crc32c_software(data, len, crc);
+}
+
+#else // !UPS_CRC32C_SSE42
+
+bool
+crc32c_is_hardware_accelerated()
+{
+  return false;
+}
+
+uint32_t
+crc32c(const void *data, size_t len, uint32_t crc)
+{
+  return crc32c_software(data, len, crc);
+}
+
+#endif // UPS_CRC32C_SSE42
+
+} // namespace upscaledb
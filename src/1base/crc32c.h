@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * CRC32C (Castagnoli) checksums (see UPS_PARAM_CRC32_ALGORITHM)
+ *
+ * If the CPU supports SSE4.2 (checked at runtime) then the crc32
+ * instruction is used. Large buffers are split into three blocks which
+ * are processed in an interleaved loop, hiding the latency of the
+ * instruction; the three partial checksums are then combined with
+ * precomputed tables. Otherwise a table-driven implementation
+ * ("slicing-by-8") is used. Both return the same results.
+ *
+ * @exception_safe: nothrow
+ * @thread_safe: yes
+ */
+
+#ifndef UPS_CRC32C_H
+#define UPS_CRC32C_H
+
+#include "0root/root.h"
+
+#include <stddef.h>
+
+// Always verify that a file of level N does not include headers > N!
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+// Returns the CRC32C of |len| bytes at |data|; |crc| is the checksum of
+// the preceding data (or a seed)
+extern uint32_t
+crc32c(const void *data, size_t len, uint32_t crc = 0);
+
+// The table-driven implementation; returns the same results as crc32c()
+extern uint32_t
+crc32c_software(const void *data, size_t len, uint32_t crc = 0);
+
+// Returns true if the CPU supports the crc32 instruction
+extern bool
+crc32c_is_hardware_accelerated();
+
+} // namespace upscaledb
+
+#endif /* UPS_CRC32C_H */
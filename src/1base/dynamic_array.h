@@ -27,6 +27,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
 
 // Always verify that a file of level N does not include headers > N!
 #include "1mem/mem.h"
@@ -72,6 +73,12 @@ struct DynamicArray {
     other.clear();
   }
 
+  void swap(DynamicArray &other) {
+    std::swap(_ptr, other._ptr);
+    std::swap(_size, other._size);
+    std::swap(_own, other._own);
+  }
+
   size_t append(const T *ptr, size_t size) {
     size_t old_size = _size;
     T *p = (T *)resize(_size + size);
@@ -126,6 +126,7 @@ struct IntrusiveList
         else
         {
             tail_->list_node.next[ I ] = t;
+            t->list_node.previous[ I ] = tail_;
             tail_ = t;
             if( !head_ )
             {
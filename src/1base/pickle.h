@@ -111,6 +111,36 @@ struct Pickle {
     // last assignment is without *= 10
     return ret + *p;
   }
+
+  /* encodes a uint64 number as a varint (7 bits per byte; the high bit is
+   * set if more bytes follow) and stores it in |p|; returns the number of
+   * bytes used (at most |kMaxVarintSize|) */
+  static size_t encode_varint(uint8_t *p, uint64_t n) {
+    size_t len = 0;
+    while (n >= 0x80) {
+      p[len++] = (uint8_t)(n | 0x80);
+      n >>= 7;
+    }
+    p[len++] = (uint8_t)n;
+    return len;
+  }
+
+  /* decodes a varint from |p| and stores it in |n|; returns the number of
+   * bytes which were consumed */
+  static size_t decode_varint(const uint8_t *p, uint64_t *n) {
+    uint64_t ret = 0;
+    size_t len = 0;
+    int shift = 0;
+    do {
+      ret |= (uint64_t)(p[len] & 0x7f) << shift;
+      shift += 7;
+    } while (p[len++] & 0x80);
+    *n = ret;
+    return len;
+  }
+
+  /* the maximum size of an encoded varint */
+  enum { kMaxVarintSize = 10 };
 };
 
 } // namespace upscaledb
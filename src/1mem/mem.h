@@ -75,6 +75,26 @@ struct Memory {
     return t;
   }
 
+  // allocates |size| bytes, aligned to |alignment| (a power of two);
+  // the memory is released with release().
+  // usage:
+  //
+  //     uint8_t *p = Memory::allocate_aligned<uint8_t>(16384, 4096);
+  //
+  template<typename T>
+  static T *allocate_aligned(size_t size, size_t alignment) {
+    ms_total_allocations++;
+    ms_current_allocations++;
+    void *t = 0;
+#ifdef UPS_USE_TCMALLOC
+    if (unlikely(::tc_posix_memalign(&t, alignment, size) != 0))
+#else
+    if (unlikely(::posix_memalign(&t, alignment, size) != 0))
+#endif
+      throw Exception(UPS_OUT_OF_MEMORY);
+    return (T *)t;
+  }
+
   // allocates |size| bytes; returns null if out of memory. initializes
   // the allocated memory with zeroes.
   // usage:
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+#include "0root/root.h"
+
+#include <sys/mman.h>
+
+#include "ups/upscaledb_int.h"
+
+// Always verify that a file of level N does not include headers > N!
+#include "1mem/page_arena.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+PageArena::PageArena(size_t slot_size_, uint64_t capacity_bytes,
+                bool use_huge_pages_)
+  : slot_size(slot_size_), use_huge_pages(use_huge_pages_), base(0),
+    reserved(0), mapping(0), mapping_size(0), free_head(0),
+    committed_chunks(0), hugetlb_chunks(0), thp_chunks(0), used_slots(0)
+{
+  chunk_size = (slot_size + kChunkSize - 1) / kChunkSize * kChunkSize;
+  slots_per_chunk = chunk_size / slot_size;
+
+  // the slot index must fit into 32 bits
+  uint64_t max_chunks = 0xfffffffeull / slots_per_chunk;
+  uint64_t chunks = (capacity_bytes + chunk_size - 1) / chunk_size;
+  if (chunks > max_chunks)
+    chunks = max_chunks;
+
+  // reserve the address range; try smaller ranges if this fails. The
+  // range is over-allocated by one chunk to align it to the chunk size.
+  for (; chunks > 0; chunks /= 2) {
+    size_t size = (size_t)(chunks + 1) * chunk_size;
+    void *p = ::mmap(0, size, PROT_NONE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED)
+      continue;
+    mapping = (uint8_t *)p;
+    mapping_size = size;
+    base = (uint8_t *)(((uintptr_t)p + kChunkSize - 1)
+                    & ~((uintptr_t)kChunkSize - 1));
+    reserved = (size_t)chunks * chunk_size;
+    break;
+  }
+}
+
+PageArena::~PageArena()
+{
+  if (mapping)
+    ::munmap(mapping, mapping_size);
+}
+
+void *
+PageArena::allocate()
+{
+  uint64_t head = free_head.load(boost::memory_order_acquire);
+  while (true) {
+    uint32_t index = (uint32_t)head;
+    if (index == 0) {
+      if (!grow())
+        return 0;
+      head = free_head.load(boost::memory_order_acquire);
+      continue;
+    }
+
+    // the slot might be popped concurrently by another thread, therefore
+    // |next| can be garbage; then the tag of |free_head| was modified and
+    // the CAS fails
+    uint32_t next = *(volatile uint32_t *)slot(index);
+    uint64_t new_head = (((head >> 32) + 1) << 32) | next;
+    if (free_head.compare_exchange_weak(head, new_head,
+                            boost::memory_order_acq_rel)) {
+      used_slots++;
+      return slot(index);
+    }
+  }
+}
+
+void
+PageArena::release(void *p)
+{
+  if (unlikely(p == 0))
+    return;
+  assert(owns(p));
+
+  size_t offset = (uint8_t *)p - base;
+  uint32_t index = (uint32_t)((offset / chunk_size) * slots_per_chunk
+                          + (offset % chunk_size) / slot_size + 1);
+
+  uint64_t head = free_head.load(boost::memory_order_acquire);
+  uint64_t new_head;
+  do {
+    *(uint32_t *)p = (uint32_t)head;
+    new_head = (((head >> 32) + 1) << 32) | index;
+  } while (!free_head.compare_exchange_weak(head, new_head,
+                          boost::memory_order_acq_rel));
+  used_slots--;
+}
+
+bool
+PageArena::grow()
+{
+  ScopedSpinlock lock(mutex);
+
+  // another thread already added free slots?
+  if ((uint32_t)free_head.load(boost::memory_order_acquire) != 0)
+    return true;
+
+  size_t n = committed_chunks;
+  if ((n + 1) * chunk_size > reserved)
+    return false;
+
+  uint8_t *p = base + n * chunk_size;
+  bool is_committed = false;
+#ifdef MAP_HUGETLB
+  if (use_huge_pages
+        && ::mmap(p, chunk_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB,
+                -1, 0) == p) {
+    is_committed = true;
+    hugetlb_chunks++;
+  }
+#endif
+  if (!is_committed) {
+    if (::mmap(p, chunk_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != p)
+      return false;
+#ifdef MADV_HUGEPAGE
+    if (use_huge_pages && ::madvise(p, chunk_size, MADV_HUGEPAGE) == 0)
+      thp_chunks++;
+#endif
+  }
+
+  // link the new slots, then push them on the stack
+  uint32_t first = (uint32_t)(n * slots_per_chunk + 1);
+  uint32_t last = (uint32_t)(first + slots_per_chunk - 1);
+  for (uint32_t i = first; i < last; i++)
+    *(uint32_t *)slot(i) = i + 1;
+  committed_chunks = n + 1;
+
+  uint64_t head = free_head.load(boost::memory_order_acquire);
+  uint64_t new_head;
+  do {
+    *(uint32_t *)slot(last) = (uint32_t)head;
+    new_head = (((head >> 32) + 1) << 32) | first;
+  } while (!free_head.compare_exchange_weak(head, new_head,
+                          boost::memory_order_acq_rel));
+  return true;
+}
+
+void
+PageArena::fill_metrics(ups_env_metrics_t *metrics) const
+{
+  metrics->page_arena_committed_bytes = committed_chunks * chunk_size;
+  metrics->page_arena_used_bytes = used_slots * slot_size;
+  metrics->page_arena_hugetlb_bytes = hugetlb_chunks * chunk_size;
+  metrics->page_arena_thp_bytes = thp_chunks * chunk_size;
+}
+
+} // namespace upscaledb
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * An arena for page buffers
+ *
+ * Reserves a large range of virtual memory when it is created, and
+ * commits it in chunks of 2 MB whenever more buffers are required. Each
+ * chunk is carved into slots of the page size. Unused slots are kept in a
+ * lock-free stack; the "next" index of a free slot is stored in the slot
+ * itself, and the head of the stack is tagged with a counter to avoid the
+ * ABA problem.
+ *
+ * Optionally the chunks are backed by huge pages (MAP_HUGETLB). If no huge
+ * pages are available then the kernel is asked to use transparent huge
+ * pages instead (MADV_HUGEPAGE).
+ *
+ * Memory is returned to the operating system when the arena is destroyed.
+ * If the reserved range is exhausted then allocate() returns null, and the
+ * caller falls back to the heap.
+ *
+ * @exception_safe: nothrow
+ * @thread_safe: yes
+ */
+
+#ifndef UPS_PAGE_ARENA_H
+#define UPS_PAGE_ARENA_H
+
+#include "0root/root.h"
+
+#include <boost/atomic.hpp>
+
+// Always verify that a file of level N does not include headers > N!
+#include "1base/spinlock.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+struct ups_env_metrics_t;
+
+namespace upscaledb {
+
+struct PageArena
+{
+  enum {
+    // The size of a chunk; a multiple of the huge page size
+    kChunkSize = 2 * 1024 * 1024
+  };
+
+  // Constructor; reserves (but does not commit) |capacity_bytes| of
+  // virtual memory for buffers of |slot_size| bytes
+  PageArena(size_t slot_size, uint64_t capacity_bytes, bool use_huge_pages);
+
+  // Destructor; releases all memory
+  ~PageArena();
+
+  // Returns a buffer of |slot_size| bytes, or null if the arena is
+  // exhausted
+  void *allocate();
+
+  // Returns a buffer to the arena; can deal with NULL pointers
+  void release(void *p);
+
+  // Returns true if |p| was allocated by this arena
+  bool owns(const void *p) const {
+    return (const uint8_t *)p >= base && (const uint8_t *)p < base + reserved;
+  }
+
+  // Fills in the current metrics
+  void fill_metrics(ups_env_metrics_t *metrics) const;
+
+  // Commits the next chunk and pushes its slots on the free stack;
+  // returns false if the reserved range is exhausted
+  bool grow();
+
+  // Returns the slot with the (1-based) |index|
+  uint8_t *slot(uint32_t index) const {
+    index--;
+    return base + (size_t)(index / slots_per_chunk) * chunk_size
+                + (size_t)(index % slots_per_chunk) * slot_size;
+  }
+
+  // The size of each buffer
+  size_t slot_size;
+
+  // The size of each chunk
+  size_t chunk_size;
+
+  // The number of slots per chunk
+  size_t slots_per_chunk;
+
+  // Try to use huge pages?
+  bool use_huge_pages;
+
+  // The start of the reserved range (aligned to |kChunkSize|)
+  uint8_t *base;
+
+  // The size of the reserved range, in bytes
+  size_t reserved;
+
+  // The start and size of the mapping (incl. the alignment overhead)
+  uint8_t *mapping;
+  size_t mapping_size;
+
+  // Serializes grow()
+  Spinlock mutex;
+
+  // Head of the free stack: the upper 32 bits are a tag, the lower 32 bits
+  // are the (1-based) index of the first free slot; 0 if the stack is empty
+  boost::atomic<uint64_t> free_head;
+
+  // The number of committed chunks
+  boost::atomic<size_t> committed_chunks;
+
+  // The number of chunks backed by MAP_HUGETLB
+  boost::atomic<size_t> hugetlb_chunks;
+
+  // The number of chunks advised to use transparent huge pages
+  boost::atomic<size_t> thp_chunks;
+
+  // The number of slots which are currently in use
+  boost::atomic<size_t> used_slots;
+};
+
+} // namespace upscaledb
+
+#endif // UPS_PAGE_ARENA_H
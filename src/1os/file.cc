@@ -7,6 +7,12 @@
 #include <sys/file.h>
 #include <unistd.h>
 #include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <memory>
+#include <algorithm>
 
 #include "file.h"
 #include "1errorinducer/errorinducer.h"
@@ -25,12 +31,34 @@ namespace upscaledb {
 #  define os_log(x)
 #endif
 
+//
+// Returns true if the request can be performed with direct I/O
+//
+static inline bool is_aligned( uint64_t addr, const void *buffer, size_t len )
+{
+    return ( ( addr | (uintptr_t)buffer | len ) & ( File::kDirectIoAlignment - 1 ) ) == 0;
+}
+
+//
+// Allocates an aligned bounce buffer for direct I/O
+//
+static std::unique_ptr< uint8_t, void (*)( void * ) > allocate_aligned( size_t len )
+{
+    void *p = nullptr;
+    if( ::posix_memalign( &p, File::kDirectIoAlignment, len ) != 0 )
+    {
+        throw Exception( UPS_OUT_OF_MEMORY );
+    }
+    return std::unique_ptr< uint8_t, void (*)( void * ) >( (uint8_t *)p, ::free );
+}
+
 //
 // Constructor: creates an empty File handle
 //
 File::File()
     : m_fd( UPS_INVALID_FD )
     , m_posix_advice( 0 )
+    , m_direct_io( false )
 {
 }
 
@@ -40,8 +68,10 @@ File::File()
 File::File( File&& other )
     : m_fd( other.m_fd )
     , m_posix_advice( other.m_posix_advice )
+    , m_direct_io( other.m_direct_io )
 {
     other.m_fd = UPS_INVALID_FD;
+    other.m_direct_io = false;
 }
 
 //
@@ -50,7 +80,9 @@ File::File( File&& other )
 File& File::operator=( File&& other )
 {
     m_fd = other.m_fd;
+    m_direct_io = other.m_direct_io;
     other.m_fd = UPS_INVALID_FD;
+    other.m_direct_io = false;
     return *this;
 }
 
@@ -71,6 +103,44 @@ bool File::is_open() const
     return m_fd != UPS_INVALID_FD;
 }
 
+//
+// Returns the file descriptor; used for asynchronous I/O
+//
+int File::descriptor() const
+{
+    return m_fd;
+}
+
+//
+// Bypasses the page cache (O_DIRECT); returns false if the file system
+// does not support direct I/O
+//
+bool File::enable_direct_io()
+{
+    assert( m_fd != UPS_INVALID_FD );
+
+#ifdef O_DIRECT
+    const int flags = ::fcntl( m_fd, F_GETFL );
+    if( flags == -1 || ::fcntl( m_fd, F_SETFL, flags | O_DIRECT ) == -1 )
+    {
+        ups_log(("O_DIRECT failed with status %u (%s), falling back to buffered I/O", errno, strerror(errno)));
+        return false;
+    }
+    m_direct_io = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+//
+// Returns true if the page cache is bypassed
+//
+bool File::is_direct_io() const
+{
+    return m_direct_io;
+}
+
 //
 //
 //
@@ -192,6 +262,35 @@ void File::set_posix_advice( uint32_t advice )
 
 }
 
+//
+// Passes a hint for a range of the file to posix_fadvise(); errors are
+// ignored
+//
+void File::advise( uint64_t offset, uint64_t len, int advice ) const
+{
+    os_log(("File::advise: fd=%d, offset=%lld, size=%lld, advice=%d", m_fd, offset, len, advice));
+
+    const int r = ::posix_fadvise( m_fd, offset, len, advice );
+    if( r != 0 )
+    {
+        os_log(("posix_fadvise failed with status %d (%s)", r, strerror(r)));
+    }
+}
+
+//
+// Passes a hint for a range of mapped memory to madvise(); errors are
+// ignored
+//
+void File::advise_memory( void *buffer, size_t len, int advice )
+{
+    os_log(("File::advise_memory: size=%lld, advice=%d", len, advice));
+
+    if( ::madvise( buffer, len, advice ) != 0 )
+    {
+        os_log(("madvise failed with status %d (%s)", errno, strerror(errno)));
+    }
+}
+
 //
 // Maps a file in memory
 //
@@ -230,6 +329,55 @@ void File::mmap(uint64_t position, size_t size, bool readonly, uint8_t **buffer)
 
 }
 
+//
+// Maps a range of the file at a fixed address |buffer|, which was
+// reserved with reserve(); replaces the previous mapping of this range
+//
+void File::mmap_fixed( uint64_t position, size_t size, bool readonly, uint8_t *buffer ) const
+{
+    os_log(("File::mmap_fixed: fd=%d, position=%lld, size=%lld", m_fd, position, size));
+
+    UPS_INDUCE_ERROR( ErrorInducer::kFileMmap );
+
+    int prot = PROT_READ;
+    if( !readonly )
+        prot |= PROT_WRITE;
+
+    if( ::mmap( buffer, size, prot, MAP_PRIVATE | MAP_FIXED, m_fd, position ) == MAP_FAILED )
+    {
+        ups_log(("mmap failed with status %d (%s)", errno, strerror(errno)));
+        throw Exception( UPS_IO_ERROR );
+    }
+
+    if( m_posix_advice == EnvConfig::UPS_POSIX_FADVICE_RANDOM )
+    {
+        const int r = ::madvise( buffer, size, MADV_RANDOM );
+        if( r != 0 )
+        {
+            ups_log(("madvise failed with status %d (%s)", errno, strerror(errno)));
+            throw Exception( UPS_IO_ERROR );
+        }
+    }
+}
+
+//
+// Reserves a range of the address space without committing memory;
+// parts of the file are later mapped into it with mmap_fixed(). The
+// range is released with munmap().
+//
+void File::reserve( size_t size, uint8_t **buffer )
+{
+    os_log(("File::reserve: size=%lld", size));
+
+    *buffer = (uint8_t *)::mmap( 0, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+    if( *buffer == MAP_FAILED )
+    {
+        *buffer = nullptr;
+        ups_log(("mmap failed with status %d (%s)", errno, strerror(errno)));
+        throw Exception( UPS_IO_ERROR );
+    }
+}
+
 //
 // Unmaps a buffer
 //
@@ -253,6 +401,12 @@ void File::pread(uint64_t addr, void *buffer, size_t len) const
 {
     os_log(("File::pread: fd=%d, address=%lld, size=%lld", m_fd, addr, len));
 
+    if( m_direct_io && !is_aligned( addr, buffer, len ) )
+    {
+        pread_unaligned( addr, buffer, len );
+        return;
+    }
+
     size_t total = 0;
 
     while( total < len )
@@ -286,11 +440,17 @@ void File::pwrite( uint64_t addr, const void *buffer, size_t len ) const
 {
     os_log(("File::pwrite: fd=%d, address=%lld, size=%lld", m_fd, addr, len));
 
+    if( m_direct_io && !is_aligned( addr, buffer, len ) )
+    {
+        pwrite_unaligned( addr, buffer, len );
+        return;
+    }
+
     size_t total = 0;
 
     while( total < len )
     {
-        const ssize_t s = ::pwrite( m_fd, buffer, len, addr + total );
+        const ssize_t s = ::pwrite( m_fd, (const uint8_t *)buffer + total, len - total, addr + total );
         if (s < 0)
         {
             ups_log(("pwrite() failed with status %u (%s)", errno, strerror(errno)));
@@ -312,6 +472,144 @@ void File::pwrite( uint64_t addr, const void *buffer, size_t len ) const
     }
 }
 
+//
+// Positional write of several buffers to a file; the buffers are written
+// to adjacent file positions
+//
+void File::pwritev( uint64_t addr, const struct iovec *iov, size_t count ) const
+{
+    os_log(("File::pwritev: fd=%d, address=%lld, count=%lld", m_fd, addr, count));
+
+    // with direct I/O, unaligned buffers are written one by one
+    if( m_direct_io )
+    {
+        bool aligned = is_aligned( addr, nullptr, 0 );
+        for( size_t i = 0; aligned && i < count; i++ )
+        {
+            aligned = is_aligned( 0, iov[i].iov_base, iov[i].iov_len );
+        }
+
+        if( !aligned )
+        {
+            for( size_t i = 0; i < count; i++ )
+            {
+                pwrite( addr, iov[i].iov_base, iov[i].iov_len );
+                addr += iov[i].iov_len;
+            }
+            return;
+        }
+    }
+
+    // the vector is modified if a write was incomplete
+    std::vector< struct iovec > v( iov, iov + count );
+    size_t index = 0;
+
+    while( index < count )
+    {
+        const int n = (int)std::min< size_t >( count - index, IOV_MAX );
+        const ssize_t s = ::pwritev( m_fd, &v[index], n, addr );
+        if( s < 0 )
+        {
+            ups_log(("pwritev() failed with status %u (%s)", errno, strerror(errno)));
+            throw Exception( UPS_IO_ERROR );
+        }
+
+        if( s == 0 )
+        {
+            ups_log(("pwritev() failed with short write"));
+            throw Exception( UPS_IO_ERROR );
+        }
+
+        addr += s;
+
+        // skip the buffers which were written completely
+        size_t written = (size_t)s;
+        while( index < count && written >= v[index].iov_len )
+        {
+            written -= v[index].iov_len;
+            index++;
+        }
+
+        if( written > 0 )
+        {
+            v[index].iov_base = (uint8_t *)v[index].iov_base + written;
+            v[index].iov_len -= written;
+        }
+    }
+}
+
+//
+// Reads the aligned range of |size| bytes at |begin| into |bounce|; the
+// last block can be incomplete if it is at the end of the file. Returns
+// the number of bytes read.
+//
+static size_t pread_blocks( int fd, uint8_t *bounce, size_t size, uint64_t begin )
+{
+    size_t total = 0;
+    while( total < size )
+    {
+        const ssize_t r = ::pread( fd, bounce + total, size - total, begin + total );
+        if( r < 0 )
+        {
+            ups_log(("File::pread failed with status %u (%s)", errno, strerror(errno)));
+            throw Exception( UPS_IO_ERROR );
+        }
+
+        if( r == 0 )
+        {
+            break;
+        }
+
+        total += r;
+    }
+    return total;
+}
+
+//
+// Positional read with direct I/O if the request is not aligned; reads the
+// enclosing blocks into a bounce buffer
+//
+void File::pread_unaligned( uint64_t addr, void *buffer, size_t len ) const
+{
+    const uint64_t begin = addr & ~( (uint64_t)kDirectIoAlignment - 1 );
+    const uint64_t end = ( addr + len + kDirectIoAlignment - 1 ) & ~( (uint64_t)kDirectIoAlignment - 1 );
+    const size_t size = (size_t)( end - begin );
+    std::unique_ptr< uint8_t, void (*)( void * ) > bounce = allocate_aligned( size );
+
+    if( pread_blocks( m_fd, bounce.get(), size, begin ) < addr - begin + len )
+    {
+        ups_log(("File::pread() failed with short read"));
+        throw Exception( UPS_IO_ERROR );
+    }
+
+    ::memcpy( buffer, bounce.get() + ( addr - begin ), len );
+}
+
+//
+// Positional write with direct I/O if the request is not aligned; reads
+// the enclosing blocks into a bounce buffer, modifies and writes them.
+// Then the file is truncated if the last block was written beyond its end.
+//
+void File::pwrite_unaligned( uint64_t addr, const void *buffer, size_t len ) const
+{
+    const uint64_t begin = addr & ~( (uint64_t)kDirectIoAlignment - 1 );
+    const uint64_t end = ( addr + len + kDirectIoAlignment - 1 ) & ~( (uint64_t)kDirectIoAlignment - 1 );
+    const size_t size = (size_t)( end - begin );
+    std::unique_ptr< uint8_t, void (*)( void * ) > bounce = allocate_aligned( size );
+
+    const uint64_t old_size = file_size();
+    const size_t total = pread_blocks( m_fd, bounce.get(), size, begin );
+    ::memset( bounce.get() + total, 0, size - total );
+
+    ::memcpy( bounce.get() + ( addr - begin ), buffer, len );
+    pwrite( begin, bounce.get(), size );
+
+    if( end > old_size )
+    {
+        truncate( std::max< uint64_t >( old_size, addr + len ) );
+    }
+}
+
 //
 // Write data to a file; uses the current file position
 //
@@ -382,6 +680,24 @@ void File::truncate( uint64_t newsize ) const
     }
 }
 
+//
+// Reserves disk space for a range of the file without changing the
+// file size; returns false if the file system does not support this
+//
+bool File::allocate( uint64_t offset, uint64_t len ) const
+{
+    os_log(("File::allocate: fd=%d, offset=%lld, size=%lld", m_fd, offset, len));
+
+#ifdef FALLOC_FL_KEEP_SIZE
+    if( ::fallocate( m_fd, FALLOC_FL_KEEP_SIZE, offset, len ) == 0 )
+    {
+        return true;
+    }
+    ups_log(("fallocate failed with status %u (%s)", errno, strerror(errno)));
+#endif
+    return false;
+}
+
 //
 // Creates a new file
 //
@@ -468,6 +784,7 @@ void File::close()
     }
 
     m_fd = UPS_INVALID_FD;
+    m_direct_io = false;
 }
 
 
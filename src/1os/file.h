@@ -19,6 +19,11 @@
 /*
  * A simple wrapper around a file handle. Throws exceptions in
  * case of errors. Moves the file handle when copied.
+ *
+ * With direct I/O (O_DIRECT) the kernel's page cache is bypassed. Then
+ * the buffers, file offsets and lengths must be aligned to
+ * |kDirectIoAlignment|; unaligned requests are copied through an aligned
+ * bounce buffer (writes read, modify and write the affected blocks).
  */
 
 #ifndef UPS_FILE_H
@@ -26,6 +31,8 @@
 
 #include "0root/root.h"
 
+#include <sys/uio.h>
+
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
 #endif
@@ -35,6 +42,12 @@ namespace upscaledb {
 class File
 {
 public:
+    enum
+    {
+        // the alignment of buffers, offsets and lengths for direct I/O
+        kDirectIoAlignment = 4096
+    };
+
     File();
 
     File( File&& other );
@@ -50,16 +63,24 @@ public:
     void close();
 
     bool is_open() const;
+    int descriptor() const;
+
+    bool enable_direct_io();
+    bool is_direct_io() const;
 
     void flush() const;
 
     void set_posix_advice( uint32_t parameter );
+    void advise( uint64_t offset, uint64_t len, int advice ) const;
+    static void advise_memory( void *buffer, size_t len, int advice );
 
     void mmap( uint64_t position, size_t size, bool readonly, uint8_t **buffer ) const;
+    void mmap_fixed( uint64_t position, size_t size, bool readonly, uint8_t *buffer ) const;
     void munmap( void *buffer, size_t size ) const;
 
     void pread( uint64_t addr, void *buffer, size_t len ) const;
     void pwrite( uint64_t addr, const void *buffer, size_t len ) const;
+    void pwritev( uint64_t addr, const struct iovec *iov, size_t count ) const;
     void write( const void *buffer, size_t len ) const;
 
 
@@ -67,21 +88,29 @@ public:
     uint64_t tell() const;
     uint64_t file_size() const;
     void truncate( uint64_t newsize ) const;
+    bool allocate( uint64_t offset, uint64_t len ) const;
 
 
     static size_t granularity();
+    static void reserve( size_t size, uint8_t **buffer );
     static void os_read( int fd, uint8_t *buffer, size_t len );
     static void os_write( int fd, const void *buffer, size_t len );
 
 private:
     static void lock_exclusive( int fd, bool lock );
 
+    void pread_unaligned( uint64_t addr, void *buffer, size_t len ) const;
+    void pwrite_unaligned( uint64_t addr, const void *buffer, size_t len ) const;
+
   private:
     // The file handle
     int m_fd;
 
     // Parameter for posix_fadvise()
     uint32_t m_posix_advice;
+
+    // True if the file was opened with O_DIRECT
+    bool m_direct_io;
 };
 
 } // namespace upscaledb
@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+#include "0root/root.h"
+
+#include <cstring>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+
+#if defined( __linux__ ) && defined( __NR_io_uring_setup )
+#  include <linux/io_uring.h>
+#  define UPS_HAVE_IO_URING 1
+#endif
+
+#include "1base/error.h"
+#include "1os/io_uring.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+//
+// Constructor: creates an inactive ring
+//
+IoUring::IoUring()
+    : m_fd( -1 )
+    , m_sq_ring( nullptr )
+    , m_sq_ring_size( 0 )
+    , m_cq_ring( nullptr )
+    , m_cq_ring_size( 0 )
+    , m_sqes( nullptr )
+    , m_sqes_size( 0 )
+    , m_sq_head( nullptr )
+    , m_sq_tail( nullptr )
+    , m_sq_mask( nullptr )
+    , m_sq_array( nullptr )
+    , m_sq_entries( 0 )
+    , m_cq_head( nullptr )
+    , m_cq_tail( nullptr )
+    , m_cq_mask( nullptr )
+    , m_cqes( nullptr )
+    , m_pending( 0 )
+{
+}
+
+//
+// Destructor: unmaps the rings and closes the ring descriptor
+//
+IoUring::~IoUring()
+{
+    close();
+}
+
+#ifdef UPS_HAVE_IO_URING
+
+//
+// Sets up the ring and maps the submission and completion queues
+//
+bool IoUring::init( unsigned entries )
+{
+    struct io_uring_params params;
+    ::memset( &params, 0, sizeof( params ) );
+
+    m_fd = (int)::syscall( __NR_io_uring_setup, entries, &params );
+    if( m_fd < 0 )
+    {
+        ups_log(("io_uring_setup failed with status %u (%s); using pread",
+                 errno, strerror(errno)));
+        m_fd = -1;
+        return false;
+    }
+
+    m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof( unsigned );
+    m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof( struct io_uring_cqe );
+    const bool single_mmap = ( params.features & IORING_FEAT_SINGLE_MMAP ) != 0;
+    if( single_mmap )
+    {
+        m_sq_ring_size = m_cq_ring_size = std::max( m_sq_ring_size, m_cq_ring_size );
+    }
+
+    m_sq_ring = ::mmap( 0, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        m_fd, IORING_OFF_SQ_RING );
+    if( m_sq_ring == MAP_FAILED )
+    {
+        m_sq_ring = nullptr;
+        close();
+        return false;
+    }
+
+    if( single_mmap )
+    {
+        m_cq_ring = m_sq_ring;
+    }
+    else
+    {
+        m_cq_ring = ::mmap( 0, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            m_fd, IORING_OFF_CQ_RING );
+        if( m_cq_ring == MAP_FAILED )
+        {
+            m_cq_ring = nullptr;
+            close();
+            return false;
+        }
+    }
+
+    m_sqes_size = params.sq_entries * sizeof( struct io_uring_sqe );
+    m_sqes = ::mmap( 0, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     m_fd, IORING_OFF_SQES );
+    if( m_sqes == MAP_FAILED )
+    {
+        m_sqes = nullptr;
+        close();
+        return false;
+    }
+
+    uint8_t *sq = (uint8_t *)m_sq_ring;
+    m_sq_head = (unsigned *)( sq + params.sq_off.head );
+    m_sq_tail = (unsigned *)( sq + params.sq_off.tail );
+    m_sq_mask = (unsigned *)( sq + params.sq_off.ring_mask );
+    m_sq_array = (unsigned *)( sq + params.sq_off.array );
+    m_sq_entries = params.sq_entries;
+
+    uint8_t *cq = (uint8_t *)m_cq_ring;
+    m_cq_head = (unsigned *)( cq + params.cq_off.head );
+    m_cq_tail = (unsigned *)( cq + params.cq_off.tail );
+    m_cq_mask = (unsigned *)( cq + params.cq_off.ring_mask );
+    m_cqes = cq + params.cq_off.cqes;
+    return true;
+}
+
+//
+// Queues a read
+//
+bool IoUring::prepare_read( int fd, void *buffer, unsigned len, uint64_t offset, uint64_t user_data )
+{
+    const unsigned head = __atomic_load_n( m_sq_head, __ATOMIC_ACQUIRE );
+    const unsigned tail = *m_sq_tail;
+    if( tail - head >= m_sq_entries )
+    {
+        return false;
+    }
+
+    const unsigned index = tail & *m_sq_mask;
+    struct io_uring_sqe *sqe = (struct io_uring_sqe *)m_sqes + index;
+    ::memset( sqe, 0, sizeof( *sqe ) );
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)buffer;
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    m_sq_array[ index ] = index;
+
+    // publish the entry to the kernel
+    __atomic_store_n( m_sq_tail, tail + 1, __ATOMIC_RELEASE );
+    m_pending++;
+    return true;
+}
+
+//
+// Submits the queued reads and waits for completions
+//
+void IoUring::submit( unsigned wait_count )
+{
+    // the kernel can consume fewer entries than requested; the
+    // completions of the first call are counted by the following calls
+    do
+    {
+        const int r = (int)::syscall( __NR_io_uring_enter, m_fd, m_pending, wait_count,
+                                      wait_count > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0 );
+        if( r < 0 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+            ups_log(("io_uring_enter failed with status %u (%s)", errno, strerror(errno)));
+            throw Exception( UPS_IO_ERROR );
+        }
+        m_pending -= std::min< unsigned >( m_pending, (unsigned)r );
+    }
+    while( m_pending > 0 );
+}
+
+//
+// Retrieves a completion
+//
+bool IoUring::reap( uint64_t *user_data, int *result )
+{
+    const unsigned head = *m_cq_head;
+    if( head == __atomic_load_n( m_cq_tail, __ATOMIC_ACQUIRE ) )
+    {
+        return false;
+    }
+
+    const struct io_uring_cqe *cqe = (const struct io_uring_cqe *)m_cqes + ( head & *m_cq_mask );
+    *user_data = cqe->user_data;
+    *result = cqe->res;
+    __atomic_store_n( m_cq_head, head + 1, __ATOMIC_RELEASE );
+    return true;
+}
+
+#else // !UPS_HAVE_IO_URING
+
+bool IoUring::init( unsigned )
+{
+    return false;
+}
+
+bool IoUring::prepare_read( int, void *, unsigned, uint64_t, uint64_t )
+{
+    return false;
+}
+
+void IoUring::submit( unsigned )
+{
+}
+
+bool IoUring::reap( uint64_t *, int * )
+{
+    return false;
+}
+
+#endif // UPS_HAVE_IO_URING
+
+//
+// Returns true if the ring was set up
+//
+bool IoUring::is_active() const
+{
+    return m_fd >= 0;
+}
+
+//
+// Returns the number of submission entries
+//
+unsigned IoUring::capacity() const
+{
+    return m_sq_entries;
+}
+
+//
+// Unmaps the rings and closes the descriptor
+//
+void IoUring::close()
+{
+    if( m_sqes )
+    {
+        ::munmap( m_sqes, m_sqes_size );
+    }
+    if( m_cq_ring && m_cq_ring != m_sq_ring )
+    {
+        ::munmap( m_cq_ring, m_cq_ring_size );
+    }
+    if( m_sq_ring )
+    {
+        ::munmap( m_sq_ring, m_sq_ring_size );
+    }
+    if( m_fd >= 0 )
+    {
+        ::close( m_fd );
+    }
+
+    m_fd = -1;
+    m_sq_ring = m_cq_ring = m_sqes = nullptr;
+    m_sq_entries = 0;
+    m_pending = 0;
+}
+
+} // namespace upscaledb
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * A minimal io_uring submission/completion queue for positional reads,
+ * based on the raw system calls (liburing is not required).
+ *
+ * init() returns false if the kernel does not support io_uring (or if it
+ * is blocked, i.e. by a seccomp filter); the caller then falls back to
+ * pread(). Not thread-safe; the caller serializes access.
+ */
+
+#ifndef UPS_IO_URING_H
+#define UPS_IO_URING_H
+
+#include "0root/root.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+class IoUring
+{
+public:
+    IoUring();
+    ~IoUring();
+
+    IoUring( const IoUring& other ) = delete;
+    IoUring& operator=( const IoUring& other ) = delete;
+
+    // Sets up a ring with (at least) |entries| submission entries; returns
+    // false if io_uring is not available
+    bool init( unsigned entries );
+
+    // Returns true if the ring was set up
+    bool is_active() const;
+
+    // Returns the number of submission entries
+    unsigned capacity() const;
+
+    // Queues a read of |len| bytes at |offset| into |buffer|; |user_data| is
+    // returned with the completion. Returns false if the queue is full.
+    bool prepare_read( int fd, void *buffer, unsigned len, uint64_t offset, uint64_t user_data );
+
+    // Submits all queued reads and waits for |wait_count| completions.
+    // Throws on error.
+    void submit( unsigned wait_count );
+
+    // Retrieves a completion; returns false if none is available
+    bool reap( uint64_t *user_data, int *result );
+
+private:
+    void close();
+
+    int m_fd;
+
+    // the mapped rings
+    void *m_sq_ring;
+    size_t m_sq_ring_size;
+    void *m_cq_ring;
+    size_t m_cq_ring_size;
+    void *m_sqes;
+    size_t m_sqes_size;
+
+    // pointers into the submission ring
+    unsigned *m_sq_head;
+    unsigned *m_sq_tail;
+    unsigned *m_sq_mask;
+    unsigned *m_sq_array;
+    unsigned m_sq_entries;
+
+    // pointers into the completion ring
+    unsigned *m_cq_head;
+    unsigned *m_cq_tail;
+    unsigned *m_cq_mask;
+    void *m_cqes;
+
+    // the number of queued, but not yet submitted reads
+    unsigned m_pending;
+};
+
+} // namespace upscaledb
+
+#endif /* UPS_IO_URING_H */
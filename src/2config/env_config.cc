@@ -27,6 +27,24 @@ EnvConfig::EnvConfig()
     , is_encryption_enabled( false )
     , journal_switch_threshold( 0 )
     , posix_advice( UPS_POSIX_FADVICE_NORMAL )
+    , cache_shards( 1 )
+    , cache_policy( 0 )
+    , cache_internal_nodes( 0 )
+    , cache_warmup_pages( 0 )
+    , page_arena( 0 )
+    , cache_sampling( 0 )
+    , flush_threads( 1 )
+    , io_backend( 0 )
+    , file_extent_size( 0 )
+    , stripe_size( UPS_DEFAULT_PAGE_SIZE )
+    , crc32_algorithm( 0 )
+    , page_compressor( 0 )
+    , group_commit_delay_usec( 0 )
+    , group_commit_size( 32 )
+    , journal_writer_thread( false )
+    , recovery_threads( 1 )
+    , checkpoint_interval_sec( 0 )
+    , checkpoint_size( 0 )
 {
 }
 
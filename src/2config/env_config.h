@@ -77,6 +77,69 @@ struct EnvConfig
     // parameter for posix_fadvise()
     uint32_t posix_advice;
 
+    // the number of cache shards
+    uint32_t cache_shards;
+
+    // the replacement policy of the cache
+    uint32_t cache_policy;
+
+    // the part of the cache (in percent) reserved for internal btree nodes
+    uint32_t cache_internal_nodes;
+
+    // the number of recently used pages which are recorded for warming
+    // up the cache when the Environment is opened again; 0 disables this
+    uint32_t cache_warmup_pages;
+
+    // how page buffers are allocated (UPS_PAGE_ARENA_DISABLED,
+    // UPS_PAGE_ARENA_ENABLED or UPS_PAGE_ARENA_HUGE_PAGES)
+    uint32_t page_arena;
+
+    // the sampling rate (in 1/1000) for estimating the hit ratio of the
+    // cache at different sizes; 0 disables the sampling
+    uint32_t cache_sampling;
+
+    // the number of threads which flush dirty pages
+    uint32_t flush_threads;
+
+    // the backend for reading pages (UPS_IO_BACKEND_*)
+    uint32_t io_backend;
+
+    // the size of the extents which are reserved with fallocate() when
+    // the file grows; 0 disables the reservation
+    uint64_t file_extent_size;
+
+    // additional files across which the Environment is striped,
+    // separated by ';'
+    std::string stripe_paths;
+
+    // the size of a stripe (in bytes)
+    uint64_t stripe_size;
+
+    // the algorithm of the page checksums (UPS_CRC32_*)
+    uint32_t crc32_algorithm;
+
+    // the algorithm for page compression; 0 if disabled
+    int page_compressor;
+
+    // the maximum time (in microseconds) a commit waits for other commits
+    // before the journal is synced
+    uint32_t group_commit_delay_usec;
+
+    // the number of waiting commits which ends this delay
+    uint32_t group_commit_size;
+
+    // true if the journal is written by a background thread
+    bool journal_writer_thread;
+
+    // the number of threads for the recovery
+    uint32_t recovery_threads;
+
+    // the interval (in seconds) of the automatic checkpoints; 0 if disabled
+    uint32_t checkpoint_interval_sec;
+
+    // the number of journal bytes which trigger a checkpoint; 0 if disabled
+    uint64_t checkpoint_size;
+
 public:
     // the default cache size is 2 MB
     static const uint64_t UPS_DEFAULT_CACHE_SIZE;
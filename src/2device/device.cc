@@ -0,0 +1,129 @@
+#include "device.h"
+#include <algorithm>
+#include "ups/upscaledb_int.h"
+#include "1mem/mem.h"
+#include "1os/file.h"
+#include "2page/page.h"
+
+namespace upscaledb {
+
+//
+// Returns the page arena, or null if it is disabled
+//
+PageArena* Device::page_arena() const
+{
+    if( config.page_arena == UPS_PAGE_ARENA_DISABLED )
+    {
+        return nullptr;
+    }
+
+    std::call_once( arena_flag_, [ this ]()
+    {
+        // reserve enough address space for all cached pages (plus the
+        // pages which are in use while the cache is purged); in-memory
+        // Environments keep all pages
+        const uint64_t max_capacity = 64ull * 1024 * 1024 * 1024;
+        uint64_t capacity = max_capacity;
+        if( NOT_SET( config.flags, UPS_IN_MEMORY ) && NOT_SET( config.flags, UPS_CACHE_UNLIMITED ) )
+        {
+            capacity = std::max< uint64_t >( 2 * config.cache_size_bytes, 64 * 1024 * 1024 );
+        }
+        else if( IS_SET( config.flags, UPS_IN_MEMORY ) )
+        {
+            capacity = config.file_size_limit_bytes;
+        }
+
+        arena_.reset( new PageArena( config.page_size_bytes,
+                                     std::min( capacity, max_capacity ),
+                                     config.page_arena == UPS_PAGE_ARENA_HUGE_PAGES ) );
+    } );
+    return arena_.get();
+}
+
+//
+// Allocates a buffer for a page, either from the arena or from the heap.
+// With direct I/O the heap buffers are aligned.
+//
+void Device::allocate_page_buffer( Page *page, uint64_t address ) const
+{
+    PageArena *arena = page_arena();
+    if( arena )
+    {
+        void *p = arena->allocate();
+        if( p )
+        {
+            page->assign_allocated_buffer( p, address, arena );
+            return;
+        }
+    }
+
+    uint8_t *p = IS_SET( config.flags, UPS_DIRECT_IO )
+                    ? Memory::allocate_aligned< uint8_t >( config.page_size_bytes, File::kDirectIoAlignment )
+                    : Memory::allocate< uint8_t >( config.page_size_bytes );
+    page->assign_allocated_buffer( p, address );
+}
+
+//
+// Reads several pages, one by one
+//
+void Device::read_pages( Page * const *pages, const uint64_t *addresses, size_t count ) const
+{
+    for( size_t i = 0; i < count; i++ )
+    {
+        read_page( pages[i], addresses[i] );
+        pages[i]->set_address( addresses[i] );
+    }
+}
+
+//
+// Ignores the hint
+//
+void Device::advise( uint64_t, uint64_t, int ) const
+{
+}
+
+//
+// Writes several buffers to adjacent positions, one by one
+//
+void Device::write_vectored( uint64_t offset, const struct iovec *iov, size_t count ) const
+{
+    for( size_t i = 0; i < count; i++ )
+    {
+        write( offset, iov[i].iov_base, iov[i].iov_len );
+        offset += iov[i].iov_len;
+    }
+}
+
+//
+// Verifies the checksum of a page after it was read
+//
+void Device::verify_crc32( Page *page ) const
+{
+    if( !page->persisted_data.verify_on_read
+            || NOT_SET( config.flags, UPS_ENABLE_CRC32 )
+            || page->is_without_header() )
+    {
+        return;
+    }
+
+    const uint32_t crc32 = page->calculate_crc32();
+    if( crc32 != page->crc32() )
+    {
+        ups_trace(("crc32 mismatch in page %lu: 0x%lx != 0x%lx",
+                        page->address(), crc32, page->crc32()));
+        throw Exception( UPS_INTEGRITY_VIOLATED );
+    }
+}
+
+//
+// Fills in the metrics of the page arena
+//
+void Device::fill_metrics( ups_env_metrics_t *metrics ) const
+{
+    if( arena_ )
+    {
+        arena_->fill_metrics( metrics );
+    }
+}
+
+}
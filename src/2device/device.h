@@ -29,7 +29,12 @@
 
 #include "0root/root.h"
 
+#include <memory>
+#include <mutex>
+#include <sys/uio.h>
+
 // Always verify that a file of level N does not include headers > N!
+#include "1mem/page_arena.h"
 #include "2config/env_config.h"
 
 #ifndef UPS_ROOT_H
@@ -42,6 +47,23 @@ class Page;
 
 struct Device
 {
+    // Access patterns for advise()
+    enum
+    {
+        // No special treatment; restores the default (see
+        // UPS_PARAM_POSIX_FADVISE)
+        kAdviceNormal = 0,
+
+        // The range is read sequentially; read ahead aggressively
+        kAdviceSequential = 1,
+
+        // The range will be read soon; start reading it asynchronously
+        kAdviceWillNeed = 2,
+
+        // The (clean) range is no longer cached; release its memory
+        kAdviceDontNeed = 3
+    };
+
     // Constructor
     Device(const EnvConfig &config)
         : config(config) {
@@ -94,6 +116,11 @@ struct Device
     // Writes to the device; this function does not use mmap
     virtual void write(uint64_t offset, void *buffer, size_t len) const = 0;
 
+    // Writes |count| buffers to adjacent positions, starting at |offset|.
+    // The default implementation calls write() for each buffer.
+    virtual void write_vectored(uint64_t offset, const struct iovec *iov,
+                    size_t count) const;
+
     // Allocate storage from this device; this function
     // will *NOT* use mmap. returns the offset of the allocated storage.
     virtual uint64_t alloc(size_t len) = 0;
@@ -101,6 +128,12 @@ struct Device
     // Reads a page from the device; this function CAN use mmap
     virtual void read_page(Page *page, uint64_t address) const = 0;
 
+    // Reads |count| pages at the specified |addresses|; the reads can be
+    // in flight at the same time. The default implementation calls
+    // read_page() for each page.
+    virtual void read_pages(Page * const *pages, const uint64_t *addresses,
+                    size_t count) const;
+
     // Allocate storage for a page from this device; this function
     // can use mmap if available
     virtual void alloc_page(Page *page) = 0;
@@ -113,11 +146,66 @@ struct Device
     // Returns true if the specified range is in mapped memory
     virtual bool is_mapped(uint64_t file_offset, size_t size) const = 0;
 
+    // Tells the operating system how the range of |size| bytes at |offset|
+    // will be accessed; |advice| is one of kAdvice*. This is only a hint,
+    // errors are ignored. The default implementation does nothing.
+    virtual void advise(uint64_t offset, uint64_t size, int advice) const;
+
     // Removes unused space at the end of the file
     virtual void reclaim_space() = 0;
 
+    // Allocates a buffer for |page| and assigns it to the page. The buffer
+    // is taken from the page arena, if it is enabled. Falls back to the
+    // heap if the arena is exhausted.
+    void allocate_page_buffer( Page *page, uint64_t address ) const;
+
+    // Fills in the metrics of the page arena
+    void fill_metrics( ups_env_metrics_t *metrics ) const;
+
+    // Verifies the checksum of a page which was read from the file, if
+    // requested by Page::fetch(); throws UPS_INTEGRITY_VIOLATED if the
+    // checksum does not match
+    void verify_crc32( Page *page ) const;
+
     // the Environment configuration settings
     const EnvConfig &config;
+
+private:
+    // Returns the page arena, or null if it is disabled. The arena is
+    // created on first use, because the page size is unknown before the
+    // header page was read
+    PageArena *page_arena() const;
+
+    // the arena for page buffers
+    mutable std::unique_ptr< PageArena > arena_;
+
+    // for creating |arena_| only once
+    mutable std::once_flag arena_flag_;
+};
+
+//
+// Advises sequential access to the whole device while in scope; used
+// by full scans over the leaf nodes
+//
+struct ScopedSequentialAdvice
+{
+    ScopedSequentialAdvice( const Device *device )
+        : device_( device )
+        , size_( IS_SET( device->config.flags, UPS_IN_MEMORY ) ? 0 : device->file_size() )
+    {
+        device_->advise( 0, size_, Device::kAdviceSequential );
+    }
+
+    ~ScopedSequentialAdvice()
+    {
+        device_->advise( 0, size_, Device::kAdviceNormal );
+    }
+
+    ScopedSequentialAdvice( const ScopedSequentialAdvice& ) = delete;
+    ScopedSequentialAdvice& operator=( const ScopedSequentialAdvice& ) = delete;
+
+    const Device *device_;
+    uint64_t size_;
 };
 
 } // namespace upscaledb
@@ -0,0 +1,566 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+#include "device_compressed.h"
+#include <string.h>
+#include <algorithm>
+#include "2compressor/compressor_factory.h"
+#include "2page/page.h"
+
+namespace upscaledb {
+
+//
+//
+//
+CompressedDevice::CompressedDevice( const EnvConfig &config )
+    : Device( config )
+    , m_page_size( config.page_size_bytes )
+    , m_physical_size( 0 )
+{
+}
+
+//
+// Returns the path of the page table
+//
+std::string CompressedDevice::page_table_path( const std::string &filename )
+{
+    return filename + ".pagemap";
+}
+
+//
+// Create a new device; creates the file and the page table
+//
+void CompressedDevice::create()
+{
+    ScopedSpinlock lock( m_mutex );
+
+    m_page_size = config.page_size_bytes;
+    m_compressor.reset( CompressorFactory::create( config.page_compressor ) );
+
+    File file;
+    file.create( config.filename.c_str(), config.file_mode );
+    file.set_posix_advice( config.posix_advice );
+
+    File table_file;
+    table_file.create( page_table_path( config.filename ).c_str(), config.file_mode );
+
+    PPageTableHeader header;
+    ::memset( &header, 0, sizeof( header ) );
+    header.magic[ 0 ] = 'u';
+    header.magic[ 1 ] = 'p';
+    header.magic[ 2 ] = 'c';
+    header.version = kVersion;
+    header.algorithm = config.page_compressor;
+    header.page_size = m_page_size;
+    table_file.pwrite( 0, &header, sizeof( header ) );
+
+    m_file = std::move( file );
+    m_table_file = std::move( table_file );
+    m_table.clear();
+    m_free.clear();
+    m_released.clear();
+    m_physical_size = 0;
+}
+
+//
+// opens an existing device; loads the page table and collects the
+// free slots
+//
+void CompressedDevice::open()
+{
+    bool read_only = ( config.flags & UPS_READ_ONLY ) != 0;
+
+    ScopedSpinlock lock( m_mutex );
+
+    File file;
+    file.open( config.filename.c_str(), read_only );
+    file.set_posix_advice( config.posix_advice );
+
+    File table_file;
+    table_file.open( page_table_path( config.filename ).c_str(), read_only );
+
+    PPageTableHeader header;
+    const uint64_t table_size = table_file.file_size();
+    if( table_size < sizeof( header ) )
+    {
+        ups_log(("page table of %s is truncated", config.filename.c_str()));
+        throw Exception( UPS_INV_FILE_HEADER );
+    }
+    table_file.pread( 0, &header, sizeof( header ) );
+    if( header.magic[ 0 ] != 'u' || header.magic[ 1 ] != 'p'
+            || header.magic[ 2 ] != 'c' || header.magic[ 3 ] != '\0'
+            || header.version != kVersion )
+    {
+        ups_log(("invalid page table of %s", config.filename.c_str()));
+        throw Exception( UPS_INV_FILE_HEADER );
+    }
+    if( (int)header.algorithm != config.page_compressor )
+    {
+        ups_log(("the pages of %s are compressed with algorithm %u",
+                        config.filename.c_str(), header.algorithm));
+        throw Exception( UPS_INV_PARAMETER );
+    }
+
+    std::vector< PPageTableEntry > table( ( table_size - sizeof( header ) ) / sizeof( PPageTableEntry ) );
+    if( !table.empty() )
+    {
+        table_file.pread( sizeof( header ), table.data(), table.size() * sizeof( PPageTableEntry ) );
+    }
+
+    m_page_size = header.page_size;
+    m_compressor.reset( CompressorFactory::create( header.algorithm ) );
+    m_file = std::move( file );
+    m_table_file = std::move( table_file );
+    m_table.swap( table );
+    m_released.clear();
+    m_physical_size = m_file.file_size();
+    collect_free_slots_nolock();
+}
+
+//
+// returns true if the device is open
+//
+bool CompressedDevice::is_open() const
+{
+    ScopedSpinlock lock( m_mutex );
+    return m_file.is_open();
+}
+
+//
+// closes the device; the released slots are collected again when the
+// device is opened
+//
+void CompressedDevice::close()
+{
+    ScopedSpinlock lock( m_mutex );
+    m_file.close();
+    m_table_file.close();
+    m_table.clear();
+    m_free.clear();
+    m_released.clear();
+    m_physical_size = 0;
+}
+
+//
+// flushes the file and the page table; afterwards the released slots
+// can be reused
+//
+void CompressedDevice::flush() const
+{
+    ScopedSpinlock lock( m_mutex );
+    m_file.flush();
+    m_table_file.flush();
+
+    for( const std::pair< uint64_t, uint32_t > &slot : m_released )
+    {
+        m_free.insert( std::make_pair( (uint64_t)slot.second, slot.first ) );
+    }
+    m_released.clear();
+}
+
+//
+// truncate/resize the device
+//
+void CompressedDevice::truncate( uint64_t new_file_size )
+{
+    ScopedSpinlock lock( m_mutex );
+    truncate_nolock( new_file_size );
+}
+
+//
+// get the uncompressed size
+//
+uint64_t CompressedDevice::file_size() const
+{
+    ScopedSpinlock lock( m_mutex );
+    return m_table.size() * m_page_size;
+}
+
+//
+// Returns the size of the Environment's file
+//
+uint64_t CompressedDevice::physical_size() const
+{
+    ScopedSpinlock lock( m_mutex );
+    return m_physical_size;
+}
+
+//
+// seek position in the file
+//
+void CompressedDevice::seek( uint64_t offset, int whence ) const
+{
+    m_file.seek( offset, whence );
+}
+
+//
+// tell the position in the file
+//
+uint64_t CompressedDevice::tell() const
+{
+    return m_file.tell();
+}
+
+//
+// reads from the device; each page in the range is decompressed
+//
+void CompressedDevice::read( uint64_t offset, void *buffer, size_t len ) const
+{
+    ScopedSpinlock lock( m_mutex );
+
+    uint8_t *p = (uint8_t *)buffer;
+    while( len > 0 )
+    {
+        const uint64_t index = offset / m_page_size;
+        const size_t skip = (size_t)( offset % m_page_size );
+        const size_t size = std::min( len, (size_t)m_page_size - skip );
+
+        if( size == m_page_size )
+        {
+            read_page_nolock( index, p );
+        }
+        else
+        {
+            read_page_nolock( index, m_page.resize( m_page_size ) );
+            ::memcpy( p, m_page.data() + skip, size );
+        }
+
+        offset += size;
+        p += size;
+        len -= size;
+    }
+}
+
+//
+// writes to the device; each page in the range is compressed. Pages
+// which are only partially overwritten are read first
+//
+void CompressedDevice::write( uint64_t offset, void *buffer, size_t len ) const
+{
+    ScopedSpinlock lock( m_mutex );
+
+    if( offset + len > m_table.size() * m_page_size )
+    {
+        truncate_nolock( offset + len );
+    }
+
+    const uint8_t *p = (const uint8_t *)buffer;
+    while( len > 0 )
+    {
+        const uint64_t index = offset / m_page_size;
+        const size_t skip = (size_t)( offset % m_page_size );
+        const size_t size = std::min( len, (size_t)m_page_size - skip );
+
+        if( size == m_page_size )
+        {
+            write_page_nolock( index, p );
+        }
+        else
+        {
+            read_page_nolock( index, m_page.resize( m_page_size ) );
+            ::memcpy( m_page.data() + skip, p, size );
+            write_page_nolock( index, m_page.data() );
+        }
+
+        offset += size;
+        p += size;
+        len -= size;
+    }
+}
+
+//
+// Allocate storage from this device; the size is rounded up to full pages
+//
+uint64_t CompressedDevice::alloc( size_t requested_length )
+{
+    ScopedSpinlock lock( m_mutex );
+
+    const uint64_t address = m_table.size() * m_page_size;
+    truncate_nolock( address + requested_length );
+    return address;
+}
+
+//
+// reads a page from the device
+//
+void CompressedDevice::read_page( Page *page, uint64_t address ) const
+{
+    // note that the buffer will not leak if read() throws; it is stored in
+    // the |page| object and will be cleaned up by the caller in case of an
+    // exception.
+    if( page->data() == 0 )
+    {
+        allocate_page_buffer( page, address );
+    }
+
+    read( address, page->data(), m_page_size );
+    verify_crc32( page );
+}
+
+//
+// Allocates storage for a page from this device
+//
+void CompressedDevice::alloc_page( Page *page )
+{
+    uint64_t address = alloc( m_page_size );
+    page->set_address( address );
+
+    // allocate a memory buffer
+    allocate_page_buffer( page, address );
+}
+
+//
+// Frees a page on the device; plays counterpoint to |alloc_page|
+//
+void CompressedDevice::free_page( Page *page )
+{
+    assert( page->data() != 0 );
+    page->free_buffer();
+}
+
+//
+// The file is not mapped
+//
+bool CompressedDevice::is_mapped( uint64_t, size_t ) const
+{
+    return false;
+}
+
+//
+// Truncates the free slots at the end of the file. Released slots are
+// kept because the page table on disk might still refer to them
+//
+void CompressedDevice::reclaim_space()
+{
+    ScopedSpinlock lock( m_mutex );
+
+    uint64_t end = 0;
+    for( const PPageTableEntry &entry : m_table )
+    {
+        if( entry.capacity > 0 )
+        {
+            end = std::max( end, entry.offset + entry.capacity );
+        }
+    }
+    for( const std::pair< uint64_t, uint32_t > &slot : m_released )
+    {
+        end = std::max( end, slot.first + slot.second );
+    }
+
+    if( end >= m_physical_size )
+    {
+        return;
+    }
+
+    for( std::multimap< uint64_t, uint64_t >::iterator it = m_free.begin(); it != m_free.end(); )
+    {
+        if( it->second >= end )
+        {
+            it = m_free.erase( it );
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    m_file.truncate( end );
+    m_physical_size = end;
+}
+
+//
+// Reads and decompresses a page; pages which were never written are
+// filled with zeroes
+//
+void CompressedDevice::read_page_nolock( uint64_t index, uint8_t *buffer ) const
+{
+    if( index >= m_table.size() )
+    {
+        ups_log(("page %lu is beyond the end of the file",
+                        (unsigned long)( index * m_page_size )));
+        throw Exception( UPS_IO_ERROR );
+    }
+
+    const PPageTableEntry &entry = m_table[ index ];
+    if( entry.capacity == 0 )
+    {
+        ::memset( buffer, 0, m_page_size );
+        return;
+    }
+
+    uint8_t *slot = m_slot.resize( entry.capacity );
+    m_file.pread( entry.offset, slot, entry.capacity );
+
+    uint32_t length;
+    ::memcpy( &length, slot, sizeof( length ) );
+    if( length & kUncompressed )
+    {
+        length &= ~kUncompressed;
+        if( length != m_page_size || length + sizeof( length ) > entry.capacity )
+        {
+            ups_log(("invalid slot of page %lu", (unsigned long)( index * m_page_size )));
+            throw Exception( UPS_INTEGRITY_VIOLATED );
+        }
+        ::memcpy( buffer, slot + sizeof( length ), m_page_size );
+        return;
+    }
+
+    if( length + sizeof( length ) > entry.capacity )
+    {
+        ups_log(("invalid slot of page %lu", (unsigned long)( index * m_page_size )));
+        throw Exception( UPS_INTEGRITY_VIOLATED );
+    }
+    m_compressor->decompress( slot + sizeof( length ), length, m_page_size, buffer );
+}
+
+//
+// Compresses and writes a page. The slot is reused if the data fits,
+// otherwise the page moves to a new slot and the page table is updated
+//
+void CompressedDevice::write_page_nolock( uint64_t index, const uint8_t *buffer ) const
+{
+    uint32_t length = m_compressor->compress( buffer, m_page_size );
+    const uint8_t *data = m_compressor->arena.data();
+    if( length == 0 || length + sizeof( length ) >= m_page_size )
+    {
+        length = m_page_size;
+        data = buffer;
+    }
+
+    const uint32_t capacity = (uint32_t)( ( length + sizeof( length ) + kSlotAlignment - 1 ) / kSlotAlignment * kSlotAlignment );
+
+    uint8_t *slot = m_slot.resize( capacity );
+    const uint32_t header = data == buffer ? length | kUncompressed : length;
+    ::memcpy( slot, &header, sizeof( header ) );
+    ::memcpy( slot + sizeof( header ), data, length );
+    ::memset( slot + sizeof( header ) + length, 0, capacity - sizeof( header ) - length );
+
+    PPageTableEntry &entry = m_table[ index ];
+    if( entry.capacity >= capacity )
+    {
+        m_file.pwrite( entry.offset, slot, entry.capacity == capacity ? capacity : sizeof( header ) + length );
+        return;
+    }
+
+    // write the slot before the page table refers to it
+    const uint64_t offset = alloc_slot_nolock( capacity );
+    m_file.pwrite( offset, slot, capacity );
+
+    if( entry.capacity > 0 )
+    {
+        m_released.push_back( std::make_pair( (uint64_t)entry.offset, (uint32_t)entry.capacity ) );
+    }
+    entry.offset = offset;
+    entry.capacity = capacity;
+    store_entry_nolock( index );
+}
+
+//
+// Returns a free slot (the smallest one which is large enough), or
+// appends a new slot to the file
+//
+uint64_t CompressedDevice::alloc_slot_nolock( uint32_t capacity ) const
+{
+    std::multimap< uint64_t, uint64_t >::iterator it = m_free.lower_bound( capacity );
+    if( it == m_free.end() )
+    {
+        const uint64_t offset = m_physical_size;
+        m_physical_size += capacity;
+        return offset;
+    }
+
+    const uint64_t offset = it->second;
+    const uint64_t rest = it->first - capacity;
+    m_free.erase( it );
+    if( rest > 0 )
+    {
+        m_free.insert( std::make_pair( rest, offset + capacity ) );
+    }
+    return offset;
+}
+
+//
+// Writes a page table entry
+//
+void CompressedDevice::store_entry_nolock( uint64_t index ) const
+{
+    m_table_file.pwrite( sizeof( PPageTableHeader ) + index * sizeof( PPageTableEntry ),
+                         &m_table[ index ], sizeof( PPageTableEntry ) );
+}
+
+//
+// The gaps between the used slots are free
+//
+void CompressedDevice::collect_free_slots_nolock()
+{
+    std::vector< std::pair< uint64_t, uint32_t > > used;
+    for( const PPageTableEntry &entry : m_table )
+    {
+        if( entry.capacity > 0 )
+        {
+            used.push_back( std::make_pair( (uint64_t)entry.offset, (uint32_t)entry.capacity ) );
+        }
+    }
+    std::sort( used.begin(), used.end() );
+
+    m_free.clear();
+    uint64_t end = 0;
+    for( const std::pair< uint64_t, uint32_t > &slot : used )
+    {
+        if( slot.first > end )
+        {
+            m_free.insert( std::make_pair( slot.first - end, end ) );
+        }
+        end = std::max( end, slot.first + slot.second );
+    }
+
+    // the end of the file was not written completely
+    m_physical_size = std::max( m_physical_size, end );
+    if( m_physical_size > end )
+    {
+        m_free.insert( std::make_pair( m_physical_size - end, end ) );
+    }
+}
+
+//
+// truncate/resize the device; the size is rounded up to full pages.
+// The slots of removed pages are released. sans locking
+//
+void CompressedDevice::truncate_nolock( uint64_t new_file_size ) const
+{
+    if( new_file_size > config.file_size_limit_bytes )
+    {
+        throw Exception( UPS_LIMITS_REACHED );
+    }
+
+    const uint64_t count = ( new_file_size + m_page_size - 1 ) / m_page_size;
+    for( uint64_t i = count; i < m_table.size(); i++ )
+    {
+        if( m_table[ i ].capacity > 0 )
+        {
+            m_released.push_back( std::make_pair( (uint64_t)m_table[ i ].offset, (uint32_t)m_table[ i ].capacity ) );
+        }
+    }
+
+    PPageTableEntry empty;
+    ::memset( &empty, 0, sizeof( empty ) );
+    m_table.resize( count, empty );
+    m_table_file.truncate( sizeof( PPageTableHeader ) + count * sizeof( PPageTableEntry ) );
+}
+
+} // namespace upscaledb
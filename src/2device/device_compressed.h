@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * Device-implementation which compresses the pages
+ * (see UPS_PARAM_PAGE_COMPRESSION).
+ *
+ * Each page is compressed and stored in a "slot" of the Environment's
+ * file. A slot is a multiple of kSlotAlignment bytes and starts with the
+ * length of the compressed data. Pages which do not shrink are stored
+ * uncompressed.
+ *
+ * The page table maps each page to its slot. It is stored in a separate
+ * file (the Environment's filename plus ".pagemap"), and each modified
+ * entry is written immediately. A page is rewritten in its slot if the
+ * compressed data still fits, otherwise it moves to a free slot. The old
+ * slot is only reused after the next flush(), when the page table on disk
+ * no longer refers to it. The free slots are collected when the device
+ * is opened.
+ *
+ * The addresses of the pages do not change; file_size() returns the
+ * uncompressed size, which is always a multiple of the page size.
+ *
+ * The file is not mapped; pages are always read into buffers.
+ *
+ * @exception_safe: basic
+ * @thread_safe: yes
+ */
+
+#ifndef UPS_DEVICE_COMPRESSED_H
+#define UPS_DEVICE_COMPRESSED_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "0root/root.h"
+
+#include "1base/dynamic_array.h"
+#include "1base/spinlock.h"
+#include "1os/file.h"
+#include "2compressor/compressor.h"
+#include "2device/device.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+#include "1base/packstart.h"
+
+/*
+ * The header of the page table file
+ */
+typedef UPS_PACK_0 struct UPS_PACK_1 PPageTableHeader
+{
+    // magic cookie - always "upc\0"
+    uint8_t magic[ 4 ];
+
+    // the version of the file format
+    uint32_t version;
+
+    // the compression algorithm (UPS_COMPRESSOR_*)
+    uint32_t algorithm;
+
+    // the page size
+    uint32_t page_size;
+
+} UPS_PACK_2 PPageTableHeader;
+
+/*
+ * An entry of the page table; the entries follow the header, one for
+ * each page
+ */
+typedef UPS_PACK_0 struct UPS_PACK_1 PPageTableEntry
+{
+    // the offset of the slot in the Environment's file
+    uint64_t offset;
+
+    // the size of the slot; 0 if the page was never written
+    uint32_t capacity;
+
+    // reserved
+    uint32_t _reserved;
+
+} UPS_PACK_2 PPageTableEntry;
+
+#include "1base/packstop.h"
+
+class CompressedDevice : public Device
+{
+public:
+    enum
+    {
+        // the slots are aligned to (and a multiple of) this size
+        kSlotAlignment = 256,
+
+        // flag for the length of a slot: the page is not compressed
+        kUncompressed = 0x80000000u,
+
+        // the version of the page table format
+        kVersion = 1
+    };
+
+    CompressedDevice( const EnvConfig &config );
+
+    void create() override;
+    void open() override;
+    bool is_open() const override;
+    void close() override;
+    void flush() const override;
+    void truncate( uint64_t new_file_size ) override;
+    uint64_t file_size() const override;
+    void seek( uint64_t offset, int whence ) const override;
+    uint64_t tell() const override;
+
+    void read( uint64_t offset, void *buffer, size_t len ) const override;
+    void write( uint64_t offset, void *buffer, size_t len ) const override;
+
+    uint64_t alloc( size_t requested_length ) override;
+    void read_page( Page *page, uint64_t address ) const override;
+    void alloc_page( Page *page ) override;
+    void free_page( Page *page ) override;
+
+    bool is_mapped( uint64_t file_offset, size_t size ) const override;
+    void reclaim_space() override;
+
+    // Returns the size of the Environment's file, i.e. of the slots
+    uint64_t physical_size() const;
+
+    // Returns the path of the page table of the Environment |filename|
+    static std::string page_table_path( const std::string &filename );
+
+private:
+    // Reads and decompresses the page |index| into |buffer|, sans locking
+    void read_page_nolock( uint64_t index, uint8_t *buffer ) const;
+
+    // Compresses and writes the page |index|, sans locking
+    void write_page_nolock( uint64_t index, const uint8_t *buffer ) const;
+
+    // Returns the offset of a free slot of |capacity| bytes, sans locking
+    uint64_t alloc_slot_nolock( uint32_t capacity ) const;
+
+    // Writes the page table entry |index|, sans locking
+    void store_entry_nolock( uint64_t index ) const;
+
+    // Collects the free slots between the used ones, sans locking
+    void collect_free_slots_nolock();
+
+    // truncate/resize the device, sans locking
+    void truncate_nolock( uint64_t new_file_size ) const;
+
+private:
+    // For synchronizing access
+    mutable Spinlock m_mutex;
+
+    // the Environment's file with the slots
+    File m_file;
+
+    // the file with the page table
+    File m_table_file;
+
+    // the page size; the device is opened before the page size is known
+    uint32_t m_page_size;
+
+    // mutable: pages are compressed and written by the const write()
+    mutable std::unique_ptr< Compressor > m_compressor;
+
+    // the page table
+    mutable std::vector< PPageTableEntry > m_table;
+
+    // the size of the Environment's file
+    mutable uint64_t m_physical_size;
+
+    // the free slots, by capacity
+    mutable std::multimap< uint64_t, uint64_t > m_free;
+
+    // the slots which were released since the last flush(); they can
+    // still be referenced by the page table on disk
+    mutable std::vector< std::pair< uint64_t, uint32_t > > m_released;
+
+    // a buffer for a slot
+    mutable ByteArray m_slot;
+
+    // a buffer for a page which is read or written partially
+    mutable ByteArray m_page;
+};
+
+} // namespace upscaledb
+
+#endif /* UPS_DEVICE_COMPRESSED_H */
@@ -1,9 +1,15 @@
 #include "device_disk.h"
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <algorithm>
 #include "1mem/mem.h"
 #include "2page/page.h"
 
 namespace upscaledb {
 
+// reserve up to 64 GB of address space for the mapping
+const uint64_t DiskDevice::kMaxReservedSize = 64ull * 1024 * 1024 * 1024;
+
 //
 //
 //
@@ -13,8 +19,12 @@ DiskDevice::DiskDevice( const EnvConfig &config )
     State state;
     state.mmapptr = nullptr;
     state.mapped_size = 0;
+    state.reserved_size = 0;
+    state.mapping_limit = 0;
     state.file_size = 0;
     state.excess_at_end = 0;
+    state.extent_size = 0;
+    state.reserved_end = 0;
     swap( m_state, state );
 }
 
@@ -28,13 +38,26 @@ void DiskDevice::create()
     File file;
     file.create( config.filename.c_str(), config.file_mode );
     file.set_posix_advice( config.posix_advice );
+    if( IS_SET( config.flags, UPS_DIRECT_IO ) )
+    {
+        file.enable_direct_io();
+    }
     m_state.file = std::move( file );
+    m_state.file_size = 0;
+    m_state.extent_size = config.file_extent_size;
+    m_state.reserved_end = 0;
+
+    if( NOT_SET( config.flags, UPS_DISABLE_MMAP ) )
+    {
+        reserve_nolock();
+    }
 }
 
 //
 // opens an existing device
 //
-// tries to map the file; if it fails then continue with read/write
+// tries to map the file; if it fails then continue with read/write.
+// Direct I/O implies UPS_DISABLE_MMAP.
 //
 void DiskDevice::open()
 {
@@ -45,35 +68,21 @@ void DiskDevice::open()
     State state = std::move( m_state );
     state.file.open (config.filename.c_str(), read_only );
     state.file.set_posix_advice( config.posix_advice );
-
-    // the file size which backs the mapped ptr
-    state.file_size = state.file.file_size();
-
-    if( IS_SET( config.flags, UPS_DISABLE_MMAP ) )
+    if( IS_SET( config.flags, UPS_DIRECT_IO ) )
     {
-        swap( m_state, state );
-        return;
+        state.file.enable_direct_io();
     }
 
-    // make sure we do not exceed the "real" size of the file, otherwise
-    // we crash when accessing memory which exceeds the mapping (at least on Win32)
-    const size_t granularity = File::granularity();
-    if( state.file_size == 0 || state.file_size % granularity )
-    {
-        swap( m_state, state );
-        return;
-    }
+    // the file size which backs the mapped ptr
+    state.file_size = state.file.file_size();
+    state.extent_size = read_only ? 0 : config.file_extent_size;
+    state.reserved_end = state.file_size;
+    swap( m_state, state );
 
-    state.mapped_size = state.file_size;
-    try
-    {
-        state.file.mmap( 0, state.mapped_size, read_only, &state.mmapptr );
-    }
-    catch( Exception &ex )
+    if( NOT_SET( config.flags, UPS_DISABLE_MMAP ) )
     {
-        ups_log(("mmap failed with error %d, falling back to read/write", ex.code));
+        reserve_nolock();
     }
-    swap( m_state, state );
 }
 
 //
@@ -94,10 +103,14 @@ void DiskDevice::close()
     State state = std::move( m_state );
     if( state.mmapptr )
     {
-        state.file.munmap( state.mmapptr, state.mapped_size );
+        state.file.munmap( state.mmapptr, state.reserved_size );
     }
     state.file.close();
 
+    state.mmapptr = nullptr;
+    state.mapped_size = 0;
+    state.reserved_size = 0;
+    state.mapping_limit = 0;
     swap( m_state, state );
 }
 
@@ -189,6 +202,24 @@ void DiskDevice::write(uint64_t offset, void *buffer, size_t len) const
     m_state.file.pwrite( offset, buffer, len );
 }
 
+//
+// writes several buffers to adjacent positions with a single system call;
+// encrypted buffers are written one by one
+//
+void DiskDevice::write_vectored( uint64_t offset, const struct iovec *iov, size_t count ) const
+{
+#ifdef UPS_ENABLE_ENCRYPTION
+    if( config.is_encryption_enabled )
+    {
+        Device::write_vectored( offset, iov, count );
+        return;
+    }
+#endif
+
+    ScopedSpinlock lock( m_mutex );
+    m_state.file.pwritev( offset, iov, count );
+}
+
 //
 // Allocate storage from this device.
 // This function will *NOT* return mmapped memory.
@@ -232,6 +263,7 @@ uint64_t DiskDevice::alloc( size_t requested_length )
     }
 
     const uint64_t address = m_state.file_size;
+    preallocate_nolock( address + requested_length + excess );
     truncate_nolock( address + requested_length + excess );
     m_state.excess_at_end = excess;
 
@@ -248,7 +280,7 @@ void DiskDevice::read_page( Page *page, uint64_t address ) const
 
     // if this page is in the mapped area: return a pointer into that area.
     // otherwise fall back to read/write.
-    if( address < m_state.mapped_size && m_state.mmapptr != 0 )
+    if( m_state.mmapptr != 0 && map_nolock( address + config.page_size_bytes ) )
     {
         // the following line will not throw a C++ exception, but can
         // raise a signal. If that's the case then we don't catch it because
@@ -260,11 +292,10 @@ void DiskDevice::read_page( Page *page, uint64_t address ) const
     // this page is not in the mapped area; allocate a buffer
     if( page->data() == 0 )
     {
-        // note that |p| will not leak if file.pread() throws; |p| is stored
-        // in the |page| object and will be cleaned up by the caller in
-        // case of an exception.
-        uint8_t *p = Memory::allocate< uint8_t >( config.page_size_bytes );
-        page->assign_allocated_buffer(p, address);
+        // note that the buffer will not leak if file.pread() throws; it is
+        // stored in the |page| object and will be cleaned up by the caller
+        // in case of an exception.
+        allocate_page_buffer( page, address );
     }
 
     m_state.file.pread( address, page->data(), config.page_size_bytes );
@@ -277,6 +308,9 @@ void DiskDevice::read_page( Page *page, uint64_t address ) const
                     config.page_size_bytes);
     }
 #endif
+
+    // mapped pages are verified by the caller
+    verify_crc32( page );
 }
 
 //
@@ -289,8 +323,7 @@ void DiskDevice::alloc_page( Page *page )
     page->set_address( address );
 
     // allocate a memory buffer
-    uint8_t *p = Memory::allocate< uint8_t >( config.page_size_bytes );
-    page->assign_allocated_buffer( p, address );
+    allocate_page_buffer( page, address );
 }
 //
 // Frees a page on the device; plays counterpoint to |alloc_page|
@@ -310,6 +343,80 @@ bool DiskDevice::is_mapped( uint64_t file_offset, size_t size ) const
     return file_offset + size <= m_state.mapped_size;
 }
 
+//
+// Passes the hint to madvise() for the mapped part of the range, and to
+// posix_fadvise() for the rest. Ignored with direct I/O, since the page
+// cache is not used
+//
+void DiskDevice::advise( uint64_t offset, uint64_t size, int advice ) const
+{
+    ScopedSpinlock lock( m_mutex );
+
+    if( !m_state.file.is_open() || m_state.file.is_direct_io() || size == 0 )
+    {
+        return;
+    }
+
+    const bool is_random = config.posix_advice == EnvConfig::UPS_POSIX_FADVICE_RANDOM;
+    const uint64_t end = offset + size;
+    const uint64_t granularity = File::granularity();
+
+    // the mapped part of the range
+    if( m_state.mmapptr != 0 && offset < m_state.mapped_size )
+    {
+        uint64_t begin = offset / granularity * granularity;
+        const uint64_t mapped_end = std::min( end, m_state.mapped_size );
+
+        int madvice = -1;
+        switch( advice )
+        {
+        case kAdviceNormal:
+            madvice = is_random ? MADV_RANDOM : MADV_NORMAL;
+            break;
+        case kAdviceSequential:
+            madvice = MADV_SEQUENTIAL;
+            break;
+        case kAdviceWillNeed:
+            madvice = MADV_WILLNEED;
+            break;
+        case kAdviceDontNeed:
+            // private mappings drop their modified copies; never touch the
+            // neighbours which share the first or the last memory page
+            if( offset % granularity == 0 && mapped_end % granularity == 0 )
+            {
+                madvice = MADV_DONTNEED;
+            }
+            break;
+        }
+
+        if( madvice != -1 )
+        {
+            File::advise_memory( m_state.mmapptr + begin, (size_t)( mapped_end - begin ), madvice );
+        }
+        offset = mapped_end;
+    }
+
+    // the unmapped part; the page cache is kept, since it serves as a second
+    // level cache for evicted pages
+    if( offset < end && advice != kAdviceDontNeed )
+    {
+        int fadvice = POSIX_FADV_NORMAL;
+        switch( advice )
+        {
+        case kAdviceNormal:
+            fadvice = is_random ? POSIX_FADV_RANDOM : POSIX_FADV_NORMAL;
+            break;
+        case kAdviceSequential:
+            fadvice = POSIX_FADV_SEQUENTIAL;
+            break;
+        case kAdviceWillNeed:
+            fadvice = POSIX_FADV_WILLNEED;
+            break;
+        }
+        m_state.file.advise( offset, end - offset, fadvice );
+    }
+}
+
 //
 // Removes unused space at the end of the file
 //
@@ -321,6 +428,7 @@ void DiskDevice::reclaim_space()
         truncate_nolock( m_state.file_size - m_state.excess_at_end );
         m_state.excess_at_end = 0;
     }
+    release_extent_nolock();
 }
 
 //
@@ -343,8 +451,127 @@ void DiskDevice::truncate_nolock( uint64_t new_file_size )
         throw Exception( UPS_LIMITS_REACHED );
     }
 
+    // shrinking the file also releases the reserved space
+    if( new_file_size <= m_state.file_size && new_file_size < m_state.reserved_end )
+    {
+        m_state.reserved_end = new_file_size;
+    }
+
     m_state.file.truncate( new_file_size );
     m_state.file_size = new_file_size;
+
+    // the pages beyond the end of the file must no longer be used; they are
+    // mapped again when the file grows
+    if( new_file_size < m_state.mapped_size )
+    {
+        m_state.mapped_size = new_file_size / File::granularity() * File::granularity();
+    }
+}
+
+//
+// reserves disk space up to |end| in extents of |extent_size|, which
+// are allocated (mostly) contiguously. Disables the reservation if the
+// file system does not support it. Sans locking
+//
+void DiskDevice::preallocate_nolock( uint64_t end )
+{
+    if( m_state.extent_size == 0 || end <= m_state.reserved_end )
+    {
+        return;
+    }
+
+    const uint64_t extent = m_state.extent_size;
+    const uint64_t begin = std::max( m_state.reserved_end, m_state.file_size );
+    uint64_t new_end = std::min< uint64_t >( ( end + extent - 1 ) / extent * extent, config.file_size_limit_bytes );
+    new_end = std::max( new_end, end );
+
+    if( !m_state.file.allocate( begin, new_end - begin ) )
+    {
+        m_state.extent_size = 0;
+        return;
+    }
+    m_state.reserved_end = new_end;
+}
+
+//
+// releases the reserved disk space beyond the end of the file, sans
+// locking
+//
+void DiskDevice::release_extent_nolock()
+{
+    // truncating the file to its current size releases the blocks
+    // beyond the end of the file
+    if( m_state.reserved_end > m_state.file_size )
+    {
+        m_state.file.truncate( m_state.file_size );
+        m_state.reserved_end = m_state.file_size;
+    }
+}
+
+//
+// reserves the address range for the mapping and maps the file, sans
+// locking. If this fails then continue with read/write
+//
+void DiskDevice::reserve_nolock()
+{
+    const uint64_t granularity = File::granularity();
+    uint64_t size = std::min< uint64_t >( config.file_size_limit_bytes, kMaxReservedSize );
+    size = std::max< uint64_t >( size, m_state.file_size );
+    size = ( size + granularity - 1 ) / granularity * granularity;
+
+    m_state.mmapptr = nullptr;
+    m_state.mapped_size = 0;
+    try
+    {
+        File::reserve( (size_t)size, &m_state.mmapptr );
+    }
+    catch( Exception &ex )
+    {
+        ups_log(("mmap failed with error %d, falling back to read/write", ex.code));
+        return;
+    }
+    m_state.reserved_size = size;
+    m_state.mapping_limit = size;
+
+    map_nolock( m_state.file_size / granularity * granularity );
+}
+
+//
+// grows the mapping to include the range up to |end|; maps everything up
+// to the current file size, as long as the reserved range is not
+// exhausted. Sans locking
+//
+bool DiskDevice::map_nolock( uint64_t end ) const
+{
+    if( end <= m_state.mapped_size )
+    {
+        return true;
+    }
+
+    // make sure we do not exceed the "real" size of the file, otherwise
+    // we crash when accessing memory which exceeds the mapping
+    const uint64_t granularity = File::granularity();
+    const uint64_t size = std::min( m_state.file_size / granularity * granularity, m_state.mapping_limit );
+    if( m_state.mmapptr == nullptr || end > size )
+    {
+        return false;
+    }
+
+    try
+    {
+        m_state.file.mmap_fixed( m_state.mapped_size, (size_t)( size - m_state.mapped_size ),
+                                 IS_SET( config.flags, UPS_READ_ONLY ), m_state.mmapptr + m_state.mapped_size );
+    }
+    catch( Exception &ex )
+    {
+        ups_log(("mmap failed with error %d, falling back to read/write", ex.code));
+        // do not try again
+        m_state.mapping_limit = m_state.mapped_size;
+        return false;
+    }
+
+    m_state.mapped_size = size;
+    return true;
 }
 
 }
@@ -21,6 +21,12 @@
  * for most operations, but currently it's possible that the Page is modified
  * if DiskDevice::read_page fails in the middle.
  *
+ * Unless mmap is disabled, a large range of the address space is reserved
+ * when the file is created or opened, and the file is mapped into this
+ * range. Whenever a page beyond the mapped region is read, the mapping
+ * grows up to the current file size. The mapped pages never move, therefore
+ * pointers to existing pages stay valid.
+ *
  * @exception_safe: basic/strong
  * @thread_safe: no
  */
@@ -65,12 +71,25 @@ class DiskDevice : public Device
         // the size of mmapptr as used in mmap
         uint64_t mapped_size;
 
+        // the size of the reserved address range at |mmapptr|
+        uint64_t reserved_size;
+
+        // the mapping does not grow beyond this size
+        uint64_t mapping_limit;
+
         // the (cached) size of the file
         uint64_t file_size;
 
         // excess storage at the end of the file
         uint64_t excess_at_end;
 
+        // the size of the extents which are reserved with fallocate();
+        // 0 if disabled or not supported
+        uint64_t extent_size;
+
+        // disk space is reserved up to this offset
+        uint64_t reserved_end;
+
         // Allow state to be swapped
         friend void swap( State& old_state, State& new_state )
         {
@@ -93,6 +112,7 @@ public:
 
     void read( uint64_t offset, void *buffer, size_t len ) const override;
     void write( uint64_t offset, void *buffer, size_t len ) const override;
+    void write_vectored( uint64_t offset, const struct iovec *iov, size_t count ) const override;
 
     uint64_t alloc( size_t requested_length ) override;
     void read_page( Page *page, uint64_t address ) const override;
@@ -100,19 +120,38 @@ public:
     void free_page( Page *page ) override;
 
     bool is_mapped( uint64_t file_offset, size_t size ) const override;
+    void advise( uint64_t offset, uint64_t size, int advice ) const override;
     void reclaim_space() override;
 
     uint8_t *mapped_pointer( uint64_t address ) const;
 
+    // the maximum size of the reserved address range
+    static const uint64_t kMaxReservedSize;
+
 private:
     // truncate/resize the device, sans locking
     void truncate_nolock( uint64_t new_file_size );
 
-private:
+    // reserves the address range and maps the file, sans locking
+    void reserve_nolock();
+
+    // reserves disk space in extents up to |end|, sans locking
+    void preallocate_nolock( uint64_t end );
+
+    // releases the reserved disk space beyond the end of the file,
+    // sans locking
+    void release_extent_nolock();
+
+protected:
+    // grows the mapping to include the range up to |end|; returns false
+    // if this is not possible. sans locking
+    bool map_nolock( uint64_t end ) const;
+
     // For synchronizing access
     mutable Spinlock m_mutex;
 
-    State m_state;
+    // mutable: the mapping grows when pages are read
+    mutable State m_state;
 };
 
 } // namespace upscaledb
@@ -30,8 +30,11 @@
 
 // Always verify that a file of level N does not include headers > N!
 #include "2config/env_config.h"
+#include "2device/device_compressed.h"
 #include "2device/device_disk.h"
 #include "2device/device_inmem.h"
+#include "2device/device_striped.h"
+#include "2device/device_uring.h"
 
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
@@ -44,8 +47,13 @@ struct DeviceFactory {
   static Device *create(const EnvConfig &config) {
     if (IS_SET(config.flags, UPS_IN_MEMORY))
       return new InMemoryDevice(config);
-    else
-      return new DiskDevice(config);
+    if (config.page_compressor != 0)
+      return new CompressedDevice(config);
+    if (!config.stripe_paths.empty())
+      return new StripedDevice(config);
+    if (config.io_backend == UPS_IO_BACKEND_IO_URING)
+      return new UringDevice(config);
+    return new DiskDevice(config);
   }
 };
 
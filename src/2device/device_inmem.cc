@@ -141,8 +141,8 @@ void InMemoryDevice::alloc_page( Page *page )
         throw Exception( UPS_LIMITS_REACHED );
     }
 
-    uint8_t *p = Memory::allocate< uint8_t >( page_size );
-    page->assign_allocated_buffer( p, ( uint64_t )p );
+    allocate_page_buffer( page, 0 );
+    page->set_address( ( uint64_t )page->data() );
 
     allocated_size_ += page_size;
 }
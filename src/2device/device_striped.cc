@@ -0,0 +1,672 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+#include "device_striped.h"
+#include <fcntl.h>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include "2page/page.h"
+#include "2worker/worker.h"
+
+namespace upscaledb {
+
+//
+//
+//
+StripedDevice::StripedDevice( const EnvConfig &config )
+    : Device( config )
+    , m_stripe_size( config.stripe_size )
+    , m_file_size( 0 )
+{
+}
+
+//
+// joins the worker threads before the files are closed
+//
+StripedDevice::~StripedDevice()
+{
+    m_workers.reset();
+}
+
+//
+// Splits a list of paths, separated by ';'; empty paths are skipped
+//
+std::vector< std::string > StripedDevice::split_paths( const std::string &paths )
+{
+    std::vector< std::string > result;
+    size_t begin = 0;
+    while( begin <= paths.size() )
+    {
+        size_t end = paths.find( ';', begin );
+        if( end == std::string::npos )
+        {
+            end = paths.size();
+        }
+        if( end > begin )
+        {
+            result.push_back( paths.substr( begin, end - begin ) );
+        }
+        begin = end + 1;
+    }
+    return result;
+}
+
+//
+// Returns the paths of all files; the Environment's file is the first
+//
+std::vector< std::string > StripedDevice::paths() const
+{
+    std::vector< std::string > result = split_paths( config.stripe_paths );
+    result.insert( result.begin(), config.filename );
+    return result;
+}
+
+//
+// Create a new device; creates all files
+//
+void StripedDevice::create()
+{
+    ScopedSpinlock lock( m_mutex );
+
+    std::vector< std::string > v = paths();
+    m_files.clear();
+    m_files.reserve( v.size() );
+    for( const std::string &path : v )
+    {
+        File file;
+        file.create( path.c_str(), config.file_mode );
+        file.set_posix_advice( config.posix_advice );
+        if( IS_SET( config.flags, UPS_DIRECT_IO ) )
+        {
+            file.enable_direct_io();
+        }
+        m_files.push_back( std::move( file ) );
+    }
+    m_file_size = 0;
+
+    start_workers();
+}
+
+//
+// opens an existing device; the size of the device is calculated from
+// the sizes of the files
+//
+void StripedDevice::open()
+{
+    bool read_only = ( config.flags & UPS_READ_ONLY ) != 0;
+
+    ScopedSpinlock lock( m_mutex );
+
+    std::vector< std::string > v = paths();
+    m_files.clear();
+    m_files.reserve( v.size() );
+    for( const std::string &path : v )
+    {
+        File file;
+        file.open( path.c_str(), read_only );
+        file.set_posix_advice( config.posix_advice );
+        if( IS_SET( config.flags, UPS_DIRECT_IO ) )
+        {
+            file.enable_direct_io();
+        }
+        m_files.push_back( std::move( file ) );
+    }
+
+    // the last byte of file i is in stripe (last / stripe_size) * N + i
+    m_file_size = 0;
+    const uint64_t n = m_files.size();
+    for( size_t i = 0; i < m_files.size(); i++ )
+    {
+        const uint64_t size = m_files[i].file_size();
+        if( size > 0 )
+        {
+            const uint64_t last = size - 1;
+            const uint64_t stripe = ( last / m_stripe_size ) * n + i;
+            m_file_size = std::max( m_file_size, stripe * m_stripe_size + last % m_stripe_size + 1 );
+        }
+    }
+
+    start_workers();
+}
+
+//
+// returns true if the device is open
+//
+bool StripedDevice::is_open() const
+{
+    ScopedSpinlock lock( m_mutex );
+    return !m_files.empty() && m_files[0].is_open();
+}
+
+//
+// closes the device
+//
+void StripedDevice::close()
+{
+    m_workers.reset();
+
+    ScopedSpinlock lock( m_mutex );
+    for( File &file : m_files )
+    {
+        file.close();
+    }
+    m_files.clear();
+    m_file_size = 0;
+}
+
+//
+// flushes all files in parallel
+//
+void StripedDevice::flush() const
+{
+    std::vector< boost::function< void() > > jobs( m_files.size() );
+    for( size_t i = 0; i < m_files.size(); i++ )
+    {
+        const File *file = &m_files[i];
+        jobs[i] = [ file ]() { file->flush(); };
+    }
+    run_parallel( jobs );
+}
+
+//
+// truncate/resize the device
+//
+void StripedDevice::truncate( uint64_t new_file_size )
+{
+    ScopedSpinlock lock( m_mutex );
+    truncate_nolock( new_file_size );
+}
+
+//
+// get the current file/storage size
+//
+uint64_t StripedDevice::file_size() const
+{
+    ScopedSpinlock lock( m_mutex );
+    return m_file_size;
+}
+
+//
+// seek to a position in the first file
+//
+void StripedDevice::seek( uint64_t offset, int whence ) const
+{
+    m_files[0].seek( offset, whence );
+}
+
+//
+// tell the position in the first file
+//
+uint64_t StripedDevice::tell() const
+{
+    return m_files[0].tell();
+}
+
+//
+// Returns the number of files
+//
+size_t StripedDevice::stripe_count() const
+{
+    return m_files.size();
+}
+
+//
+// Splits a range into the parts which are stored in the same file
+//
+std::vector< StripedDevice::Extent > StripedDevice::split( uint64_t offset, uint64_t len ) const
+{
+    std::vector< Extent > extents;
+    const uint64_t n = m_files.size();
+
+    while( len > 0 )
+    {
+        const uint64_t stripe = offset / m_stripe_size;
+        const uint64_t skip = offset % m_stripe_size;
+
+        Extent extent;
+        extent.file = (size_t)( stripe % n );
+        extent.file_offset = ( stripe / n ) * m_stripe_size + skip;
+        extent.address = offset;
+        extent.size = (size_t)std::min( len, m_stripe_size - skip );
+        extents.push_back( extent );
+
+        offset += extent.size;
+        len -= extent.size;
+    }
+    return extents;
+}
+
+//
+// Returns the size of the file |index| if the device has |size| bytes;
+// this is also the offset in this file where the address |size| starts
+//
+uint64_t StripedDevice::file_size_of( size_t index, uint64_t size ) const
+{
+    const uint64_t round = m_stripe_size * m_files.size();
+    uint64_t result = ( size / round ) * m_stripe_size;
+    const uint64_t rest = size % round;
+    if( rest > index * m_stripe_size )
+    {
+        result += std::min( m_stripe_size, rest - index * m_stripe_size );
+    }
+    return result;
+}
+
+//
+// reads from the device; ranges which span several files are read in
+// parallel
+//
+void StripedDevice::read( uint64_t offset, void *buffer, size_t len ) const
+{
+    const std::vector< Extent > extents = split( offset, len );
+    uint8_t *p = (uint8_t *)buffer;
+
+    if( extents.size() == 1 )
+    {
+        m_files[extents[0].file].pread( extents[0].file_offset, p, len );
+        return;
+    }
+
+    std::vector< boost::function< void() > > jobs( m_files.size() );
+    for( size_t i = 0; i < m_files.size(); i++ )
+    {
+        const File *file = &m_files[i];
+        const std::vector< Extent > *parts = &extents;
+        jobs[i] = [ file, parts, i, offset, p ]()
+        {
+            for( const Extent &e : *parts )
+            {
+                if( e.file == i )
+                {
+                    file->pread( e.file_offset, p + ( e.address - offset ), e.size );
+                }
+            }
+        };
+    }
+    run_parallel( jobs );
+}
+
+//
+// writes to the device; ranges which span several files are written in
+// parallel
+//
+void StripedDevice::write( uint64_t offset, void *buffer, size_t len ) const
+{
+    const std::vector< Extent > extents = split( offset, len );
+    const uint8_t *p = (const uint8_t *)buffer;
+
+    if( extents.size() == 1 )
+    {
+        m_files[extents[0].file].pwrite( extents[0].file_offset, p, len );
+        return;
+    }
+
+    std::vector< boost::function< void() > > jobs( m_files.size() );
+    for( size_t i = 0; i < m_files.size(); i++ )
+    {
+        const File *file = &m_files[i];
+        const std::vector< Extent > *parts = &extents;
+        jobs[i] = [ file, parts, i, offset, p ]()
+        {
+            for( const Extent &e : *parts )
+            {
+                if( e.file == i )
+                {
+                    file->pwrite( e.file_offset, p + ( e.address - offset ), e.size );
+                }
+            }
+        };
+    }
+    run_parallel( jobs );
+}
+
+//
+// writes several buffers to adjacent positions; the buffers are grouped
+// by file, and buffers which are adjacent in a file are written with a
+// single system call. The files are written in parallel
+//
+void StripedDevice::write_vectored( uint64_t offset, const struct iovec *iov, size_t count ) const
+{
+    // a run of buffers which are adjacent in a file
+    struct Run
+    {
+        uint64_t file_offset;
+        uint64_t end;
+        std::vector< struct iovec > iov;
+    };
+
+    std::vector< std::vector< Run > > runs( m_files.size() );
+    for( size_t i = 0; i < count; i++ )
+    {
+        const uint8_t *p = (const uint8_t *)iov[i].iov_base;
+        for( const Extent &e : split( offset, iov[i].iov_len ) )
+        {
+            std::vector< Run > &v = runs[e.file];
+            if( v.empty() || v.back().end != e.file_offset )
+            {
+                v.push_back( Run() );
+                v.back().file_offset = e.file_offset;
+                v.back().end = e.file_offset;
+            }
+
+            struct iovec part;
+            part.iov_base = (void *)( p + ( e.address - offset ) );
+            part.iov_len = e.size;
+            v.back().iov.push_back( part );
+            v.back().end += e.size;
+        }
+        offset += iov[i].iov_len;
+    }
+
+    std::vector< boost::function< void() > > jobs( m_files.size() );
+    for( size_t i = 0; i < m_files.size(); i++ )
+    {
+        if( runs[i].empty() )
+        {
+            continue;
+        }
+
+        const File *file = &m_files[i];
+        const std::vector< Run > *v = &runs[i];
+        jobs[i] = [ file, v ]()
+        {
+            for( const Run &run : *v )
+            {
+                file->pwritev( run.file_offset, run.iov.data(), run.iov.size() );
+            }
+        };
+    }
+    run_parallel( jobs );
+}
+
+//
+// Allocate storage from this device; grows the files which store the
+// new range
+//
+uint64_t StripedDevice::alloc( size_t requested_length )
+{
+    ScopedSpinlock lock( m_mutex );
+
+    const uint64_t address = m_file_size;
+    truncate_nolock( address + requested_length );
+    return address;
+}
+
+//
+// reads a page from the device
+//
+void StripedDevice::read_page( Page *page, uint64_t address ) const
+{
+    // note that the buffer will not leak if read() throws; it is stored in
+    // the |page| object and will be cleaned up by the caller in case of an
+    // exception.
+    if( page->data() == 0 )
+    {
+        allocate_page_buffer( page, address );
+    }
+
+    read( address, page->data(), config.page_size_bytes );
+    verify_crc32( page );
+}
+
+//
+// reads a batch of pages; the pages of each file are read by the worker
+// thread of this file
+//
+void StripedDevice::read_pages( Page * const *pages, const uint64_t *addresses, size_t count ) const
+{
+    // the parts of all pages, and their target buffers
+    std::vector< Extent > extents;
+    std::vector< uint8_t * > buffers;
+
+    for( size_t i = 0; i < count; i++ )
+    {
+        Page *page = pages[i];
+        if( page->data() == 0 )
+        {
+            allocate_page_buffer( page, addresses[i] );
+        }
+
+        for( const Extent &e : split( addresses[i], config.page_size_bytes ) )
+        {
+            extents.push_back( e );
+            buffers.push_back( (uint8_t *)page->data() + ( e.address - addresses[i] ) );
+        }
+    }
+
+    std::vector< boost::function< void() > > jobs( m_files.size() );
+    for( size_t i = 0; i < m_files.size(); i++ )
+    {
+        const File *file = &m_files[i];
+        const std::vector< Extent > *parts = &extents;
+        const std::vector< uint8_t * > *targets = &buffers;
+        jobs[i] = [ file, parts, targets, i ]()
+        {
+            for( size_t j = 0; j < parts->size(); j++ )
+            {
+                const Extent &e = ( *parts )[j];
+                if( e.file == i )
+                {
+                    file->pread( e.file_offset, ( *targets )[j], e.size );
+                }
+            }
+        };
+    }
+    run_parallel( jobs );
+
+    for( size_t i = 0; i < count; i++ )
+    {
+        pages[i]->set_address( addresses[i] );
+    }
+}
+
+//
+// Allocates storage for a page from this device
+//
+void StripedDevice::alloc_page( Page *page )
+{
+    uint64_t address = alloc( config.page_size_bytes );
+    page->set_address( address );
+
+    // allocate a memory buffer
+    allocate_page_buffer( page, address );
+}
+
+//
+// Frees a page on the device; plays counterpoint to |alloc_page|
+//
+void StripedDevice::free_page( Page *page )
+{
+    assert( page->data() != 0 );
+    page->free_buffer();
+}
+
+//
+// The files are not mapped
+//
+bool StripedDevice::is_mapped( uint64_t, size_t ) const
+{
+    return false;
+}
+
+//
+// Passes the hint to posix_fadvise() for the part of the range which is
+// stored in each file. The files are not mapped, therefore kAdviceDontNeed
+// is ignored
+//
+void StripedDevice::advise( uint64_t offset, uint64_t size, int advice ) const
+{
+    if( size == 0 || advice == kAdviceDontNeed || IS_SET( config.flags, UPS_DIRECT_IO ) )
+    {
+        return;
+    }
+
+    int fadvice = POSIX_FADV_NORMAL;
+    switch( advice )
+    {
+    case kAdviceNormal:
+        fadvice = config.posix_advice == EnvConfig::UPS_POSIX_FADVICE_RANDOM ? POSIX_FADV_RANDOM : POSIX_FADV_NORMAL;
+        break;
+    case kAdviceSequential:
+        fadvice = POSIX_FADV_SEQUENTIAL;
+        break;
+    case kAdviceWillNeed:
+        fadvice = POSIX_FADV_WILLNEED;
+        break;
+    }
+
+    // the bytes of file i below address x are at [0, file_size_of(i, x))
+    for( size_t i = 0; i < m_files.size(); i++ )
+    {
+        const uint64_t begin = file_size_of( i, offset );
+        const uint64_t end = file_size_of( i, offset + size );
+        if( end > begin && m_files[i].is_open() )
+        {
+            m_files[i].advise( begin, end - begin, fadvice );
+        }
+    }
+}
+
+//
+// Nothing to do; the files grow exactly as much as required
+//
+void StripedDevice::reclaim_space()
+{
+}
+
+//
+// Starts one worker thread per file
+//
+void StripedDevice::start_workers()
+{
+    m_workers.reset( new WorkerPool( m_files.size() ) );
+}
+
+//
+// Runs the jobs in parallel; the first job is executed by the calling
+// thread, the others by the worker threads of their files
+//
+void StripedDevice::run_parallel( std::vector< boost::function< void() > > &jobs ) const
+{
+    struct Batch
+    {
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t remaining;
+        ups_status_t status;
+    };
+
+    Batch batch;
+    batch.remaining = 0;
+    batch.status = 0;
+
+    size_t first = jobs.size();
+    for( size_t i = 0; i < jobs.size(); i++ )
+    {
+        if( jobs[i].empty() )
+        {
+            continue;
+        }
+
+        if( first == jobs.size() )
+        {
+            first = i;
+            continue;
+        }
+
+        {
+            std::lock_guard< std::mutex > lock( batch.mutex );
+            batch.remaining++;
+        }
+
+        boost::function< void() > *job = &jobs[i];
+        auto task = [ &batch, job ]()
+        {
+            ups_status_t st = 0;
+            try
+            {
+                ( *job )();
+            }
+            catch( Exception &ex )
+            {
+                st = ex.code;
+            }
+
+            std::lock_guard< std::mutex > lock( batch.mutex );
+            if( st != 0 && batch.status == 0 )
+            {
+                batch.status = st;
+            }
+            if( --batch.remaining == 0 )
+            {
+                batch.done.notify_all();
+            }
+        };
+        m_workers->enqueue( task, i );
+    }
+
+    ups_status_t st = 0;
+    if( first < jobs.size() )
+    {
+        try
+        {
+            jobs[first]();
+        }
+        catch( Exception &ex )
+        {
+            st = ex.code;
+        }
+    }
+
+    std::unique_lock< std::mutex > lock( batch.mutex );
+    batch.done.wait( lock, [ &batch ]() { return batch.remaining == 0; } );
+
+    if( st == 0 )
+    {
+        st = batch.status;
+    }
+    if( st != 0 )
+    {
+        throw Exception( st );
+    }
+}
+
+//
+// truncate/resize the device; only the files whose size changes are
+// truncated. sans locking
+//
+void StripedDevice::truncate_nolock( uint64_t new_file_size )
+{
+    if( new_file_size > config.file_size_limit_bytes )
+    {
+        throw Exception( UPS_LIMITS_REACHED );
+    }
+
+    for( size_t i = 0; i < m_files.size(); i++ )
+    {
+        const uint64_t size = file_size_of( i, new_file_size );
+        if( size != file_size_of( i, m_file_size ) )
+        {
+            m_files[i].truncate( size );
+        }
+    }
+    m_file_size = new_file_size;
+}
+
+} // namespace upscaledb
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * Device-implementation which spreads the Environment across several
+ * files (see UPS_PARAM_STRIPE_PATHS), i.e. on different disks.
+ *
+ * The address space is divided into stripes of UPS_PARAM_STRIPE_SIZE
+ * bytes, which are assigned round-robin to the files: stripe k is stored
+ * in file (k % N) at offset (k / N) * stripe_size. The Environment's own
+ * file is the first one. If the stripe size is the page size then the
+ * pages are distributed round-robin; larger stripes keep extents of
+ * adjacent pages in the same file.
+ *
+ * Requests which touch more than one file (flushes, batches of pages and
+ * large writes) are split, and each file is served by its own worker
+ * thread.
+ *
+ * The files are not mapped; pages are always read into buffers.
+ *
+ * @exception_safe: basic
+ * @thread_safe: yes
+ */
+
+#ifndef UPS_DEVICE_STRIPED_H
+#define UPS_DEVICE_STRIPED_H
+
+#include <vector>
+#include <memory>
+#include <boost/function.hpp>
+
+#include "0root/root.h"
+
+#include "1base/spinlock.h"
+#include "1os/file.h"
+#include "2device/device.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+struct WorkerPool;
+
+class StripedDevice : public Device
+{
+public:
+    // A part of a request which is stored in a single file
+    struct Extent
+    {
+        // the index of the file
+        size_t file;
+
+        // the offset in this file
+        uint64_t file_offset;
+
+        // the offset in the address space of the device
+        uint64_t address;
+
+        // the size of this part
+        size_t size;
+    };
+
+    StripedDevice( const EnvConfig &config );
+    ~StripedDevice();
+
+    void create() override;
+    void open() override;
+    bool is_open() const override;
+    void close() override;
+    void flush() const override;
+    void truncate( uint64_t new_file_size ) override;
+    uint64_t file_size() const override;
+    void seek( uint64_t offset, int whence ) const override;
+    uint64_t tell() const override;
+
+    void read( uint64_t offset, void *buffer, size_t len ) const override;
+    void write( uint64_t offset, void *buffer, size_t len ) const override;
+    void write_vectored( uint64_t offset, const struct iovec *iov, size_t count ) const override;
+
+    uint64_t alloc( size_t requested_length ) override;
+    void read_page( Page *page, uint64_t address ) const override;
+    void read_pages( Page * const *pages, const uint64_t *addresses, size_t count ) const override;
+    void alloc_page( Page *page ) override;
+    void free_page( Page *page ) override;
+
+    bool is_mapped( uint64_t file_offset, size_t size ) const override;
+    void advise( uint64_t offset, uint64_t size, int advice ) const override;
+    void reclaim_space() override;
+
+    // Returns the number of files
+    size_t stripe_count() const;
+
+    // Splits the range of |len| bytes at |offset| into the parts which
+    // are stored in the same file
+    std::vector< Extent > split( uint64_t offset, uint64_t len ) const;
+
+    // Returns the size of the file |index| if the device has |size| bytes
+    uint64_t file_size_of( size_t index, uint64_t size ) const;
+
+    // Splits a list of paths, separated by ';'
+    static std::vector< std::string > split_paths( const std::string &paths );
+
+private:
+    // Returns the paths of all files; the Environment's file is the first
+    std::vector< std::string > paths() const;
+
+    // Starts the worker threads
+    void start_workers();
+
+    // Runs the |jobs| in parallel; job i accesses file i and is executed
+    // by the worker thread of this file. Empty jobs are skipped. Rethrows
+    // the first error
+    void run_parallel( std::vector< boost::function< void() > > &jobs ) const;
+
+    // truncate/resize the device, sans locking
+    void truncate_nolock( uint64_t new_file_size );
+
+private:
+    // For synchronizing access to the sizes
+    mutable Spinlock m_mutex;
+
+    // the files; the Environment's file is the first one
+    std::vector< File > m_files;
+
+    // the size of a stripe
+    uint64_t m_stripe_size;
+
+    // the size of the device
+    uint64_t m_file_size;
+
+    // one worker thread per file
+    std::unique_ptr< WorkerPool > m_workers;
+};
+
+} // namespace upscaledb
+
+#endif /* UPS_DEVICE_STRIPED_H */
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+#include "device_uring.h"
+#include <vector>
+#include "2page/page.h"
+
+namespace upscaledb {
+
+//
+//
+//
+UringDevice::UringDevice( const EnvConfig &config )
+    : DiskDevice( config )
+{
+}
+
+//
+// Create a new device, then set up the ring
+//
+void UringDevice::create()
+{
+    DiskDevice::create();
+    init_ring();
+}
+
+//
+// opens an existing device, then set up the ring
+//
+void UringDevice::open()
+{
+    DiskDevice::open();
+    init_ring();
+}
+
+//
+// closes the ring and the device
+//
+void UringDevice::close()
+{
+    {
+        std::lock_guard< std::mutex > guard( m_ring_mutex );
+        m_ring.reset();
+    }
+    DiskDevice::close();
+}
+
+//
+// Returns true if the reads are performed with io_uring
+//
+bool UringDevice::is_uring_active() const
+{
+    std::lock_guard< std::mutex > guard( m_ring_mutex );
+    return m_ring && m_ring->is_active();
+}
+
+//
+//
+//
+void UringDevice::init_ring()
+{
+    std::lock_guard< std::mutex > guard( m_ring_mutex );
+    std::unique_ptr< IoUring > ring( new IoUring );
+    if( ring->init( kQueueDepth ) )
+    {
+        m_ring = std::move( ring );
+    }
+}
+
+//
+// Reads a batch of pages; mapped pages are assigned directly, all others
+// are submitted to the ring. Failed or incomplete reads are repeated with
+// pread(), which throws if the page cannot be read.
+//
+void UringDevice::read_pages( Page * const *pages, const uint64_t *addresses, size_t count ) const
+{
+    std::lock_guard< std::mutex > guard( m_ring_mutex );
+
+    if( !m_ring || config.is_encryption_enabled )
+    {
+        Device::read_pages( pages, addresses, count );
+        return;
+    }
+
+    const uint32_t page_size = config.page_size_bytes;
+    std::vector< size_t > queued;
+    queued.reserve( count );
+
+    for( size_t i = 0; i < count; i++ )
+    {
+        bool is_mapped;
+        {
+            ScopedSpinlock lock( m_mutex );
+            is_mapped = m_state.mmapptr != 0 && map_nolock( addresses[i] + page_size );
+        }
+
+        if( is_mapped )
+        {
+            read_page( pages[i], addresses[i] );
+            pages[i]->set_address( addresses[i] );
+            continue;
+        }
+
+        if( pages[i]->data() == 0 )
+        {
+            allocate_page_buffer( pages[i], addresses[i] );
+        }
+        queued.push_back( i );
+    }
+
+    const int fd = m_state.file.descriptor();
+    std::vector< size_t > failed;
+    size_t next = 0;
+    unsigned in_flight = 0;
+
+    while( next < queued.size() || in_flight > 0 )
+    {
+        // keep the queue filled, but do not exceed the capacity of the
+        // completion queue
+        while( next < queued.size()
+               && in_flight < m_ring->capacity()
+               && m_ring->prepare_read( fd, pages[ queued[next] ]->data(), page_size,
+                                        addresses[ queued[next] ], queued[next] ) )
+        {
+            next++;
+            in_flight++;
+        }
+
+        m_ring->submit( 1 );
+
+        uint64_t index;
+        int result;
+        while( m_ring->reap( &index, &result ) )
+        {
+            in_flight--;
+            if( result != (int)page_size )
+            {
+                failed.push_back( (size_t)index );
+            }
+        }
+    }
+
+    for( size_t i = 0; i < failed.size(); i++ )
+    {
+        m_state.file.pread( addresses[ failed[i] ], pages[ failed[i] ]->data(), page_size );
+    }
+
+    for( size_t i = 0; i < queued.size(); i++ )
+    {
+        pages[ queued[i] ]->set_address( addresses[ queued[i] ] );
+    }
+}
+
+} // namespace upscaledb
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * Device-implementation for disk-based files which reads batches of pages
+ * with io_uring (see UPS_PARAM_IO_BACKEND). Many reads of read_pages() are
+ * in flight at the same time; single pages and writes use the code paths
+ * of the DiskDevice.
+ *
+ * If the kernel does not support io_uring then all reads fall back to
+ * pread().
+ *
+ * Page buffers are not registered with the ring (IORING_REGISTER_BUFFERS):
+ * they are allocated on demand (from the heap or the page arena) and are
+ * not known in advance.
+ *
+ * @exception_safe: basic
+ * @thread_safe: no
+ */
+
+#ifndef UPS_DEVICE_URING_H
+#define UPS_DEVICE_URING_H
+
+#include <mutex>
+
+#include "0root/root.h"
+
+#include "1os/io_uring.h"
+#include "2device/device_disk.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+class UringDevice : public DiskDevice
+{
+public:
+    enum
+    {
+        // the maximum number of reads in flight
+        kQueueDepth = 64
+    };
+
+    UringDevice( const EnvConfig &config );
+
+    void create() override;
+    void open() override;
+    void close() override;
+
+    void read_pages( Page * const *pages, const uint64_t *addresses, size_t count ) const override;
+
+    bool is_uring_active() const;
+
+private:
+    // sets up the ring; falls back to pread() if this fails
+    void init_ring();
+
+private:
+    // serializes access to |m_ring|
+    mutable std::mutex m_ring_mutex;
+
+    // the submission and completion queues
+    mutable std::unique_ptr< IoUring > m_ring;
+};
+
+} // namespace upscaledb
+
+#endif /* UPS_DEVICE_URING_H */
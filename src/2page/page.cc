@@ -19,8 +19,10 @@
 #include "0root/root.h"
 
 #include <cstring>
+#include <vector>
 #include "3rdparty/murmurhash3/MurmurHash3.h"
 
+#include "1base/crc32c.h"
 #include "1base/error.h"
 #include "1os/os.h"
 #include "2page/page.h"
@@ -44,6 +46,9 @@ Page::Page( Device *device, LocalDb *db )
     persisted_data.is_allocated = false;
     persisted_data.address = 0;
     persisted_data.size = (uint32_t)device->page_size();
+    cache_referenced = false;
+    cache_protected = false;
+    cache_priority = 0;
 }
 
 //
@@ -87,11 +92,23 @@ void Page::alloc(uint32_t type, uint32_t flags)
 }
 
 //
+// Reads the page from the device. If |verify_crc32| is set then the
+// Device verifies the checksum of a page which is read from the file
 //
-//
-void Page::fetch( uint64_t address )
+void Page::fetch( uint64_t address, bool verify_crc32 )
 {
-    device_->read_page( this, address );
+    set_address( address );
+    persisted_data.verify_on_read = verify_crc32;
+    try
+    {
+        device_->read_page( this, address );
+    }
+    catch( Exception & )
+    {
+        persisted_data.verify_on_read = false;
+        throw;
+    }
+    persisted_data.verify_on_read = false;
     set_address( address );
 }
 
@@ -102,20 +119,102 @@ void Page::flush()
 {
     if( persisted_data.is_dirty )
     {
-        // update crc32
-        if( IS_SET( device_->config.flags, UPS_ENABLE_CRC32 ) && likely( !persisted_data.is_without_header ) )
-        {
-            MurmurHash3_x86_32( persisted_data.raw_data->header.payload,
-                                persisted_data.size - (sizeof(PPageHeader) - 1),
-                                (uint32_t)persisted_data.address,
-                                &persisted_data.raw_data->header.crc32 );
-        }
+        update_crc32();
         device_->write( persisted_data.address, persisted_data.raw_data, persisted_data.size );
         persisted_data.is_dirty = false;
         ms_page_count_flushed++;
     }
 }
 
+//
+// Updates the crc32 before the page is written (if enabled)
+//
+void Page::update_crc32()
+{
+    if( IS_SET( device_->config.flags, UPS_ENABLE_CRC32 ) && likely( !persisted_data.is_without_header ) )
+    {
+        persisted_data.raw_data->header.crc32 = calculate_crc32();
+    }
+}
+
+//
+// Calculates the checksum of the payload with the algorithm of the
+// Environment (see UPS_PARAM_CRC32_ALGORITHM)
+//
+uint32_t Page::calculate_crc32()
+{
+    const uint8_t *payload = persisted_data.raw_data->header.payload;
+    const size_t size = persisted_data.size - ( sizeof( PPageHeader ) - 1 );
+    const uint32_t seed = (uint32_t)persisted_data.address;
+
+    if( device_->config.crc32_algorithm == UPS_CRC32_CRC32C )
+    {
+        return crc32c( payload, size, seed );
+    }
+
+    uint32_t crc32;
+    MurmurHash3_x86_32( payload, (int)size, seed, &crc32 );
+    return crc32;
+}
+
+//
+// Flushes the dirty pages of a list which is sorted by address. Each run
+// of adjacent pages is written with a single call to
+// Device::write_vectored(); the crc32 is still updated per page.
+//
+void Page::flush( Page * const *pages, size_t count )
+{
+    std::vector< struct iovec > iov;
+    size_t i = 0;
+
+    while( i < count )
+    {
+        Page *first = pages[i];
+        if( !first->persisted_data.is_dirty )
+        {
+            i++;
+            continue;
+        }
+
+        // collect the adjacent dirty pages which use the same device
+        size_t end = i + 1;
+        uint64_t next = first->persisted_data.address + first->persisted_data.size;
+        while( end < count
+               && pages[end]->persisted_data.is_dirty
+               && pages[end]->device_ == first->device_
+               && pages[end]->persisted_data.address == next )
+        {
+            next += pages[end]->persisted_data.size;
+            end++;
+        }
+
+        if( end - i == 1 )
+        {
+            first->flush();
+            i = end;
+            continue;
+        }
+
+        iov.resize( end - i );
+        for( size_t j = i; j < end; j++ )
+        {
+            Page *page = pages[j];
+            page->update_crc32();
+            iov[j - i].iov_base = page->persisted_data.raw_data;
+            iov[j - i].iov_len = page->persisted_data.size;
+        }
+
+        first->device_->write_vectored( first->persisted_data.address, iov.data(), iov.size() );
+
+        for( size_t j = i; j < end; j++ )
+        {
+            pages[j]->persisted_data.is_dirty = false;
+        }
+        ms_page_count_flushed += end - i;
+        i = end;
+    }
+}
+
 //
 //
 //
@@ -298,13 +397,15 @@ void Page::set_without_header( bool is_without_header )
 }
 
 //
-// Assign a buffer which was allocated with malloc()
+// Assign a buffer which was allocated with malloc() (or taken from
+// the |arena|, if it is not null)
 //
-void Page::assign_allocated_buffer( void* buffer, uint64_t address )
+void Page::assign_allocated_buffer( void* buffer, uint64_t address, PageArena *arena )
 {
     free_buffer();
     persisted_data.raw_data = (PPageData *)buffer;
     persisted_data.is_allocated = true;
+    persisted_data.arena = arena;
     persisted_data.address = address;
 }
 
@@ -316,6 +417,7 @@ void Page::assign_mapped_buffer( void* buffer, uint64_t address )
     free_buffer();
     persisted_data.raw_data = (PPageData *)buffer;
     persisted_data.is_allocated = false;
+    persisted_data.arena = nullptr;
     persisted_data.address = address;
 }
 
@@ -138,13 +138,17 @@ public:
     bool is_without_header() const;
     void set_without_header( bool is_without_header );
 
-    void assign_allocated_buffer( void *buffer, uint64_t address );
+    void assign_allocated_buffer( void *buffer, uint64_t address, PageArena *arena = nullptr );
     void assign_mapped_buffer( void *buffer, uint64_t address );
 
     void free_buffer();
     void alloc( uint32_t type, uint32_t flags = 0 );
-    void fetch( uint64_t address );
+    void fetch( uint64_t address, bool verify_crc32 = false );
     void flush();
+    void update_crc32();
+    uint32_t calculate_crc32();
+
+    static void flush( Page * const *pages, size_t count );
 
     BtreeNodeProxy *node_proxy();
     void set_node_proxy( BtreeNodeProxy* proxy );
@@ -166,6 +170,16 @@ public:
     // Intrusive linked btree cursors
     IntrusiveList< BtreeCursor > cursor_list;
 
+    // Reference bit of the CLOCK replacement policy; set by the Cache
+    // whenever the page is accessed
+    bool cache_referenced;
+
+    // True if the page is in the protected segment of the Cache (SLRU)
+    bool cache_protected;
+
+    // The priority class of the page in the Cache
+    uint8_t cache_priority;
+
 private:
     // the Device for allocating storage
     Device* device_;
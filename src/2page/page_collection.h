@@ -162,6 +162,19 @@ public:
         return false;
     }
 
+    // Adds a new page at the tail of the list. Returns true if the page was
+    // added, otherwise false (that's the case if the page is already part of
+    // the list)
+    bool append( Page *page )
+    {
+        if( !list.has( page ) )
+        {
+            list.append( page );
+            return true;
+        }
+        return false;
+    }
+
     // Returns true if a page with the |address| is already stored.
     // This is expensive!
     bool has( uint64_t address ) const
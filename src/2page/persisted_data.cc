@@ -10,7 +10,9 @@ PersistedData::PersistedData()
     , is_dirty( false )
     , is_allocated( false )
     , is_without_header( false )
+    , verify_on_read( false )
     , raw_data( nullptr )
+    , arena( nullptr )
 {
 }
 
@@ -22,7 +24,14 @@ PersistedData::~PersistedData()
 #endif
     if( is_allocated )
     {
-        Memory::release( raw_data );
+        if( arena )
+        {
+            arena->release( raw_data );
+        }
+        else
+        {
+            Memory::release( raw_data );
+        }
     }
     raw_data = nullptr;
 }
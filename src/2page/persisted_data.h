@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include "1base/spinlock.h"
+#include "1mem/page_arena.h"
 #include "ppage_data.h"
 
 namespace upscaledb {
@@ -39,8 +40,16 @@ struct PersistedData
     // True if page has no persistent header
     bool is_without_header;
 
+    // True if the Device verifies the checksum while the page is read
+    // (see Page::fetch())
+    bool verify_on_read;
+
     // the persistent data of this page
     PPageData *raw_data;
+
+    // the arena which allocated |raw_data|; null if the buffer was
+    // allocated with malloc()
+    PageArena *arena;
 };
 
 
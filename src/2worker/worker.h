@@ -17,7 +17,23 @@
  */
 
 /*
- * The worker thread
+ * The worker threads
+ *
+ * Each thread has its own queue. Work items are either assigned to the
+ * queue of a partition (i.e. the PageManager partitions dirty pages by
+ * their address), or are distributed round-robin. A thread first processes
+ * its own queue in FIFO order; if it is empty then it steals work from the
+ * tail of another queue.
+ *
+ * Therefore work items are only executed in order if the pool has a single
+ * thread. Callers which depend on previously enqueued items (i.e. before
+ * flushing all pages) use wait_for_pending().
+ *
+ * The queues are protected by a single mutex; work items are coarse
+ * (a list of pages), and the lock is not held while they are executed.
+ *
+ * @exception_safe: basic
+ * @thread_safe: yes
  */
 
 #ifndef UPS_WORKER_H
@@ -25,10 +41,13 @@
 
 #include "0root/root.h"
 
-#include <boost/asio.hpp>
-#include <boost/thread/thread.hpp>
+#include <set>
+#include <deque>
+#include <vector>
+#include <boost/function.hpp>
 
 // Always verify that a file of level N does not include headers > N!
+#include "1base/mutex.h"
 #include "2worker/workitem.h"
 
 #ifndef UPS_ROOT_H
@@ -41,33 +60,73 @@ struct WorkerPool;
  
 // our worker thread objects
 struct WorkerThread {
-  WorkerThread(WorkerPool &s)
-    : pool(s) {
+  WorkerThread(WorkerPool &s, size_t index_)
+    : pool(s), index(index_) {
   }
 
   void operator()();
 
   WorkerPool &pool; 
+
+  // the index of this thread's queue
+  size_t index;
 };
  
 // the actual thread pool
 struct WorkerPool {
+  // A queued work item
+  struct Task {
+    // the function which is executed
+    boost::function<void ()> function;
+
+    // a sequence number, used by wait_for_pending()
+    uint64_t sequence;
+  };
+
   // the constructor just launches some amount of workers
   WorkerPool(size_t num_threads)
-    : working(service), strand(service) {
-    for (size_t i = 0; i < num_threads; ++i)
-      workers.push_back(new boost::thread(WorkerThread(*this)));
+    : queues(num_threads > 0 ? num_threads : 1), next_queue(0),
+      next_sequence(0), stopping(false) {
+    for (size_t i = 0; i < queues.size(); ++i)
+      workers.push_back(new Thread(WorkerThread(*this, i)));
   }
 
   // Add a new work item to the pool
   template<typename F>
   void enqueue(F &f) {
-    strand.post(f);
+    ScopedLock lock(mutex);
+    push(f, next_queue++);
   }
 
-  // the destructor joins all threads
+  // Add a new work item to the queue of |partition|
+  template<typename F>
+  void enqueue(F &f, size_t partition) {
+    ScopedLock lock(mutex);
+    push(f, partition);
+  }
+
+  // Returns the number of threads
+  size_t size() const {
+    return queues.size();
+  }
+
+  // Blocks till all work items, which were enqueued before this call,
+  // were processed
+  void wait_for_pending() {
+    ScopedLock lock(mutex);
+    uint64_t sequence = next_sequence;
+    while (!pending.empty() && *pending.begin() < sequence)
+      completed.wait(lock);
+  }
+
+  // the destructor processes the remaining work items, then joins all
+  // threads
   ~WorkerPool() {
-    service.stop();
+    {
+      ScopedLock lock(mutex);
+      stopping = true;
+      available.notify_all();
+    }
 
     for (size_t i = 0; i < workers.size(); ++i) {
       workers[i]->join();
@@ -75,22 +134,85 @@ struct WorkerPool {
     }
   }
 
+  // Appends a work item to a queue; the caller holds |mutex|
+  template<typename F>
+  void push(F &f, size_t queue) {
+    Task task;
+    task.function = f;
+    task.sequence = next_sequence++;
+    pending.insert(task.sequence);
+    queues[queue % queues.size()].push_back(task);
+    available.notify_all();
+  }
+
+  // Retrieves the next work item for the thread |index|; first from its
+  // own queue, then from the tail of the other queues. Blocks till work is
+  // available. Returns false if the pool is stopped and all queues are
+  // empty.
+  bool pop(size_t index, Task &task) {
+    ScopedLock lock(mutex);
+    while (true) {
+      if (!queues[index].empty()) {
+        task = queues[index].front();
+        queues[index].pop_front();
+        return true;
+      }
+      for (size_t i = 1; i < queues.size(); i++) {
+        std::deque<Task> &victim = queues[(index + i) % queues.size()];
+        if (!victim.empty()) {
+          task = victim.back();
+          victim.pop_back();
+          return true;
+        }
+      }
+      if (stopping)
+        return false;
+      available.wait(lock);
+    }
+  }
+
+  // Marks a work item as completed
+  void complete(const Task &task) {
+    ScopedLock lock(mutex);
+    pending.erase(task.sequence);
+    completed.notify_all();
+  }
+
   // keep track of the threads so we can join them
-  std::vector<boost::thread *> workers;
-   
-  // the io_service we are wrapping
-  boost::asio::io_service service;
-  boost::asio::io_service::work working;
-#if BOOST_VERSION < 106600
-  boost::asio::strand strand;
-#else
-  boost::asio::io_context::strand strand;
-#endif
+  std::vector<Thread *> workers;
+
+  // protects the queues
+  boost::mutex mutex;
+
+  // signalled when a work item is enqueued, or when the pool is stopped
+  Condition available;
+
+  // signalled when a work item was completed
+  Condition completed;
+
+  // one queue per thread
+  std::vector<std::deque<Task> > queues;
+
+  // the queue for the next work item without a partition
+  size_t next_queue;
+
+  // the sequence number of the next work item
+  uint64_t next_sequence;
+
+  // the sequence numbers of the items which are queued or in progress
+  std::set<uint64_t> pending;
+
+  // set when the pool is destroyed
+  bool stopping;
 };
 
 inline void
 WorkerThread::operator()() {
-  pool.service.run();
+  WorkerPool::Task task;
+  while (pool.pop(index, task)) {
+    task.function();
+    pool.complete(task);
+  }
 }
  
 } // namespace upscaledb
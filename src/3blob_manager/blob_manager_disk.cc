@@ -216,7 +216,7 @@ read_chunk(DiskBlobManager *dbm, Context *context, Page *page, Page **ppage,
   else
     data = page->raw_payload();
 
-  uint32_t read_start = (uint32_t)(address - page->address());
+  uint32_t read_start = (uint32_t)(address - pageid);
   return &data[read_start];
 }
 
@@ -202,7 +202,7 @@ move_next(BtreeCursor *cursor, Context *context, uint32_t flags)
     return UPS_KEY_NOT_FOUND;
 
   Page *page = env->page_manager->fetch(context, node->right_sibling(),
-                    PageManager::kReadOnly);
+                    PageManager::kReadOnly | PageManager::kScan);
   node = st_.btree->get_node_from_page(page);
 
   // if the right node is empty then continue searching for the next
@@ -211,13 +211,17 @@ move_next(BtreeCursor *cursor, Context *context, uint32_t flags)
     if (unlikely(!node->right_sibling()))
       return UPS_KEY_NOT_FOUND;
     page = env->page_manager->fetch(context, node->right_sibling(),
-                    PageManager::kReadOnly);
+                    PageManager::kReadOnly | PageManager::kScan);
     node = st_.btree->get_node_from_page(page);
   }
 
   // couple this cursor to the smallest key in this page
   cursor->couple_to(page, 0, 0);
 
+  // read ahead the next leaf
+  if (node->right_sibling())
+    env->page_manager->prefetch(node->right_sibling());
+
   return 0;
 }
 
@@ -518,8 +522,13 @@ BtreeCursor::move_to_next_page(Context *context)
   }
 
   Page *page = env->page_manager->fetch(context, node->right_sibling(),
-                        PageManager::kReadOnly);
+                        PageManager::kReadOnly | PageManager::kScan);
   couple_to(page, 0, 0);
+
+  // read ahead the next leaf while this one is scanned
+  node = st_.btree->get_node_from_page(page);
+  if (node->right_sibling())
+    env->page_manager->prefetch(node->right_sibling());
   return 0;
 }
 
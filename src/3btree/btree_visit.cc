@@ -23,6 +23,7 @@
 #include "0root/root.h"
 
 // Always verify that a file of level N does not include headers > N!
+#include "2device/device.h"
 #include "3page_manager/page_manager.h"
 #include "3btree/btree_index.h"
 #include "3btree/btree_node_proxy.h"
@@ -82,16 +83,22 @@ struct BtreeVisitAction
 
     assert(page != 0);
 
-    // now visit all leaf nodes
+    // now visit all leaf nodes; they are read sequentially, and the right
+    // sibling is read ahead while the current node is visited
+    ScopedSequentialAdvice advice(env->device.get());
     while (page) {
       BtreeNodeProxy *node = btree->get_node_from_page(page);
       uint64_t right = node->right_sibling();
 
+      if (likely(right))
+        env->page_manager->prefetch(right);
+
       visitor(context, node);
 
       /* follow the pointer to the right sibling */
       if (likely(right))
-        page = env->page_manager->fetch(context, right, page_manager_flags);
+        page = env->page_manager->fetch(context, right,
+                        page_manager_flags | PageManager::kScan);
       else
         break;
     }
@@ -26,6 +26,35 @@
  * at the head. The tail therefore points to the page which was not used
  * in a long time, and is the primary candidate for purging.
  *
+ * Alternatively the CLOCK policy can be used (see UPS_PARAM_CACHE_POLICY):
+ * a cache hit then only sets a reference bit in the page, and the cache
+ * is purged by moving a "clock hand" over the list of pages.
+ *
+ * The SLRU policy splits the list into a probationary and a protected
+ * segment. New pages are stored in the probationary segment, and are
+ * promoted to the protected segment when they are accessed again. Pages
+ * which are read by sequential scans are never promoted, and are inserted
+ * at the tail of the probationary segment. Scans therefore do not evict
+ * the frequently used pages.
+ *
+ * Internal nodes of the B+tree are purged only after all other pages
+ * (leaf nodes, blobs etc). A part of the cache can be reserved for
+ * internal nodes (see UPS_PARAM_CACHE_INTERNAL_NODES); these are then not
+ * purged at all.
+ *
+ * The hash table is sized for the capacity of the cache when the
+ * Environment is opened. If it stores more pages than it has buckets then
+ * the number of buckets is doubled, and the pages are migrated to the new
+ * table in small steps.
+ *
+ * Optionally a sample of the accessed pages is used to estimate the hit
+ * ratio at other cache sizes (see UPS_PARAM_CACHE_SAMPLING and
+ * cache_sampler.h).
+ *
+ * The cache can be split into several shards (see UPS_PARAM_CACHE_SHARDS).
+ * Pages are partitioned by their address; each shard has its own buckets,
+ * its own LRU list and its own lock, and is purged independently.
+ *
  * @exception_safe: nothrow
  * @thread_safe: yes
  */
@@ -36,6 +65,7 @@
 #include "0root/root.h"
 
 #include <vector>
+#include <algorithm>
 
 #include "ups/upscaledb_int.h"
 
@@ -44,6 +74,7 @@
 #include "2page/page_collection.h"
 #include "2config/env_config.h"
 #include "3cache/cache_state.h"
+#include "3btree/btree_node.h"
 
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
@@ -52,30 +83,46 @@
 namespace upscaledb {
 
 namespace Impl {
-// Calculates the hash of a page address
-static inline size_t
+// Calculates the hash of a page address. Page addresses are aligned to the
+// page size, therefore the bits are mixed (this is the finalizer of
+// MurmurHash3) before the lower bits are used as the bucket index
+static inline uint64_t
 calc_hash(uint64_t value)
 {
-  return (size_t)(value % CacheState::kBucketSize);
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdull;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ull;
+  value ^= value >> 33;
+  return value;
 }
 } // namespace Impl
 
 struct Cache
 {
+  // The priority classes of cached pages
+  enum {
+    // leaf nodes, blob pages and all other pages
+    kPriorityDefault = 0,
+
+    // internal B+tree nodes; these are purged last
+    kPriorityInternalNode = 1
+  };
+
   template<typename Purger>
   struct PurgeIfSelector {
-    PurgeIfSelector(Cache *cache, Purger &purger)
-      : cache_(cache), purger_(purger) {
+    PurgeIfSelector(CacheShard *shard, Purger &purger)
+      : shard_(shard), purger_(purger) {
     }
 
     bool operator()(Page *page) {
       if (purger_(page))
-        cache_->del(page);
+        Cache::remove(shard_, page);
       // don't remove page from list; it was already removed above
       return false;
     }
 
-    Cache *cache_;
+    CacheShard *shard_;
     Purger &purger_;
   };
 
@@ -85,88 +132,281 @@ struct Cache
   }
 
   // Fills in the current metrics
-  void fill_metrics(ups_env_metrics_t *metrics) const {
-    metrics->cache_hits = state.cache_hits;
-    metrics->cache_misses = state.cache_misses;
+  void fill_metrics(ups_env_metrics_t *metrics) {
+    metrics->cache_hits = 0;
+    metrics->cache_misses = 0;
+    metrics->cache_buckets = 0;
+    metrics->cache_avg_chain_length = 0;
+
+    uint64_t elements = 0;
+    uint64_t used_buckets = 0;
+    for (size_t i = 0; i < state.shards.size(); i++) {
+      CacheShard *shard = &state.shards[i];
+      ScopedSpinlock lock(shard->mutex);
+      metrics->cache_hits += shard->cache_hits;
+      metrics->cache_misses += shard->cache_misses;
+      metrics->cache_buckets += shard->buckets.size()
+                                  + shard->old_buckets.size();
+      for (size_t j = 0; j < shard->buckets.size(); j++) {
+        elements += shard->buckets[j].size();
+        used_buckets += !shard->buckets[j].is_empty();
+      }
+      for (size_t j = 0; j < shard->old_buckets.size(); j++) {
+        elements += shard->old_buckets[j].size();
+        used_buckets += !shard->old_buckets[j].is_empty();
+      }
+    }
+    if (used_buckets > 0)
+      metrics->cache_avg_chain_length = (double)elements / used_buckets;
+
+    if (state.sampler)
+      state.sampler->fill_metrics(metrics, state.page_size_bytes);
   }
 
   // Retrieves a page from the cache, also removes the page from the cache
   // and re-inserts it at the front. Returns null if the page was not cached.
-  Page *get(uint64_t address) {
-    size_t hash = Impl::calc_hash(address);
-
-    Page *page = state.buckets[hash].get(address);
+  // If |is_scan| is true then the page is accessed by a sequential scan,
+  // and its position in the cache is not updated.
+  Page *get(uint64_t address, bool is_scan = false) {
+    // only a small part of the pages is sampled; the sampler has its
+    // own lock
+    if (state.sampler && state.sampler->is_sampled(Impl::calc_hash(address)))
+      state.sampler->access(address);
+
+    CacheShard *shard = shard_of(address);
+    ScopedSpinlock lock(shard->mutex);
+
+    Page *page = bucket_of(shard, address).get(address);
     if (!page) {
-      state.cache_misses++;
+      shard->cache_misses++;
       return 0;
     }
 
+    shard->cache_hits++;
+    reclassify(shard, page);
+    if (is_scan)
+      return page;
+
+    // CLOCK: only set the reference bit; the list is not modified
+    if (state.policy == UPS_CACHE_POLICY_CLOCK) {
+      page->cache_referenced = true;
+      return page;
+    }
+
+    // SLRU: move the page to the head of the protected segment
+    if (state.policy == UPS_CACHE_POLICY_SLRU) {
+      promote(shard, page);
+      return page;
+    }
+
     // Now re-insert the page at the head of the "totallist", and
     // thus move far away from the tail. The pages at the tail are highest
     // candidates to be deleted when the cache is purged.
-    state.totallist.del(page);
-    state.totallist.put(page);
-    state.cache_hits++;
+    shard->totallist.del(page);
+    shard->totallist.put(page);
     return page;
   }
 
-  // Stores a page in the cache
-  void put(Page *page) {
-    size_t hash = Impl::calc_hash(page->address());
+  // Stores a page in the cache. Pages which are read by a sequential scan
+  // (|is_scan| is true) are inserted at the tail of the list, and will
+  // be purged first.
+  void put(Page *page, bool is_scan = false) {
+    CacheShard *shard = shard_of(page->address());
+    ScopedSpinlock lock(shard->mutex);
+
+    /* A protected page (SLRU) which is stored again is treated like a
+     * cache hit */
+    if (page->cache_protected) {
+      promote(shard, page);
+      return;
+    }
 
     /* First remove the page from the cache, if it's already cached
      *
      * Then re-insert the page at the head of the list. The tail will
      * point to the least recently used page.
      */
-    state.totallist.del(page);
-    state.totallist.put(page);
+    unlink(shard, page);
+    if (is_scan && state.policy != UPS_CACHE_POLICY_CLOCK)
+      shard->totallist.append(page);
+    else
+      shard->totallist.put(page);
     if (page->is_allocated())
-      state.alloc_elements++;
+      shard->alloc_elements++;
+    page->cache_referenced = !is_scan;
+    reclassify(shard, page);
 
-    state.buckets[hash].put(page);
+    grow_if_required(shard);
+    bucket_of(shard, page->address()).put(page);
+  }
+
+  // Returns true if a page with the |address| is cached. Unlike get(),
+  // this does not update the cache statistics or the position of the page
+  bool has(uint64_t address) {
+    CacheShard *shard = shard_of(address);
+    ScopedSpinlock lock(shard->mutex);
+    return bucket_of(shard, address).get(address) != 0;
+  }
+
+  // Collects the addresses of up to |limit| cached pages, the most
+  // recently used pages first. The shards are visited in turns. Pages
+  // without a persistent header (i.e. of multi-page blobs) are skipped
+  void recent_pages(std::vector<uint64_t> &addresses, size_t limit) {
+    std::vector<std::vector<uint64_t> > lists(state.shards.size());
+    for (size_t i = 0; i < state.shards.size(); i++) {
+      CacheShard *shard = &state.shards[i];
+      ScopedSpinlock lock(shard->mutex);
+      Page *page = shard->hotlist.head();
+      for (; page != 0 && lists[i].size() < limit;
+              page = page->next(Page::kListCache))
+        if (!page->is_without_header())
+          lists[i].push_back(page->address());
+      page = shard->totallist.head();
+      for (; page != 0 && lists[i].size() < limit;
+              page = page->next(Page::kListCache))
+        if (!page->is_without_header())
+          lists[i].push_back(page->address());
+    }
+
+    for (size_t j = 0; addresses.size() < limit; j++) {
+      bool found = false;
+      for (size_t i = 0; i < lists.size() && addresses.size() < limit; i++) {
+        if (j < lists[i].size()) {
+          addresses.push_back(lists[i][j]);
+          found = true;
+        }
+      }
+      if (!found)
+        break;
+    }
   }
 
   // Removes a page from the cache
   void del(Page *page) {
     assert(page->address() != 0);
 
-    /* remove it from the list of all cached pages */
-    if (state.totallist.del(page) && page->is_allocated())
-      state.alloc_elements--;
-
-    /* remove the page from the cache buckets */
-    size_t hash = Impl::calc_hash(page->address());
-    state.buckets[hash].del(page);
+    CacheShard *shard = shard_of(page->address());
+    ScopedSpinlock lock(shard->mutex);
+    remove(shard, page);
   }
 
-  // Purges the cache. Implements a LRU eviction algorithm. Dirty pages are
+  // Purges the cache. Implements a LRU or a CLOCK eviction algorithm,
+  // depending on the configured policy. Dirty pages are
   // forwarded to the |processor()| for flushing.
   // The |ignore_page| is passed by the caller; this page will not be purged
   // under any circumstance. This is used by the PageManager to make sure
   // that the "last blob page" is not evicted by the cache.
+  //
+  // Each shard is purged independently; the number of pages to evict is
+  // distributed proportionally to the number of pages in each shard.
   void purge_candidates(std::vector<uint64_t> &candidates,
                   std::vector<Page *> &garbage,
                   Page *ignore_page) {
-    int limit = (int)(current_elements()
+    size_t elements = current_elements();
+    int limit = (int)(elements
                       - (state.capacity_bytes / state.page_size_bytes));
+    if (limit <= 0)
+      return;
+
+    for (size_t i = 0; i < state.shards.size(); i++) {
+      CacheShard *shard = &state.shards[i];
+      ScopedSpinlock lock(shard->mutex);
+
+      size_t shard_elements = shard->totallist.size() + shard->hotlist.size();
+      int shard_limit = (int)(((uint64_t)limit * shard_elements
+                                + elements - 1) / elements);
+
+      // Internal index nodes are only purged after all other pages, and
+      // only if they exceed their reserved budget
+      int found = select_pages(shard, shard_limit, kPriorityDefault,
+                      candidates, garbage, ignore_page);
+      if (found < shard_limit
+            && shard->internal_elements > state.internal_node_limit)
+        select_pages(shard, std::min(shard_limit - found,
+                        (int)(shard->internal_elements
+                                - state.internal_node_limit)),
+                        kPriorityInternalNode, candidates, garbage,
+                        ignore_page);
+    }
+  }
 
-    Page *page = state.totallist.tail();
-    for (int i = 0; i < limit && page != 0; i++) {
-      if (page->mutex().try_lock()) {
-        if (page->cursor_list.size() == 0
-              && page != ignore_page
-              && page->type() != Page::kTypeBroot) {
-          if (page->is_dirty())
-            candidates.push_back(page->address());
-          else
-            garbage.push_back(page);
-        }
-        page->mutex().unlock();
-      }
+  // Selects up to |limit| pages of the priority class |priority| for
+  // purging. Returns the number of pages that were inspected.
+  int select_pages(CacheShard *shard, int limit, int priority,
+                  std::vector<uint64_t> &candidates,
+                  std::vector<Page *> &garbage, Page *ignore_page) {
+    if (state.policy == UPS_CACHE_POLICY_CLOCK)
+      return sweep_clock(shard, limit, priority, candidates, garbage,
+                      ignore_page);
+
+    // walk the LRU list (or the probationary segment) from the tail,
+    // then the protected segment
+    int j = 0;
+    Page *page = shard->totallist.tail();
+    for (; j < limit && page != 0; page = page->previous(Page::kListCache)) {
+      if (reclassify(shard, page) != priority)
+        continue;
+      select_candidate(page, candidates, garbage, ignore_page);
+      j++;
+    }
+    page = shard->hotlist.tail();
+    for (; j < limit && page != 0; page = page->previous(Page::kListCache)) {
+      if (reclassify(shard, page) != priority)
+        continue;
+      select_candidate(page, candidates, garbage, ignore_page);
+      j++;
+    }
+    return j;
+  }
+
+  // Moves the clock hand of a shard and collects up to |limit| pages
+  // of the priority class |priority| which were not referenced since the
+  // hand last passed them. The reference bits of the visited pages are
+  // cleared. The hand performs at most one revolution, therefore a page
+  // is never selected twice. Returns the number of selected pages.
+  int sweep_clock(CacheShard *shard, int limit, int priority,
+                  std::vector<uint64_t> &candidates,
+                  std::vector<Page *> &garbage, Page *ignore_page) {
+    size_t steps = shard->totallist.size();
+    Page *page = shard->clock_hand ? shard->clock_hand
+                                   : shard->totallist.tail();
+
+    int found = 0;
+    for (; found < limit && steps > 0 && page != 0; steps--) {
+      if (reclassify(shard, page) != priority)
+        ; // skip this page
+      else if (page->cache_referenced)
+        page->cache_referenced = false;
+      else if (select_candidate(page, candidates, garbage, ignore_page))
+        found++;
 
       page = page->previous(Page::kListCache);
+      if (!page)
+        page = shard->totallist.tail();
     }
+
+    shard->clock_hand = page;
+    return found;
+  }
+
+  // Adds a page to the purge |candidates| (if it's dirty) or to the
+  // |garbage| (if it's clean). Returns false if the page cannot be purged.
+  static bool select_candidate(Page *page, std::vector<uint64_t> &candidates,
+                  std::vector<Page *> &garbage, Page *ignore_page) {
+    bool selected = false;
+    if (page->mutex().try_lock()) {
+      if (page->cursor_list.size() == 0
+            && page != ignore_page
+            && page->type() != Page::kTypeBroot) {
+        if (page->is_dirty())
+          candidates.push_back(page->address());
+        else
+          garbage.push_back(page);
+        selected = true;
+      }
+      page->mutex().unlock();
+    }
+    return selected;
   }
 
   // Visits all pages in the "totallist". If |cb| returns true then the
@@ -174,13 +414,18 @@ struct Cache
   // to flush (and delete) pages.
   template<typename Purger>
   void purge_if(Purger &purger) {
-    PurgeIfSelector<Purger> selector(this, purger);
-    state.totallist.extract(selector);
+    for (size_t i = 0; i < state.shards.size(); i++) {
+      CacheShard *shard = &state.shards[i];
+      ScopedSpinlock lock(shard->mutex);
+      PurgeIfSelector<Purger> selector(shard, purger);
+      shard->totallist.extract(selector);
+      shard->hotlist.extract(selector);
+    }
   }
 
   // Returns true if the capacity limits are exceeded
   bool is_cache_full() const {
-    return state.totallist.size() * state.page_size_bytes
+    return current_elements() * state.page_size_bytes
             > state.capacity_bytes;
   }
 
@@ -191,13 +436,158 @@ struct Cache
 
   // Returns the number of currently cached elements
   size_t current_elements() const {
-    return state.totallist.size();
+    size_t elements = 0;
+    for (size_t i = 0; i < state.shards.size(); i++)
+      elements += state.shards[i].totallist.size()
+                    + state.shards[i].hotlist.size();
+    return elements;
   }
 
   // Returns the number of currently cached elements (excluding those that
   // are mmapped)
   size_t allocated_elements() const {
-    return state.alloc_elements;
+    size_t elements = 0;
+    for (size_t i = 0; i < state.shards.size(); i++)
+      elements += state.shards[i].alloc_elements;
+    return elements;
+  }
+
+  // Returns the shard which stores the page with the |address|
+  CacheShard *shard_of(uint64_t address) {
+    if (state.shards.size() == 1)
+      return &state.shards[0];
+    return &state.shards[(address / state.page_size_bytes)
+                    % state.shards.size()];
+  }
+
+  // Returns the priority class of a page. Internal nodes of the B+tree
+  // are kept longer in the cache than leaf nodes and blob pages
+  static int priority_of(Page *page) {
+    if (page->is_without_header() || page->type() != Page::kTypeBindex)
+      return kPriorityDefault;
+    return PBtreeNode::from_page(page)->is_leaf()
+                ? kPriorityDefault
+                : kPriorityInternalNode;
+  }
+
+  // Updates the priority class of a cached page (a page can change its
+  // type after it was stored in the cache). Returns the new priority.
+  static int reclassify(CacheShard *shard, Page *page) {
+    int priority = priority_of(page);
+    if (priority != page->cache_priority) {
+      if (priority == kPriorityInternalNode)
+        shard->internal_elements++;
+      else
+        shard->internal_elements--;
+      page->cache_priority = (uint8_t)priority;
+    }
+    return priority;
+  }
+
+  // Moves a page to the head of the protected segment (SLRU). If the
+  // protected segment grows too large then its least recently used pages
+  // are moved back to the head of the probationary segment.
+  void promote(CacheShard *shard, Page *page) {
+    if (page->cache_protected)
+      shard->hotlist.del(page);
+    else
+      shard->totallist.del(page);
+    shard->hotlist.put(page);
+    page->cache_protected = true;
+
+    while (shard->hotlist.size() > state.protected_limit) {
+      Page *tail = shard->hotlist.tail();
+      shard->hotlist.del(tail);
+      tail->cache_protected = false;
+      shard->totallist.put(tail);
+    }
+  }
+
+  // Removes a page from the "totallist" (or the protected segment) of a
+  // shard; moves the clock hand if it points to this page. Returns true if
+  // the page was removed.
+  static bool unlink(CacheShard *shard, Page *page) {
+    bool removed;
+    if (page->cache_protected) {
+      page->cache_protected = false;
+      removed = shard->hotlist.del(page);
+    }
+    else {
+      if (shard->clock_hand == page)
+        shard->clock_hand = page->previous(Page::kListCache);
+      removed = shard->totallist.del(page);
+    }
+    if (removed && page->cache_priority == kPriorityInternalNode)
+      shard->internal_elements--;
+    page->cache_priority = kPriorityDefault;
+    return removed;
+  }
+
+  // Removes a page from a shard; the shard must be locked by the caller
+  static void remove(CacheShard *shard, Page *page) {
+    /* remove it from the list of all cached pages */
+    if (unlink(shard, page) && page->is_allocated())
+      shard->alloc_elements--;
+
+    /* remove the page from the cache buckets */
+    bucket_of(shard, page->address()).del(page);
+  }
+
+  // Returns the bucket which stores the page with the |address|. While the
+  // hash table grows, pages of buckets which were not yet migrated are
+  // still stored in the old table
+  static CacheShard::CacheLine &bucket_of(CacheShard *shard,
+                  uint64_t address) {
+    uint64_t hash = Impl::calc_hash(address);
+    if (!shard->old_buckets.empty()) {
+      size_t i = (size_t)(hash & (shard->old_buckets.size() - 1));
+      if (i >= shard->rehash_index)
+        return shard->old_buckets[i];
+    }
+    return shard->buckets[(size_t)(hash & (shard->buckets.size() - 1))];
+  }
+
+  // Doubles the number of buckets of a shard if the load factor is
+  // exceeded. The pages are not moved immediately, but a few buckets are
+  // migrated whenever a page is inserted
+  static void grow_if_required(CacheShard *shard) {
+    rehash(shard, CacheState::kRehashSteps);
+
+    size_t elements = shard->totallist.size() + shard->hotlist.size();
+    if (elements <= shard->buckets.size() * CacheState::kMaxLoadFactor)
+      return;
+
+    // finish a pending migration before the table grows again
+    rehash(shard, shard->old_buckets.size());
+
+    std::vector<CacheShard::CacheLine> buckets(shard->buckets.size() * 2);
+    shard->old_buckets.swap(shard->buckets);
+    shard->buckets.swap(buckets);
+    shard->rehash_index = 0;
+  }
+
+  // Migrates up to |steps| buckets from the old to the new hash table
+  static void rehash(CacheShard *shard, size_t steps) {
+    if (shard->old_buckets.empty())
+      return;
+
+    size_t mask = shard->buckets.size() - 1;
+    for (; steps > 0 && shard->rehash_index < shard->old_buckets.size();
+            steps--) {
+      CacheShard::CacheLine &line = shard->old_buckets[shard->rehash_index];
+      shard->rehash_index++;
+      while (Page *page = line.head()) {
+        line.del(page);
+        shard->buckets[(size_t)(Impl::calc_hash(page->address()) & mask)]
+                .put(page);
+      }
+    }
+
+    // all pages were migrated; release the old table
+    if (shard->rehash_index == shard->old_buckets.size()) {
+      std::vector<CacheShard::CacheLine>().swap(shard->old_buckets);
+      shard->rehash_index = 0;
+    }
   }
 
   CacheState state;
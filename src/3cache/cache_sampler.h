@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * Estimates the hit ratio of the cache at different cache sizes
+ * (see UPS_PARAM_CACHE_SAMPLING).
+ *
+ * Uses spatial sampling ("SHARDS"): only pages whose hashed address falls
+ * below a threshold (the sampling rate) are tracked. For each access
+ * of a sampled page, the reuse distance (the number of distinct sampled
+ * pages which were accessed since the last access of this page) is
+ * calculated and scaled by the inverse of the sampling rate. A LRU cache
+ * with a capacity of C pages would have served the access if the scaled
+ * distance is less than C.
+ *
+ * The reuse distances are calculated with a Fenwick tree over the access
+ * timestamps; each sampled page sets a bit at the timestamp of its most
+ * recent access. The timestamps are renumbered when the tree is full.
+ *
+ * @exception_safe: basic
+ * @thread_safe: yes
+ */
+
+#ifndef UPS_CACHE_SAMPLER_H
+#define UPS_CACHE_SAMPLER_H
+
+#include "0root/root.h"
+
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+#include "ups/upscaledb_int.h"
+
+// Always verify that a file of level N does not include headers > N!
+#include "1base/spinlock.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+struct CacheSampler
+{
+  enum {
+    // The sampling rate is specified in 1/1000
+    kRateScale = 1000,
+
+    // The maximum number of sampled pages which are tracked; if there are
+    // more, then the least recently used ones are forgotten
+    kMaxSamples = 16 * 1024,
+
+    // The number of timestamps in the Fenwick tree
+    kMaxTimestamps = 4 * kMaxSamples
+  };
+
+  // Constructor; |rate| is the sampling rate (in 1/1000), |capacity| the
+  // capacity of the cache (in pages)
+  CacheSampler(uint32_t rate_, uint64_t capacity)
+    : rate(rate_), clock(0), references(0), tree(kMaxTimestamps + 1) {
+    // the estimated cache sizes range from 1/8 to 16 times the capacity
+    for (int i = 0; i < UPS_CACHE_ADVICE_SIZES; i++) {
+      sizes[i] = std::max<uint64_t>(1, (capacity << i) / 8);
+      hits[i] = 0;
+    }
+  }
+
+  // Returns true if the page with the hashed address |hash| is sampled
+  bool is_sampled(uint64_t hash) const {
+    return (hash >> 32) % kRateScale < rate;
+  }
+
+  // Records an access to a sampled page
+  void access(uint64_t address) {
+    ScopedSpinlock lock(mutex);
+
+    if (clock == kMaxTimestamps)
+      renumber();
+    uint64_t now = ++clock;
+    references++;
+
+    std::unordered_map<uint64_t, uint64_t>::iterator it
+            = timestamps.find(address);
+    if (it != timestamps.end()) {
+      uint64_t previous = it->second;
+      uint64_t distance = sum(now - 1) - sum(previous);
+      uint64_t scaled = distance * kRateScale / rate;
+      for (int i = 0; i < UPS_CACHE_ADVICE_SIZES; i++)
+        if (scaled < sizes[i])
+          hits[i]++;
+
+      update(previous, -1);
+      addresses.erase(previous);
+      it->second = now;
+    }
+    else {
+      timestamps[address] = now;
+
+      // forget the least recently used page if there are too many
+      if (timestamps.size() > kMaxSamples) {
+        std::map<uint64_t, uint64_t>::iterator oldest = addresses.begin();
+        update(oldest->first, -1);
+        timestamps.erase(oldest->second);
+        addresses.erase(oldest);
+      }
+    }
+
+    update(now, +1);
+    addresses[now] = address;
+  }
+
+  // Fills in the estimated hit ratios
+  void fill_metrics(ups_env_metrics_t *metrics, uint64_t page_size) {
+    ScopedSpinlock lock(mutex);
+    for (int i = 0; i < UPS_CACHE_ADVICE_SIZES; i++) {
+      metrics->cache_advice_size_bytes[i] = sizes[i] * page_size;
+      metrics->cache_advice_hit_ratio[i] = references
+                        ? (double)hits[i] / references
+                        : 0.0;
+    }
+  }
+
+  // Adds |delta| at the timestamp |t| of the Fenwick tree
+  void update(uint64_t t, int delta) {
+    for (; t <= kMaxTimestamps; t += t & (~t + 1))
+      tree[t] += delta;
+  }
+
+  // Returns the number of sampled pages accessed at or before |t|
+  uint64_t sum(uint64_t t) const {
+    uint64_t s = 0;
+    for (; t > 0; t -= t & (~t + 1))
+      s += tree[t];
+    return s;
+  }
+
+  // Assigns new timestamps (1, 2, 3...) to all tracked pages, keeping
+  // their order, and rebuilds the Fenwick tree
+  void renumber() {
+    std::map<uint64_t, uint64_t> renumbered;
+    std::fill(tree.begin(), tree.end(), 0);
+    clock = 0;
+    for (std::map<uint64_t, uint64_t>::iterator it = addresses.begin();
+            it != addresses.end(); it++) {
+      uint64_t now = ++clock;
+      renumbered[now] = it->second;
+      timestamps[it->second] = now;
+      update(now, +1);
+    }
+    addresses.swap(renumbered);
+  }
+
+  // Protects the sampler; only accesses of sampled pages are serialized
+  Spinlock mutex;
+
+  // The sampling rate (in 1/1000)
+  uint32_t rate;
+
+  // The timestamp of the most recent access
+  uint64_t clock;
+
+  // The number of accesses to sampled pages
+  uint64_t references;
+
+  // The estimated cache sizes (in pages)
+  uint64_t sizes[UPS_CACHE_ADVICE_SIZES];
+
+  // The number of accesses which would have been cache hits for each size
+  uint64_t hits[UPS_CACHE_ADVICE_SIZES];
+
+  // The timestamp of the most recent access of each tracked page
+  std::unordered_map<uint64_t, uint64_t> timestamps;
+
+  // The tracked pages, ordered by the timestamps of their most recent
+  // access
+  std::map<uint64_t, uint64_t> addresses;
+
+  // The Fenwick tree; has a 1 at the timestamp of the most recent access
+  // of each tracked page
+  std::vector<uint32_t> tree;
+};
+
+} // namespace upscaledb
+
+#endif /* UPS_CACHE_SAMPLER_H */
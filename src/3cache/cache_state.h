@@ -22,13 +22,16 @@
 #include "0root/root.h"
 
 #include <vector>
+#include <memory>
 
 #include "ups/types.h"
 
 // Always verify that a file of level N does not include headers > N!
+#include "1base/spinlock.h"
 #include "2page/page.h"
 #include "2page/page_collection.h"
 #include "2config/env_config.h"
+#include "3cache/cache_sampler.h"
 
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
@@ -36,23 +39,108 @@
 
 namespace upscaledb {
 
-struct CacheState
+struct CacheShard
 {
   typedef PageCollection<Page::kListBucket> CacheLine;
 
+  CacheShard(size_t bucket_size = 0)
+    : alloc_elements(0), internal_elements(0), buckets(bucket_size),
+      rehash_index(0), clock_hand(0), cache_hits(0), cache_misses(0) {
+  }
+
+  // protects the shard; shards can be accessed concurrently
+  Spinlock mutex;
+
+  // the current number of cached elements that were allocated (and not
+  // mapped)
+  size_t alloc_elements;
+
+  // the current number of cached internal B+tree nodes
+  size_t internal_elements;
+
+  // linked list of all pages of this shard, in LRU order (or in insertion
+  // order if the CLOCK policy is used)
+  PageCollection<Page::kListCache> totallist;
+
+  // the protected segment of the SLRU policy, in LRU order; pages in this
+  // list have Page::cache_protected set
+  PageCollection<Page::kListCache> hotlist;
+
+  // The hash table buckets - each is a linked list of Page pointers.
+  // The number of buckets is always a power of two
+  std::vector<CacheLine> buckets;
+
+  // While the hash table grows, the previous buckets are migrated
+  // incrementally. All buckets below |rehash_index| were already moved
+  // to |buckets|; the remaining pages are still stored in |old_buckets|
+  std::vector<CacheLine> old_buckets;
+
+  // the next bucket in |old_buckets| which is migrated
+  size_t rehash_index;
+
+  // the next page that is inspected by the CLOCK policy; moves from the
+  // tail of the |totallist| to its head, then wraps around
+  Page *clock_hand;
+
+  // counts the cache hits
+  uint64_t cache_hits;
+
+  // counts the cache misses
+  uint64_t cache_misses;
+};
+
+struct CacheState
+{
   enum {
-    // The number of buckets should be a prime number or similar, as it
-    // is used in a MODULO hash scheme
-    kBucketSize = 10317,
+    // The minimum number of buckets per shard
+    kMinBuckets = 64,
+
+    // The maximum number of buckets per shard which are allocated when the
+    // Environment is opened; the hash table can grow beyond this size
+    kMaxInitialBuckets = 1024 * 1024,
+
+    // The hash table of a shard grows if it stores more pages than it
+    // has buckets
+    kMaxLoadFactor = 1,
+
+    // The number of buckets which are migrated with each insert while
+    // the hash table grows
+    kRehashSteps = 4,
+
+    // SLRU: the size of the protected segment, in percent of the capacity
+    kProtectedPercent = 80,
   };
 
   CacheState(const EnvConfig &config)
     : capacity_bytes(IS_SET(config.flags, UPS_CACHE_UNLIMITED)
                             ? std::numeric_limits<uint64_t>::max()
                             : config.cache_size_bytes),
-      page_size_bytes(config.page_size_bytes), alloc_elements(0),
-      buckets(kBucketSize), cache_hits(0), cache_misses(0) {
+      page_size_bytes(config.page_size_bytes),
+      policy(config.cache_policy),
+      shards(config.cache_shards > 0 ? config.cache_shards : 1) {
     assert(capacity_bytes > 0);
+    uint64_t pages = capacity_bytes / page_size_bytes;
+    bool is_unlimited = pages >= std::numeric_limits<size_t>::max() / 100;
+
+    // size the hash tables for the expected number of pages; an unlimited
+    // cache starts small and grows on demand
+    size_t bucket_size = kMinBuckets;
+    while (!is_unlimited && bucket_size < kMaxInitialBuckets
+            && bucket_size < pages / shards.size())
+      bucket_size *= 2;
+    for (size_t i = 0; i < shards.size(); i++)
+      shards[i].buckets.resize(bucket_size);
+
+    protected_limit = is_unlimited
+                          ? std::numeric_limits<size_t>::max()
+                          : (size_t)(pages * kProtectedPercent / 100
+                                  / shards.size());
+    internal_node_limit = is_unlimited
+                          ? 0
+                          : (size_t)(pages * config.cache_internal_nodes
+                                  / 100 / shards.size());
+    if (config.cache_sampling > 0 && !is_unlimited)
+      sampler.reset(new CacheSampler(config.cache_sampling, pages));
   }
 
   // the capacity (in bytes)
@@ -61,21 +149,21 @@ struct CacheState
   // the current page size (in bytes)
   uint64_t page_size_bytes;
 
-  // the current number of cached elements that were allocated (and not
-  // mapped)
-  size_t alloc_elements;
+  // the replacement policy (UPS_CACHE_POLICY_LRU, UPS_CACHE_POLICY_CLOCK
+  // or UPS_CACHE_POLICY_SLRU)
+  uint32_t policy;
 
-  // linked list of ALL cached pages
-  PageCollection<Page::kListCache> totallist;
+  // SLRU: the maximum number of pages in the protected segment of a shard
+  size_t protected_limit;
 
-  // The hash table buckets - each is a linked list of Page pointers
-  std::vector<CacheLine> buckets;
+  // the number of internal B+tree nodes per shard which are not purged
+  size_t internal_node_limit;
 
-  // counts the cache hits
-  uint64_t cache_hits;
+  // The shards; pages are partitioned by their address
+  std::vector<CacheShard> shards;
 
-  // counts the cache misses
-  uint64_t cache_misses;
+  // Estimates the hit ratio at other cache sizes; null if disabled
+  std::unique_ptr<CacheSampler> sampler;
 };
 
 } // namespace upscaledb
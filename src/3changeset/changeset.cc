@@ -20,6 +20,9 @@
 
 #include "0root/root.h"
 
+#include <algorithm>
+#include <boost/atomic.hpp>
+
 // Always verify that a file of level N does not include headers > N!
 #include "1base/signal.h"
 #include "1errorinducer/errorinducer.h"
@@ -63,12 +66,42 @@ struct FlushChangesetVisitor {
   std::vector<Page *> list;
 };
 
+// The pages of a Changeset which are flushed by the worker threads
+struct AsyncChangesetFlush {
+  AsyncChangesetFlush(std::vector<Page *> &list_, PageManager *page_manager_,
+                  Device *device_, uint64_t lsn_, bool enable_fsync_)
+    : list(list_), page_manager(page_manager_), device(device_), lsn(lsn_),
+      enable_fsync(enable_fsync_), pending(0) {
+  }
+
+  std::vector<Page *> list;
+  PageManager *page_manager;
+  Device *device;
+  uint64_t lsn;
+  bool enable_fsync;
+
+  // the number of partitions which are not yet flushed
+  boost::atomic<size_t> pending;
+};
+
+static bool
+compare_addresses(const Page *lhs, const Page *rhs)
+{
+  return lhs->address() < rhs->address();
+}
+
+// Flushes the pages in |message->list[begin, end)|. The pages are locked by
+// the Changeset, and the Changeset's pages are disjoint from those of
+// other Changesets; therefore the partitions can be flushed in any order.
+// The last partition flushes the file handle, and removes the pages from
+// the dirty page table.
 static void
-flush_changeset_to_file(std::vector<Page *> list, Device *device,
-                Journal *, uint64_t lsn, bool enable_fsync)
+flush_changeset_to_file(AsyncChangesetFlush *message, size_t begin,
+                size_t end)
 {
-  std::vector<Page *>::iterator it = list.begin();
-  for (; it != list.end(); it++) {
+  uint64_t lsn = message->lsn;
+  std::vector<Page *>::iterator it = message->list.begin() + begin;
+  for (; it != message->list.begin() + end; it++) {
     Page *page = *it;
 
     // move lock ownership to this thread, otherwise unlocking the mutex
@@ -79,15 +112,25 @@ flush_changeset_to_file(std::vector<Page *> list, Device *device,
 
     if (likely(page->is_without_header() == false))
       page->set_lsn(lsn);
+  }
 
-    page->flush();
-    page->mutex().unlock();
+  // the list is sorted; adjacent pages are written with a single call
+  Page::flush(message->list.data() + begin, end - begin);
+
+  it = message->list.begin() + begin;
+  for (; it != message->list.begin() + end; it++) {
+    (*it)->mutex().unlock();
     UPS_INDUCE_ERROR(ErrorInducer::kChangesetFlush);
   }
 
+  if (--message->pending > 0)
+    return;
+
   /* flush the file handle (if required) */
-  if (enable_fsync)
-    device->flush();
+  if (message->enable_fsync)
+    message->device->flush();
+  message->page_manager->remove_pending_changeset(lsn);
+  delete message;
 
   UPS_INDUCE_ERROR(ErrorInducer::kChangesetFlush);
 }
@@ -129,10 +172,20 @@ Changeset::flush(uint64_t lsn)
     g_CHANGESET_POST_LOG_HOOK();
 
   // The modified pages are now flushed (and unlocked) asynchronously
-  // to the database file
-  env->page_manager->run_async(boost::bind(&flush_changeset_to_file,
-                          visitor.list, env->device.get(), env->journal.get(),
-                          lsn, IS_SET(env->config.flags, UPS_ENABLE_FSYNC)));
+  // to the database file. Larger Changesets are sorted by address and
+  // split into ranges, which are flushed in parallel
+  AsyncChangesetFlush *message = new AsyncChangesetFlush(visitor.list,
+                          env->page_manager.get(), env->device.get(), lsn,
+                          IS_SET(env->config.flags, UPS_ENABLE_FSYNC));
+  std::vector<Page *> &list = message->list;
+  std::sort(list.begin(), list.end(), compare_addresses);
+  size_t partitions = env->page_manager->flush_partitions(list.size());
+  message->pending = partitions;
+  env->page_manager->add_pending_changeset(lsn, list);
+  for (size_t i = 0; i < partitions; i++)
+    env->page_manager->run_async(boost::bind(&flush_changeset_to_file,
+                            message, i * list.size() / partitions,
+                            (i + 1) * list.size() / partitions), i);
 }
 
 } // namespace upscaledb
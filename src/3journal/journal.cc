@@ -20,12 +20,15 @@
 
 #include <string.h>
 #include <libgen.h>
+#include <algorithm>
+#include <map>
 
 #include "1base/error.h"
 #include "1errorinducer/errorinducer.h"
 #include "1os/os.h"
 #include "2device/device.h"
 #include "2compressor/compressor_factory.h"
+#include "2worker/worker.h"
 #include "3journal/journal.h"
 #include "3page_manager/page_manager.h"
 #include "4db/db.h"
@@ -47,6 +50,16 @@ enum {
 
   // flush buffers if this limit is exceeded
   kBufferLimit = 1024 * 1024, // 1 mb
+
+  // flags for flush_buffer(): the buffer ends with a commit which waits
+  // for the next sync
+  kFlushCommit = 1,
+
+  // the data is written before flush_buffer() returns
+  kFlushWrite = 2,
+
+  // the data is synced before flush_buffer() returns
+  kFlushSync = 4,
 };
 
 static inline void
@@ -60,6 +73,7 @@ clear_file(JournalState &state, int idx)
     // the original size
     state.files[idx].seek(0, SEEK_SET);
   }
+  state.max_lsn[idx] = 0;
 }
 
 static inline std::string
@@ -84,17 +98,277 @@ log_file_path(JournalState &state, int i)
   return (path);
 }
 
+// Syncs the dirty files; afterwards everything which was written so far is
+// on disk. The caller holds |sync_mutex|, which is released during the
+// fsync.
+static inline void
+sync_dirty_files(JournalState &state, ScopedLock &lock)
+{
+  uint64_t target = state.written_position;
+  uint32_t group = state.pending_commits;
+  bool is_dirty[2] = { state.is_dirty[0], state.is_dirty[1] };
+  state.pending_commits = 0;
+  state.is_dirty[0] = state.is_dirty[1] = false;
+
+  lock.unlock();
+  try {
+    for (int i = 0; i < 2; i++)
+      if (is_dirty[i])
+        state.files[i].flush();
+  }
+  catch (Exception &) {
+    lock.lock();
+    state.is_dirty[0] |= is_dirty[0];
+    state.is_dirty[1] |= is_dirty[1];
+    state.pending_commits += group;
+    throw;
+  }
+  lock.lock();
+
+  state.synced_position = std::max(state.synced_position, target);
+  if (group > 0) {
+    state.count_group_commits++;
+    state.count_group_commit_txns += group;
+    state.max_group_commit_size = std::max(state.max_group_commit_size,
+                    (uint64_t)group);
+  }
+  state.sync_cond.notify_all();
+}
+
+// Syncs the files for all commits which are pending; transactions which
+// commit concurrently share a single sync ("group commit"). If the writer
+// thread is running then it performs the sync. Otherwise the first thread
+// which has to wait becomes the leader; if |wait_for_group| is true
+// then it waits up to |group_commit_delay| microseconds for more commits.
+// All other threads wait till a sync covers their data.
+static inline void
+sync_files(JournalState &state, uint64_t position, bool wait_for_group)
+{
+  ScopedLock lock(state.sync_mutex);
+
+  if (state.writer) {
+    state.requested_position = std::max(state.requested_position, position);
+    if (!wait_for_group)
+      state.urgent_position = std::max(state.urgent_position, position);
+    state.sync_cond.notify_all();
+
+    while (state.synced_position < position) {
+      if (unlikely(state.writer_status != 0))
+        throw Exception(state.writer_status);
+      state.sync_cond.wait(lock);
+    }
+    return;
+  }
+
+  while (state.synced_position < position) {
+    if (state.is_sync_active) {
+      state.sync_cond.wait(lock);
+      continue;
+    }
+
+    state.is_sync_active = true;
+    if (wait_for_group && state.group_commit_delay > 0) {
+      boost::posix_time::microseconds delay(state.group_commit_delay);
+      state.sync_cond.timed_wait(lock, delay, [&state] {
+                        return state.pending_commits
+                                >= state.group_commit_size;
+                      });
+    }
+
+    try {
+      sync_dirty_files(state, lock);
+    }
+    catch (Exception &) {
+      state.is_sync_active = false;
+      state.sync_cond.notify_all();
+      throw;
+    }
+    state.is_sync_active = false;
+  }
+}
+
+// The writer thread (see UPS_PARAM_JOURNAL_WRITER_THREAD). Writes the
+// buffers which are handed over by flush_buffer(), and syncs the files for
+// the commits which wait in sync_files().
+static void
+run_writer(JournalState *state_)
+{
+  JournalState &state = *state_;
+  ScopedLock lock(state.sync_mutex);
+  boost::system_time deadline;
+  bool has_deadline = false;
+
+  while (true) {
+    if (state.write_buffer.size() > 0) {
+      int idx = state.write_fd;
+      size_t size = state.write_buffer.size();
+      ups_status_t st = 0;
+
+      lock.unlock();
+      try {
+        state.files[idx].write(state.write_buffer.data(), size);
+      }
+      catch (Exception &ex) {
+        st = ex.code;
+      }
+      lock.lock();
+
+      if (unlikely(st != 0)) {
+        if (state.writer_status == 0)
+          state.writer_status = st;
+      }
+      else {
+        state.written_position += size;
+        state.count_bytes_flushed += size;
+        state.is_dirty[idx] = true;
+      }
+      state.write_buffer.clear();
+      state.sync_cond.notify_all();
+      continue;
+    }
+
+    if (state.synced_position < state.requested_position
+          && state.writer_status == 0) {
+      // give other commits a chance to join the group, unless a caller
+      // does not wait for a group
+      if (state.group_commit_delay > 0
+            && state.urgent_position <= state.synced_position
+            && state.pending_commits < state.group_commit_size
+            && !state.is_writer_stopping) {
+        if (!has_deadline) {
+          deadline = boost::get_system_time()
+                  + boost::posix_time::microseconds(state.group_commit_delay);
+          has_deadline = true;
+        }
+        if (boost::get_system_time() < deadline) {
+          state.sync_cond.timed_wait(lock, deadline);
+          continue;
+        }
+      }
+
+      has_deadline = false;
+      try {
+        sync_dirty_files(state, lock);
+      }
+      catch (Exception &ex) {
+        state.writer_status = ex.code;
+        state.sync_cond.notify_all();
+      }
+      continue;
+    }
+
+    if (state.is_writer_stopping)
+      break;
+    state.sync_cond.wait(lock);
+  }
+}
+
+static inline void
+start_writer(JournalState &state)
+{
+  if (state.env->config.journal_writer_thread && !state.writer)
+    state.writer.reset(new Thread(run_writer, &state));
+}
+
+static inline void
+stop_writer(JournalState &state)
+{
+  if (!state.writer)
+    return;
+
+  {
+    ScopedLock lock(state.sync_mutex);
+    state.is_writer_stopping = true;
+    state.sync_cond.notify_all();
+  }
+  state.writer->join();
+  state.writer.reset();
+  state.is_writer_stopping = false;
+}
+
+// Hands the buffer over to the writer thread. If |wait| is false and the
+// writer is still busy with the previous buffer then the data remains in
+// the buffer till the next call. Returns the position of the data which
+// was handed over so far.
+static inline uint64_t
+hand_off_buffer(JournalState &state, int idx, bool wait)
+{
+  ScopedLock lock(state.sync_mutex);
+
+  while (state.write_buffer.size() > 0 && state.writer_status == 0) {
+    if (!wait)
+      return state.queued_position;
+    state.sync_cond.wait(lock);
+  }
+  if (unlikely(state.writer_status != 0))
+    throw Exception(state.writer_status);
+
+  state.write_buffer.swap(state.buffer);
+  state.write_fd = idx;
+  state.max_lsn[idx] = std::max(state.max_lsn[idx], state.buffer_max_lsn);
+  state.buffer_max_lsn = 0;
+  state.queued_position += state.write_buffer.size();
+  state.pending_commits += state.buffered_commits;
+  state.buffered_commits = 0;
+  state.sync_cond.notify_all();
+  return state.queued_position;
+}
+
+// Waits till the writer thread wrote all buffers which were handed over
 static inline void
-flush_buffer(JournalState &state, int idx, bool fsync = false)
+wait_for_writer(JournalState &state)
 {
-  if (likely(state.buffer.size() > 0)) {
+  if (!state.writer)
+    return;
+
+  ScopedLock lock(state.sync_mutex);
+  while (state.written_position < state.queued_position) {
+    if (unlikely(state.writer_status != 0))
+      throw Exception(state.writer_status);
+    state.sync_cond.wait(lock);
+  }
+}
+
+// Writes the buffer to the file |idx| (or hands it over to the writer
+// thread). |flags| is a combination of kFlushCommit, kFlushWrite and
+// kFlushSync.
+static inline void
+flush_buffer(JournalState &state, int idx, uint32_t flags = 0)
+{
+  if (unlikely(state.buffer.size() == 0))
+    return;
+
+  if (IS_SET(flags, kFlushCommit))
+    state.buffered_commits++;
+
+  uint64_t position;
+  if (state.writer) {
+    // only wait for the writer thread if the data is required on disk,
+    // or if the buffer grows too large
+    bool wait = flags != 0 || state.buffer.size() > kBufferLimit;
+    position = hand_off_buffer(state, idx, wait);
+    if (IS_SET(flags, kFlushWrite))
+      wait_for_writer(state);
+  }
+  else {
     state.files[idx].write(state.buffer.data(), state.buffer.size());
-    state.count_bytes_flushed += state.buffer.size();
+    state.max_lsn[idx] = std::max(state.max_lsn[idx], state.buffer_max_lsn);
+    state.buffer_max_lsn = 0;
 
+    ScopedLock lock(state.sync_mutex);
+    state.count_bytes_flushed += state.buffer.size();
+    state.written_position += state.buffer.size();
+    state.queued_position = state.written_position;
+    state.is_dirty[idx] = true;
+    state.pending_commits += state.buffered_commits;
+    state.buffered_commits = 0;
+    state.sync_cond.notify_all();
+    position = state.written_position;
     state.buffer.clear();
-    if (unlikely(fsync))
-      state.files[idx].flush();
   }
+
+  if (unlikely(IS_SET(flags, kFlushSync)))
+    sync_files(state, position, false);
 }
 
 // Sequentially returns the next journal entry, starting with
@@ -188,6 +462,13 @@ append_entry(JournalState &state, int ,
     state.buffer.append(ptr5, ptr5_size);
 }
 
+// Records the lsn of an entry which is appended to the buffer
+static inline void
+track_lsn(JournalState &state, uint64_t lsn)
+{
+  state.buffer_max_lsn = std::max(state.buffer_max_lsn, lsn);
+}
+
 // Switches the log file if necessary; returns the new log descriptor in the
 // transaction
 static inline int
@@ -200,6 +481,7 @@ switch_files_maybe(JournalState &state)
   //
   // otherwise delete the other file and use the other file as the current file
   if (unlikely(state.num_transactions > state.threshold)) {
+    wait_for_writer(state);
     clear_file(state, other);
     state.current_fd = other;
     state.num_transactions = 0;
@@ -296,6 +578,84 @@ append_changeset_page(JournalState &state, Page *page, uint32_t page_size)
   return page_size + sizeof(header);
 }
 
+// The last checkpoint of the journal (see find_last_checkpoint())
+struct JournalCheckpoint {
+  JournalCheckpoint()
+    : lsn(0), oldest_lsn(0) {
+  }
+
+  // Returns true if the image of a page in the changeset |changeset_lsn|
+  // has to be re-applied; all other pages were already written
+  bool is_required(uint64_t address, uint64_t changeset_lsn) const {
+    if (changeset_lsn > lsn)
+      return true;
+    std::map<uint64_t, uint64_t>::const_iterator it = dirty_pages.find(address);
+    return it != dirty_pages.end() && changeset_lsn >= it->second;
+  }
+
+  // the lsn of the checkpoint; 0 if there is no checkpoint
+  uint64_t lsn;
+
+  // the lsn of the oldest transaction which was not yet flushed
+  uint64_t oldest_lsn;
+
+  // the dirty page table; maps the page address to the lsn of its changeset
+  std::map<uint64_t, uint64_t> dirty_pages;
+};
+
+// Scans both files for the newest checkpoint and reads it. Incomplete
+// checkpoints (i.e. after a crash) are ignored
+static inline void
+find_last_checkpoint(JournalState &state, JournalCheckpoint &checkpoint)
+{
+  int fdidx = -1;
+  uint64_t offset = 0;
+
+  for (int i = 0; i < 2; i++) {
+    Journal::Iterator it;
+    PJournalEntry entry;
+
+    try {
+      uint64_t filesize = state.files[i].file_size();
+
+      while (it.offset + sizeof(entry) <= filesize) {
+        state.files[i].pread(it.offset, &entry, sizeof(entry));
+
+        if (entry.lsn == 0)
+          break;
+
+        uint64_t next = it.offset + sizeof(entry) + entry.followup_size;
+        if (entry.type == Journal::kEntryTypeCheckpoint
+              && entry.lsn > checkpoint.lsn
+              && next <= filesize) {
+          checkpoint.lsn = entry.lsn;
+          fdidx = i;
+          offset = it.offset + sizeof(entry);
+        }
+
+        it.offset = next;
+      }
+    }
+    catch (Exception &ex) {
+      ups_log(("exception (error %d) while reading journal", ex.code));
+    }
+  }
+
+  if (fdidx == -1)
+    return;
+
+  PJournalEntryCheckpoint header;
+  state.files[fdidx].pread(offset, &header, sizeof(header));
+  checkpoint.oldest_lsn = header.oldest_lsn;
+
+  std::vector<PJournalEntryDirtyPage> pages(header.num_pages);
+  if (header.num_pages > 0)
+    state.files[fdidx].pread(offset + sizeof(header), pages.data(),
+                    pages.size() * sizeof(PJournalEntryDirtyPage));
+  for (size_t i = 0; i < pages.size(); i++)
+    checkpoint.dirty_pages[pages[i].address] = pages[i].lsn;
+}
+
 // Scans a file for the oldest changeset. Returns the lsn of this
 // changeset.
 static inline uint64_t
@@ -330,10 +690,12 @@ scan_for_oldest_changeset(JournalState &, File *file)
   return 0;
 }
 
-// Redo all Changesets of a log file, in chronological order
+// Redo all Changesets of a log file, in chronological order; pages which
+// were written before |checkpoint| are skipped.
 // Returns the highest lsn of the last changeset applied
 static inline uint64_t
-redo_all_changesets(JournalState &state, int fdidx)
+redo_all_changesets(JournalState &state, int fdidx,
+                const JournalCheckpoint &checkpoint)
 {
   Journal::Iterator it;
   PJournalEntry entry;
@@ -389,6 +751,9 @@ redo_all_changesets(JournalState &state, int fdidx)
           it.offset += page_size;
         }
 
+        if (!checkpoint.is_required(page_header.address, entry.lsn))
+          continue;
+
         Page *page;
 
         // now write the page to disk
@@ -435,10 +800,215 @@ redo_all_changesets(JournalState &state, int fdidx)
   return max_lsn;
 }
 
-// Recovers (re-applies) the physical changelog; returns the lsn of the
-// Changelog
+// The location of a page image in the journal
+struct JournalPageImage {
+  // the file of the image
+  int fdidx;
+
+  // the offset of the image in the file
+  uint64_t offset;
+
+  // the compressed size, or 0 if the image is not compressed
+  uint32_t compressed_size;
+};
+
+typedef std::map<uint64_t, JournalPageImage> JournalPageImageMap;
+typedef std::vector<std::pair<uint64_t, JournalPageImage> >
+        JournalPageImageList;
+
+// Scans the changesets of a log file in chronological order, and records
+// the location of the newest image of each page in |images|; pages which
+// were written before |checkpoint| are skipped. Returns the lsn of the
+// last changeset
 static inline uint64_t
-recover_changeset(JournalState &state)
+collect_page_images(JournalState &state, int fdidx,
+                const JournalCheckpoint &checkpoint,
+                JournalPageImageMap &images)
+{
+  Journal::Iterator it;
+  PJournalEntry entry;
+  uint64_t max_lsn = 0;
+  uint32_t page_size = state.env->config.page_size_bytes;
+
+  try {
+    uint64_t log_file_size = state.files[fdidx].file_size();
+
+    while (it.offset < log_file_size) {
+      state.files[fdidx].pread(it.offset, &entry, sizeof(entry));
+
+      // Skip all log entries which are NOT from a changeset
+      if (entry.type != Journal::kEntryTypeChangeset) {
+        it.offset += sizeof(entry) + entry.followup_size;
+        continue;
+      }
+
+      max_lsn = entry.lsn;
+
+      it.offset += sizeof(entry);
+
+      // Read the Changeset header
+      PJournalEntryChangeset changeset;
+      state.files[fdidx].pread(it.offset, &changeset, sizeof(changeset));
+      it.offset += sizeof(changeset);
+
+      state.env->page_manager->set_last_blob_page_id(changeset.last_blob_page);
+
+      // for each page in this changeset: newer images replace older ones
+      for (uint32_t i = 0; i < changeset.num_pages; i++) {
+        PJournalEntryPageHeader page_header;
+        state.files[fdidx].pread(it.offset, &page_header,
+                        sizeof(page_header));
+        it.offset += sizeof(page_header);
+
+        JournalPageImage image;
+        image.fdidx = fdidx;
+        image.offset = it.offset;
+        image.compressed_size = page_header.compressed_size;
+        if (checkpoint.is_required(page_header.address, entry.lsn))
+          images[page_header.address] = image;
+
+        if (page_header.compressed_size > 0)
+          it.offset += page_header.compressed_size;
+        else
+          it.offset += page_size;
+      }
+    }
+  }
+  catch (Exception &) {
+    ups_trace(("Exception when reading changeset"));
+    throw;
+  }
+
+  return max_lsn;
+}
+
+// Reads (and decompresses) a page image into |arena|
+static inline void
+read_page_image(JournalState &state, Compressor *compressor,
+                const JournalPageImage &image, ByteArray &arena,
+                ByteArray &tmp)
+{
+  uint32_t page_size = state.env->config.page_size_bytes;
+
+  if (image.compressed_size > 0) {
+    tmp.resize(image.compressed_size);
+    state.files[image.fdidx].pread(image.offset, tmp.data(),
+                    image.compressed_size);
+    compressor->decompress(tmp.data(), image.compressed_size, page_size,
+                    &arena);
+  }
+  else {
+    arena.resize(page_size);
+    state.files[image.fdidx].pread(image.offset, arena.data(), page_size);
+  }
+}
+
+// Writes the page images of one partition to the device; runs in a thread
+// of the WorkerPool
+static inline void
+write_page_images(JournalState &state, const JournalPageImageList &images)
+{
+  uint32_t page_size = state.env->config.page_size_bytes;
+  Device *device = state.env->device.get();
+
+  // each thread requires its own compressor
+  std::unique_ptr<Compressor> compressor;
+  if (state.compressor.get())
+    compressor.reset(CompressorFactory::create(
+                            state.env->config.journal_compressor));
+
+  ByteArray arena(page_size);
+  ByteArray tmp;
+  Page page(device);
+
+  for (JournalPageImageList::const_iterator it = images.begin();
+                  it != images.end();
+                  ++it) {
+    read_page_image(state, compressor.get(), it->second, arena, tmp);
+
+    // the page does not take over ownership of the buffer; it is only
+    // required for updating the checksum
+    page.assign_mapped_buffer(arena.data(), it->first);
+    page.update_crc32();
+    device->write(it->first, arena.data(), page_size);
+  }
+}
+
+// Redo all Changesets of both log files with |num_threads| threads
+// (see UPS_PARAM_RECOVERY_THREADS). Only the newest image of each page is
+// written; the pages are partitioned by their address. Returns the
+// highest lsn of the last changeset applied
+static inline uint64_t
+redo_changesets_parallel(JournalState &state, int first, size_t num_threads,
+                const JournalCheckpoint &checkpoint)
+{
+  JournalPageImageMap images;
+  uint64_t max_lsn1 = collect_page_images(state, first, checkpoint, images);
+  uint64_t max_lsn2 = collect_page_images(state, first == 0 ? 1 : 0,
+                  checkpoint, images);
+
+  uint32_t page_size = state.env->config.page_size_bytes;
+  ByteArray arena(page_size);
+  ByteArray tmp;
+
+  // the header page is cached; it is updated by this thread
+  JournalPageImageMap::iterator hit = images.find(0);
+  if (hit != images.end()) {
+    Page *page = state.env->header->header_page;
+    read_page_image(state, state.compressor.get(), hit->second, arena, tmp);
+    ::memcpy(page->data(), arena.data(), page_size);
+    page->set_dirty(true);
+    page->flush();
+    images.erase(hit);
+  }
+
+  if (images.empty())
+    return std::max(max_lsn1, max_lsn2);
+
+  // grow the file; afterwards the pages can be written in any order
+  Device *device = state.env->device.get();
+  uint64_t file_size = images.rbegin()->first + page_size;
+  if (file_size > device->file_size())
+    device->truncate(file_size);
+
+  std::vector<JournalPageImageList> partitions(num_threads);
+  for (JournalPageImageMap::iterator it = images.begin();
+                  it != images.end();
+                  ++it)
+    partitions[(it->first / page_size) % num_threads].push_back(*it);
+
+  std::vector<ups_status_t> results(num_threads, 0);
+  {
+    WorkerPool pool(num_threads);
+    for (size_t i = 0; i < num_threads; i++) {
+      boost::function<void ()> task = [&state, &partitions, &results, i] {
+        try {
+          write_page_images(state, partitions[i]);
+        }
+        catch (Exception &ex) {
+          results[i] = ex.code;
+        }
+      };
+      pool.enqueue(task, i);
+    }
+    pool.wait_for_pending();
+  }
+
+  for (size_t i = 0; i < num_threads; i++) {
+    if (results[i] != 0) {
+      ups_trace(("Exception when applying changeset"));
+      throw Exception(results[i]);
+    }
+  }
+
+  Page::ms_page_count_flushed += images.size();
+  return std::max(max_lsn1, max_lsn2);
+}
+
+// Recovers (re-applies) the physical changelog, starting at |checkpoint|;
+// returns the lsn of the Changelog
+static inline uint64_t
+recover_changeset(JournalState &state, const JournalCheckpoint &checkpoint)
 {
   // scan through both files, look for the file with the oldest changeset.
   uint64_t lsn1 = scan_for_oldest_changeset(state, &state.files[0]);
@@ -451,17 +1021,153 @@ recover_changeset(JournalState &state)
   // now redo all changesets chronologically
   state.current_fd = lsn1 < lsn2 ? 0 : 1;
 
-  uint64_t max_lsn1 = redo_all_changesets(state, state.current_fd);
-  uint64_t max_lsn2 = redo_all_changesets(state, state.current_fd == 0 ? 1 : 0);
+  if (state.env->config.recovery_threads > 1)
+    return redo_changesets_parallel(state, state.current_fd,
+                    state.env->config.recovery_threads, checkpoint);
+
+  uint64_t max_lsn1 = redo_all_changesets(state, state.current_fd,
+                  checkpoint);
+  uint64_t max_lsn2 = redo_all_changesets(state,
+                  state.current_fd == 0 ? 1 : 0, checkpoint);
 
   // return the lsn of the newest changeset
   return std::max(max_lsn1, max_lsn2);
 }
 
-// Recovers the logical journal
+// A journal entry which is read ahead for the parallel recovery
+struct JournalRecoveryEntry {
+  // the entry
+  PJournalEntry entry;
+
+  // the auxiliary data (see read_entry())
+  std::vector<uint8_t> aux;
+};
+
+typedef std::vector<JournalRecoveryEntry> JournalRecoveryList;
+
+// Decompresses the key and record of an insert or erase entry; afterwards
+// the auxiliary data has the uncompressed layout
+static inline void
+decompress_entry(Compressor *compressor, JournalRecoveryEntry &e)
+{
+  std::vector<uint8_t> out;
+
+  if (e.entry.type == Journal::kEntryTypeInsert) {
+    PJournalEntryInsert *ins = (PJournalEntryInsert *)e.aux.data();
+    if (ins->compressed_key_size == 0 && ins->compressed_record_size == 0)
+      return;
+
+    uint8_t *payload = ins->key_data();
+    out.assign(e.aux.data(), e.aux.data() + sizeof(PJournalEntryInsert) - 1);
+    if (ins->compressed_key_size != 0) {
+      compressor->decompress(payload, ins->compressed_key_size,
+                      ins->key_size);
+      out.insert(out.end(), compressor->arena.data(),
+                      compressor->arena.data() + ins->key_size);
+      payload += ins->compressed_key_size;
+    }
+    else {
+      out.insert(out.end(), payload, payload + ins->key_size);
+      payload += ins->key_size;
+    }
+    if (ins->compressed_record_size != 0) {
+      compressor->decompress(payload, ins->compressed_record_size,
+                      ins->record_size);
+      out.insert(out.end(), compressor->arena.data(),
+                      compressor->arena.data() + ins->record_size);
+    }
+    else
+      out.insert(out.end(), payload, payload + ins->record_size);
+
+    ins = (PJournalEntryInsert *)out.data();
+    ins->compressed_key_size = 0;
+    ins->compressed_record_size = 0;
+  }
+  else if (e.entry.type == Journal::kEntryTypeErase) {
+    PJournalEntryErase *er = (PJournalEntryErase *)e.aux.data();
+    if (er->compressed_key_size == 0)
+      return;
+
+    out.assign(e.aux.data(), e.aux.data() + sizeof(PJournalEntryErase) - 1);
+    compressor->decompress(er->key_data(), er->compressed_key_size,
+                    er->key_size);
+    out.insert(out.end(), compressor->arena.data(),
+                    compressor->arena.data() + er->key_size);
+
+    er = (PJournalEntryErase *)out.data();
+    er->compressed_key_size = 0;
+  }
+  else
+    return;
+
+  e.aux.swap(out);
+}
+
+// Reads all entries which are required for the logical recovery, and
+// decompresses the inserts and erases with |num_threads| threads. The
+// entries are partitioned by their database; each thread processes the
+// entries of its databases in lsn order
+static inline void
+read_ahead_entries(JournalState &state, uint64_t start_lsn,
+                size_t num_threads, JournalRecoveryList &entries)
+{
+  Journal::Iterator it;
+  ByteArray buffer;
+
+  while (true) {
+    JournalRecoveryEntry e;
+    read_entry(state, &it, &e.entry, &buffer);
+    if (!e.entry.lsn)
+      break;
+    if (e.entry.followup_size)
+      e.aux.assign(buffer.data(), buffer.data() + e.entry.followup_size);
+    entries.push_back(e);
+  }
+
+  if (!state.compressor.get())
+    return;
+
+  std::vector<std::vector<JournalRecoveryEntry *> > partitions(num_threads);
+  for (JournalRecoveryList::iterator it = entries.begin();
+                  it != entries.end();
+                  ++it) {
+    if ((it->entry.type == Journal::kEntryTypeInsert
+              || it->entry.type == Journal::kEntryTypeErase)
+          && it->entry.lsn > start_lsn && !it->aux.empty())
+      partitions[it->entry.dbname % num_threads].push_back(&*it);
+  }
+
+  std::vector<ups_status_t> results(num_threads, 0);
+  {
+    WorkerPool pool(num_threads);
+    for (size_t i = 0; i < num_threads; i++) {
+      boost::function<void ()> task = [&state, &partitions, &results, i] {
+        try {
+          std::unique_ptr<Compressor> compressor(CompressorFactory::create(
+                                  state.env->config.journal_compressor));
+          for (size_t j = 0; j < partitions[i].size(); j++)
+            decompress_entry(compressor.get(), *partitions[i][j]);
+        }
+        catch (Exception &ex) {
+          results[i] = ex.code;
+        }
+      };
+      pool.enqueue(task, i);
+    }
+    pool.wait_for_pending();
+  }
+
+  for (size_t i = 0; i < num_threads; i++)
+    if (results[i] != 0)
+      throw Exception(results[i]);
+}
+
+// Recovers the logical journal; transactions which were flushed before
+// |checkpoint| are skipped
 static inline void
 recover_journal(JournalState &state, Context *,
-                LocalTxnManager *txn_manager, uint64_t start_lsn)
+                LocalTxnManager *txn_manager, uint64_t start_lsn,
+                const JournalCheckpoint &checkpoint)
 {
   ups_status_t st = 0;
   Journal::Iterator it;
@@ -486,11 +1192,30 @@ recover_journal(JournalState &state, Context *,
   // do not append to the journal during recovery
   state.disable_logging = true;
 
+  // with several threads, the entries are read ahead and decompressed in
+  // parallel; they are still applied in their original order, because
+  // the databases share the Environment's pages
+  JournalRecoveryList entries;
+  size_t next = 0;
+  bool read_ahead = state.env->config.recovery_threads > 1;
+  if (read_ahead)
+    read_ahead_entries(state, start_lsn, state.env->config.recovery_threads,
+                    entries);
+
   do {
     PJournalEntry entry;
 
     // get the next entry
-    read_entry(state, &it, &entry, &buffer);
+    if (read_ahead) {
+      if (next == entries.size())
+        break;
+      entry = entries[next].entry;
+      if (entries[next].aux.size() > 0)
+        buffer.copy(entries[next].aux.data(), entries[next].aux.size());
+      next++;
+    }
+    else
+      read_entry(state, &it, &entry, &buffer);
 
     // reached end of logfile?
     if (!entry.lsn)
@@ -500,6 +1225,9 @@ recover_journal(JournalState &state, Context *,
     switch (entry.type) {
       case Journal::kEntryTypeTxnBegin: {
         Txn *txn = 0;
+        // the transaction was flushed before the checkpoint
+        if (entry.lsn < checkpoint.oldest_lsn)
+          continue;
         st = ups_txn_begin((ups_txn_t **)&txn, (ups_env_t *)state.env, 
                 (const char *)buffer.data(), 0, UPS_DONT_LOCK);
         // on success: patch the txn ID
@@ -511,11 +1239,15 @@ recover_journal(JournalState &state, Context *,
       }
       case Journal::kEntryTypeTxnAbort: {
         Txn *txn = get_txn(state, txn_manager, entry.txn_id);
+        if (!txn && checkpoint.lsn)
+          continue;
         st = ups_txn_abort((ups_txn_t *)txn, UPS_DONT_LOCK);
         break;
       }
       case Journal::kEntryTypeTxnCommit: {
         Txn *txn = get_txn(state, txn_manager, entry.txn_id);
+        if (!txn && checkpoint.lsn)
+          continue;
         st = ups_txn_commit((ups_txn_t *)txn, UPS_DONT_LOCK);
         break;
       }
@@ -533,6 +1265,13 @@ recover_journal(JournalState &state, Context *,
         // do not insert if the key was already flushed to disk
         if (entry.lsn <= start_lsn)
           continue;
+        if (entry.txn_id) {
+          txn = get_txn(state, txn_manager, entry.txn_id);
+          if (!txn && checkpoint.lsn)
+            continue;
+        }
+        else if (entry.lsn < checkpoint.oldest_lsn)
+          continue;
 
         uint8_t *payload = ins->key_data();
 
@@ -564,8 +1303,6 @@ recover_journal(JournalState &state, Context *,
           payload += ins->record_size;
         }
         record.size = ins->record_size;
-        if (entry.txn_id)
-          txn = get_txn(state, txn_manager, entry.txn_id);
         db = get_db(state, entry.dbname);
 
         // always use a cursor; otherwise flags like UPS_DUPLICATE_INSERT_FIRST
@@ -594,9 +1331,14 @@ recover_journal(JournalState &state, Context *,
         // do not erase if the key was already erased from disk
         if (entry.lsn <= start_lsn)
           continue;
-
-        if (entry.txn_id)
+        if (entry.txn_id) {
           txn = get_txn(state, txn_manager, entry.txn_id);
+          if (!txn && checkpoint.lsn)
+            continue;
+        }
+        else if (entry.lsn < checkpoint.oldest_lsn)
+          continue;
+
         db = get_db(state, entry.dbname);
         key.data = e->key_data();
         if (e->compressed_key_size != 0) {
@@ -619,6 +1361,10 @@ recover_journal(JournalState &state, Context *,
         // skip this; the changeset was already applied
         break;
       }
+      case Journal::kEntryTypeCheckpoint: {
+        // skip this; the checkpoint was already evaluated
+        break;
+      }
       default:
         ups_log(("invalid journal entry type or journal is corrupt"));
         st = UPS_IO_ERROR;
@@ -651,10 +1397,22 @@ JournalState::JournalState(LocalEnv *env_)
   : env(env_), current_fd(0), num_transactions(0),
     threshold(env_->config.journal_switch_threshold),
     disable_logging(false), count_bytes_flushed(0),
-    count_bytes_before_compression(0), count_bytes_after_compression(0)
+    count_bytes_before_compression(0), count_bytes_after_compression(0),
+    buffered_commits(0), write_fd(0), is_writer_stopping(false),
+    writer_status(0), queued_position(0), written_position(0),
+    synced_position(0), requested_position(0), urgent_position(0),
+    is_sync_active(false),
+    pending_commits(0),
+    group_commit_delay(env_->config.group_commit_delay_usec),
+    group_commit_size(env_->config.group_commit_size),
+    count_group_commits(0), count_group_commit_txns(0),
+    max_group_commit_size(0), buffer_max_lsn(0), checkpoint_position(0),
+    checkpoint_time(boost::get_system_time()), count_checkpoints(0)
 {
   if (threshold == 0)
     threshold = kSwitchTxnThreshold;
+  is_dirty[0] = is_dirty[1] = false;
+  max_lsn[0] = max_lsn[1] = 0;
 }
 
 Journal::Journal(LocalEnv *env)
@@ -665,6 +1423,11 @@ Journal::Journal(LocalEnv *env)
     state.compressor.reset(CompressorFactory::create(algo));
 }
 
+Journal::~Journal()
+{
+  stop_writer(state);
+}
+
 void
 Journal::create()
 {
@@ -673,6 +1436,7 @@ Journal::create()
     std::string path = log_file_path(state, i);
     state.files[i].create(path.c_str(), 0644);
   }
+  start_writer(state);
 }
 
 void
@@ -690,6 +1454,7 @@ Journal::open()
     state.files[0].close();
     throw ex;
   }
+  start_writer(state);
 }
 
 void
@@ -714,6 +1479,7 @@ Journal::append_txn_begin(LocalTxn *txn, const char *name, uint64_t lsn)
                 (uint8_t *)txn->name.c_str(), (uint32_t)txn->name.size() + 1);
   else
     append_entry(state, cur, (uint8_t *)&entry, (uint32_t)sizeof(entry));
+  track_lsn(state, lsn);
 
   state.num_transactions++;
 }
@@ -732,10 +1498,27 @@ Journal::append_txn_commit(LocalTxn *txn, uint64_t lsn)
   entry.type = Journal::kEntryTypeTxnCommit;
 
   append_entry(state, txn->log_descriptor, (uint8_t *)&entry, sizeof(entry));
+  track_lsn(state, lsn);
 
-  // flush after commit
+  // flush after commit; with UPS_ENABLE_FSYNC, the caller then waits
+  // for the sync (see sync())
   flush_buffer(state, state.current_fd,
-                  IS_SET(state.env->flags(), UPS_ENABLE_FSYNC));
+                  IS_SET(state.env->flags(), UPS_ENABLE_FSYNC)
+                      ? kFlushCommit
+                      : 0);
+}
+
+uint64_t
+Journal::appended_position()
+{
+  ScopedLock lock(state.sync_mutex);
+  return state.queued_position;
+}
+
+void
+Journal::sync(uint64_t position)
+{
+  sync_files(state, position, true);
 }
 
 void
@@ -821,10 +1604,13 @@ Journal::append_insert(Db *db, LocalTxn *txn,
                   (uint8_t *)&entry, sizeof(entry));
   state.buffer.overwrite(entry_position + sizeof(entry),
                   (uint8_t *)&insert, sizeof(PJournalEntryInsert) - 1);
+  track_lsn(state, lsn);
 
   if (IS_SET(txn->flags, UPS_TXN_TEMPORARY))
     flush_buffer(state, state.current_fd,
-                    IS_SET(state.env->flags(), UPS_ENABLE_FSYNC));
+                    IS_SET(state.env->flags(), UPS_ENABLE_FSYNC)
+                        ? kFlushSync
+                        : 0);
 }
 
 void
@@ -875,10 +1661,13 @@ Journal::append_erase(Db *db, LocalTxn *txn, ups_key_t *key,
   append_entry(state, idx, (uint8_t *)&entry, sizeof(entry),
                 (uint8_t *)&erase, sizeof(PJournalEntryErase) - 1,
                 (uint8_t *)payload_data, payload_size);
+  track_lsn(state, lsn);
 
   if (IS_SET(txn->flags, UPS_TXN_TEMPORARY))
     flush_buffer(state, state.current_fd,
-                    IS_SET(state.env->flags(), UPS_ENABLE_FSYNC));
+                    IS_SET(state.env->flags(), UPS_ENABLE_FSYNC)
+                        ? kFlushSync
+                        : 0);
 }
 
 int
@@ -922,18 +1711,94 @@ Journal::append_changeset(std::vector<Page *> &pages,
 
   // and patch in the followup-size
   state.buffer.overwrite(entry_position, (uint8_t *)&entry, sizeof(entry));
+  track_lsn(state, lsn);
 
   UPS_INDUCE_ERROR(ErrorInducer::kChangesetFlush);
 
-  // and flush the file
+  // and flush the file; the database file is modified afterwards, therefore
+  // the changeset has to be written (or synced) before returning
   flush_buffer(state, state.current_fd,
-                  IS_SET(state.env->flags(), UPS_ENABLE_FSYNC));
+                  IS_SET(state.env->flags(), UPS_ENABLE_FSYNC)
+                      ? kFlushWrite | kFlushSync
+                      : kFlushWrite);
 
   UPS_INDUCE_ERROR(ErrorInducer::kChangesetFlush);
 
   return state.current_fd;
 }
 
+void
+Journal::append_checkpoint(uint64_t oldest_lsn,
+                const std::map<uint64_t, uint64_t> &dirty_pages, uint64_t lsn)
+{
+  if (unlikely(state.disable_logging))
+    return;
+
+  // entries older than |redo_lsn| are no longer required for the recovery
+  uint64_t redo_lsn = std::min(oldest_lsn, lsn);
+  for (std::map<uint64_t, uint64_t>::const_iterator it = dirty_pages.begin();
+                  it != dirty_pages.end();
+                  ++it)
+    redo_lsn = std::min(redo_lsn, it->second);
+
+  // the other file is older than the current one; if its entries are no
+  // longer required then clear it, and continue with this file
+  flush_buffer(state, state.current_fd, kFlushWrite);
+  int other = state.current_fd ? 0 : 1;
+  if (state.max_lsn[other] < redo_lsn) {
+    clear_file(state, other);
+    state.current_fd = other;
+    state.num_transactions = 0;
+  }
+
+  PJournalEntry entry;
+  entry.lsn = lsn;
+  entry.type = Journal::kEntryTypeCheckpoint;
+  entry.followup_size = sizeof(PJournalEntryCheckpoint)
+          + dirty_pages.size() * sizeof(PJournalEntryDirtyPage);
+
+  PJournalEntryCheckpoint checkpoint;
+  checkpoint.oldest_lsn = oldest_lsn;
+  checkpoint.num_pages = dirty_pages.size();
+
+  append_entry(state, state.current_fd, (uint8_t *)&entry, sizeof(entry),
+                (uint8_t *)&checkpoint, sizeof(checkpoint));
+  for (std::map<uint64_t, uint64_t>::const_iterator it = dirty_pages.begin();
+                  it != dirty_pages.end();
+                  ++it) {
+    PJournalEntryDirtyPage page(it->first, it->second);
+    append_entry(state, state.current_fd, (uint8_t *)&page, sizeof(page));
+  }
+  track_lsn(state, lsn);
+
+  flush_buffer(state, state.current_fd,
+                  IS_SET(state.env->flags(), UPS_ENABLE_FSYNC)
+                      ? kFlushWrite | kFlushSync
+                      : kFlushWrite);
+
+  ScopedLock lock(state.sync_mutex);
+  state.checkpoint_position = state.queued_position;
+  state.checkpoint_time = boost::get_system_time();
+  state.count_checkpoints++;
+}
+
+bool
+Journal::is_checkpoint_due()
+{
+  uint32_t interval = state.env->config.checkpoint_interval_sec;
+  uint64_t size = state.env->config.checkpoint_size;
+  if (likely(interval == 0 && size == 0) || state.disable_logging)
+    return false;
+
+  ScopedLock lock(state.sync_mutex);
+  if (size > 0 && state.queued_position + state.buffer.size()
+                    >= state.checkpoint_position + size)
+    return true;
+  return interval > 0 && boost::get_system_time()
+                    >= state.checkpoint_time
+                            + boost::posix_time::seconds(interval);
+}
+
 void
 Journal::close(bool noclear)
 {
@@ -941,7 +1806,10 @@ Journal::close(bool noclear)
   // contain the correct data. Flush the buffers, otherwise the tests will
   // fail because data is missing
   if (unlikely(noclear))
-    flush_buffer(state, 0);
+    flush_buffer(state, 0, kFlushWrite);
+
+  wait_for_writer(state);
+  stop_writer(state);
 
   if (likely(!noclear))
     clear();
@@ -957,8 +1825,12 @@ Journal::recover(LocalTxnManager *txn_manager)
 {
   Context context(state.env, 0, 0);
 
+  // the recovery starts at the last checkpoint
+  JournalCheckpoint checkpoint;
+  find_last_checkpoint(state, checkpoint);
+
   // first redo the changesets
-  uint64_t start_lsn = recover_changeset(state);
+  uint64_t start_lsn = recover_changeset(state, checkpoint);
 
   // load the state of the PageManager; the PageManager state is loaded AFTER
   // physical recovery because its page might have been restored in
@@ -969,7 +1841,7 @@ Journal::recover(LocalTxnManager *txn_manager)
 
   // then start the normal recovery
   if (IS_SET(state.env->flags(), UPS_ENABLE_TRANSACTIONS))
-    recover_journal(state, &context, txn_manager, start_lsn);
+    recover_journal(state, &context, txn_manager, start_lsn, checkpoint);
 
   // clear the journal files
   clear();
@@ -978,6 +1850,7 @@ Journal::recover(LocalTxnManager *txn_manager)
 void
 Journal::clear()
 {
+  wait_for_writer(state);
   for (int i = 0; i < 2; i++)
     clear_file(state, i);
 }
@@ -985,8 +1858,8 @@ Journal::clear()
 void
 Journal::test_flush_buffers()
 {
-  flush_buffer(state, 0);
-  flush_buffer(state, 1);
+  flush_buffer(state, 0, kFlushWrite);
+  flush_buffer(state, 1, kFlushWrite);
 }
 
 void
@@ -37,6 +37,23 @@
  * was written. In case of a commit or a changeset there will also be an
  * fsync, if UPS_ENABLE_FSYNC is enabled.
  *
+ * Commits are synced in groups: the committing thread releases the
+ * Environment's lock and waits in sync(). The first waiting thread
+ * becomes the leader and issues one fsync for all commits which were
+ * written so far (optionally after waiting for more commits, see
+ * UPS_PARAM_JOURNAL_GROUP_COMMIT_DELAY); the others wait till a sync
+ * covers their commit. Changesets are still synced immediately, because
+ * the database file is modified afterwards.
+ *
+ * With UPS_PARAM_JOURNAL_WRITER_THREAD, the buffer is handed over to a
+ * writer thread instead (it is swapped with a second buffer), and the
+ * writer thread performs the writes and the syncs. A commit without
+ * UPS_ENABLE_FSYNC does not wait for the writer; if it is still busy then
+ * the data remains in the buffer till the next commit. Positions in the
+ * stream of journal data serve as watermarks: sync() waits till the
+ * synced position reaches the position of the commit. Changesets and
+ * log file switches still wait till the data was written.
+ *
  * The physical information is a collection of pages which are modified in
  * one or more database operations (i.e. ups_db_erase). This collection is
  * called a "changeset" and implemented in changeset.h/.cc. As soon as the
@@ -64,6 +81,16 @@
  * already applied, and we know that all older changesets
  * have already been written successfully to the database file.
  *
+ * A checkpoint (ups_env_checkpoint) records the "dirty page table" - the
+ * pages of changesets which are not yet completely written to the
+ * database file - and the lsn of the oldest transaction which was not yet
+ * flushed. The checkpoint does not wait for the worker threads which write
+ * these pages. Entries older than both lsns are no longer required; the
+ * checkpoint then clears the other file and switches to it. The recovery
+ * starts at the last checkpoint: older changesets are only re-applied for
+ * the pages in its dirty page table, and transactions which began before
+ * its oldest lsn are skipped.
+ *
  * @exception_safe: basic
  * @thread_safe: no
  */
@@ -73,6 +100,7 @@
 
 #include "0root/root.h"
 
+#include <map>
 #include <vector>
 #include <cstdio>
 #include <string>
@@ -128,7 +156,10 @@ struct Journal
     kEntryTypeErase      = 5,
 
     // marks a whole changeset operation (writes modified pages)
-    kEntryTypeChangeset  = 6
+    kEntryTypeChangeset  = 6,
+
+    // marks a checkpoint (stores the dirty page table)
+    kEntryTypeCheckpoint = 7
   };
 
   //
@@ -152,6 +183,9 @@ struct Journal
   // Constructor
   Journal(LocalEnv *env);
 
+  // Destructor; stops the writer thread
+  ~Journal();
+
   // Creates a new journal
   void create();
 
@@ -179,6 +213,16 @@ struct Journal
   // Appends a journal entry for ups_txn_commit/kEntryTypeTxnCommit
   void append_txn_commit(LocalTxn *txn, uint64_t lsn);
 
+  // Returns the number of bytes appended to the files (the writer thread
+  // might not yet have written them); after a commit, this is the
+  // parameter for sync()
+  uint64_t appended_position();
+
+  // Waits till the first |position| bytes are on disk; issues the fsync
+  // for the whole group of pending commits if no other thread does.
+  // Must be called without holding the Environment's lock
+  void sync(uint64_t position);
+
   // Appends a journal entry for ups_insert/kEntryTypeInsert
   void append_insert(Db *db, LocalTxn *txn,
                   ups_key_t *key, ups_record_t *record, uint32_t flags,
@@ -195,6 +239,18 @@ struct Journal
   int append_changeset(std::vector<Page *> &pages, uint64_t last_blob_page,
                   uint64_t lsn);
 
+  // Appends a checkpoint/kEntryTypeCheckpoint. |oldest_lsn| is the lsn of
+  // the oldest transaction which was not yet flushed, |dirty_pages| maps
+  // the pages which are not yet written to the lsn of their changeset.
+  // Clears the older file if it is no longer required
+  void append_checkpoint(uint64_t oldest_lsn,
+                  const std::map<uint64_t, uint64_t> &dirty_pages,
+                  uint64_t lsn);
+
+  // Returns true if an automatic checkpoint is due (see
+  // UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL, UPS_PARAM_JOURNAL_CHECKPOINT_SIZE)
+  bool is_checkpoint_due();
+
   // Empties the journal, removes all entries
   void clear();
 
@@ -207,11 +263,17 @@ struct Journal
 
   // Fills the metrics
   void fill_metrics(ups_env_metrics_t *metrics) {
-    metrics->journal_bytes_flushed = state.count_bytes_flushed;
     metrics->journal_bytes_before_compression
             = state.count_bytes_before_compression;
     metrics->journal_bytes_after_compression
             = state.count_bytes_after_compression;
+
+    ScopedLock lock(state.sync_mutex);
+    metrics->journal_bytes_flushed = state.count_bytes_flushed;
+    metrics->journal_group_commits = state.count_group_commits;
+    metrics->journal_group_commit_txns = state.count_group_commit_txns;
+    metrics->journal_group_commit_max_size = state.max_group_commit_size;
+    metrics->journal_checkpoints = state.count_checkpoints;
   }
 
   // Flushes all buffers to disk. Used for testing.
@@ -201,6 +201,52 @@ UPS_PACK_0 struct UPS_PACK_1 PJournalEntryPageHeader {
 
 #include "1base/packstop.h"
 
+
+#include "1base/packstart.h"
+
+//
+// a Journal entry for a checkpoint; it is followed by |num_pages|
+// structures of type PJournalEntryDirtyPage
+//
+UPS_PACK_0 struct UPS_PACK_1 PJournalEntryCheckpoint {
+  // Constructor - sets all fields to 0
+  PJournalEntryCheckpoint()
+    : oldest_lsn(0), num_pages(0), _reserved(0) {
+  }
+
+  // the lsn of the oldest transaction which was not yet flushed
+  uint64_t oldest_lsn;
+
+  // number of pages in the dirty page table
+  uint32_t num_pages;
+
+  // a reserved value - reqd for padding
+  uint32_t _reserved;
+} UPS_PACK_2;
+
+#include "1base/packstop.h"
+
+
+#include "1base/packstart.h"
+
+//
+// a page of the dirty page table of a checkpoint
+//
+UPS_PACK_0 struct UPS_PACK_1 PJournalEntryDirtyPage {
+  // Constructor - sets all fields to 0
+  PJournalEntryDirtyPage(uint64_t _address = 0, uint64_t _lsn = 0)
+    : address(_address), lsn(_lsn) {
+  }
+
+  // the page address
+  uint64_t address;
+
+  // the lsn of the changeset which is not yet written to the file
+  uint64_t lsn;
+} UPS_PACK_2;
+
+#include "1base/packstop.h"
+
 } // namespace upscaledb
 
 #endif /* UPS_JOURNAL_ENTRIES_H */
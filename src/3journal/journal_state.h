@@ -28,6 +28,7 @@
 #include "ups/types.h" // for metrics
 
 #include "1base/dynamic_array.h"
+#include "1base/mutex.h"
 #include "1os/file.h"
 #include "2page/page_collection.h"
 #include "2compressor/compressor.h"
@@ -58,6 +59,9 @@ struct JournalState {
   // Buffer for writing data to the files
   ByteArray buffer;
 
+  // The number of commits in |buffer| which wait for the next sync
+  uint32_t buffered_commits;
+
   // Counts all transactions in the current file
   uint32_t num_transactions;
 
@@ -83,6 +87,83 @@ struct JournalState {
 
   // The compressor; can be null
   std::unique_ptr<Compressor> compressor;
+
+  // Protects the following members, which implement the group commit
+  // (see Journal::sync()) and the writer thread
+  Mutex sync_mutex;
+
+  // Signalled whenever one of the following members changes
+  Condition sync_cond;
+
+  // The writer thread; null if the files are written by the caller
+  std::unique_ptr<Thread> writer;
+
+  // The buffer which is written by the writer thread; it is swapped with
+  // |buffer|
+  ByteArray write_buffer;
+
+  // The file of |write_buffer|
+  int write_fd;
+
+  // Set to stop the writer thread
+  bool is_writer_stopping;
+
+  // The first error of the writer thread
+  ups_status_t writer_status;
+
+  // The number of bytes handed to the writer thread so far
+  uint64_t queued_position;
+
+  // The number of bytes written to the files so far; the writer thread
+  // might lag behind |queued_position|
+  uint64_t written_position;
+
+  // The number of bytes which are known to be on disk
+  uint64_t synced_position;
+
+  // The writer thread syncs the files till this position...
+  uint64_t requested_position;
+
+  // ... and without waiting for more commits till this position
+  uint64_t urgent_position;
+
+  // True if a file was written since the last sync
+  bool is_dirty[2];
+
+  // True while a thread syncs the files for a group
+  bool is_sync_active;
+
+  // The number of commits which were written since the last sync
+  uint32_t pending_commits;
+
+  // The maximum time (in microseconds) a sync waits for more commits
+  uint32_t group_commit_delay;
+
+  // A sync stops waiting when this many commits are pending
+  uint32_t group_commit_size;
+
+  // Counting the syncs of committed transactions (for ups_env_get_metrics)
+  uint64_t count_group_commits;
+
+  // Counting the commits made durable by these syncs
+  uint64_t count_group_commit_txns;
+
+  // The largest number of commits made durable by a single sync
+  uint64_t max_group_commit_size;
+
+  // The highest lsn in each file, and in |buffer|; a checkpoint clears
+  // a file if its entries are no longer required
+  uint64_t max_lsn[2];
+  uint64_t buffer_max_lsn;
+
+  // The value of |queued_position| after the last checkpoint
+  uint64_t checkpoint_position;
+
+  // The time of the last checkpoint
+  boost::system_time checkpoint_time;
+
+  // Counting the checkpoints (for ups_env_get_metrics)
+  uint64_t count_checkpoints;
 };
 
 } // namespace upscaledb
@@ -29,13 +29,12 @@
 
 namespace upscaledb {
 
-std::pair<bool, Freelist::FreeMap::const_iterator>
-Freelist::encode_state(std::pair<bool, Freelist::FreeMap::const_iterator> cont,
-                uint8_t *data, size_t data_size)
+Freelist::EncodeCursor
+Freelist::encode_state(EncodeCursor cont, uint8_t *data, size_t data_size)
 {
   uint32_t page_size = config.page_size_bytes;
-  Freelist::FreeMap::const_iterator it = cont.second;
-  if (cont.first == false)
+  FreeMap::const_iterator it = cont.it;
+  if (cont.more == false)
     it = free_pages.begin();
   else
     assert(it != free_pages.end());
@@ -45,39 +44,30 @@ Freelist::encode_state(std::pair<bool, Freelist::FreeMap::const_iterator> cont,
   p += 8;   // leave room for the pointer to the next page
   p += 4;   // leave room for the counter
 
-  while (it != free_pages.end()) {
-    // 9 bytes is the maximum amount of storage that we will need for a
+  // the distances are relative to the end of the previous run; each page
+  // starts at 0, therefore it can be decoded independently
+  uint64_t previous = 0;
+
+  for (; it != free_pages.end(); it++) {
+    // this is the maximum amount of storage that we will need for a
     // new entry; if it does not fit then break
-    if ((p + 9) - data >= (ptrdiff_t)data_size)
+    if ((p + 2 * Pickle::kMaxVarintSize) - data >= (ptrdiff_t)data_size)
       break;
 
-    // check if the next entry (and the following) are adjacent; if yes then
-    // they are merged. Up to 16 pages can be merged.
-    uint32_t page_counter = 1;
-    uint64_t base = it->first;
-    assert(base % page_size == 0);
-    uint64_t current = it->first;
-
-    // move to the next entry, then merge all adjacent pages
-    for (it++; it != free_pages.end() && page_counter < 16 - 1; it++) {
-      if (it->first != current + page_size)
-        break;
-      current += page_size;
-      page_counter++;
-    }
+    // skip empty runs
+    if (it->second == 0)
+      continue;
+
+    uint64_t base = it->first / page_size;
+    assert(it->first % page_size == 0);
+    assert(base >= previous);
 
-    // now |base| is the start of a sequence of free pages, and the
-    // sequence has |page_counter| pages
-    //
     // This is encoded as
-    // - 1 byte header
-    //   - 4 bits for |page_counter|
-    //   - 4 bits for the number of bytes following ("n")
-    // - n byte page-id (div page_size)
-    assert(page_counter < 16);
-    int num_bytes = Pickle::encode_u64(p + 1, base / page_size);
-    *p = (page_counter << 4) | num_bytes;
-    p += 1 + num_bytes;
+    // - varint: distance (in pages) from the end of the previous run
+    // - varint: number of pages
+    p += Pickle::encode_varint(p, base - previous);
+    p += Pickle::encode_varint(p, it->second);
+    previous = base + it->second;
 
     counter++;
   }
@@ -85,14 +75,14 @@ Freelist::encode_state(std::pair<bool, Freelist::FreeMap::const_iterator> cont,
   // now store the counter
   *(uint32_t *)(data + 8) = counter;
 
-  std::pair<bool, Freelist::FreeMap::const_iterator> retval;
-  retval.first = (it != free_pages.end());
-  retval.second = it;
+  EncodeCursor retval;
+  retval.more = (it != free_pages.end());
+  retval.it = it;
   return retval;
 }
 
 void
-Freelist::decode_state(uint8_t *data)
+Freelist::decode_state(uint8_t *data, int format)
 {
   uint32_t page_size = config.page_size_bytes;
 
@@ -100,6 +90,23 @@ Freelist::decode_state(uint8_t *data)
   uint32_t counter = *(uint32_t *)data;
   data += 4;
 
+  if (format == kFormatVarint) {
+    uint64_t previous = 0;
+    for (uint32_t i = 0; i < counter; i++) {
+      uint64_t distance, page_counter;
+      data += Pickle::decode_varint(data, &distance);
+      data += Pickle::decode_varint(data, &page_counter);
+      assert(page_counter > 0);
+
+      uint64_t id = previous + distance;
+      put(id * page_size, (size_t)page_counter);
+      previous = id + page_counter;
+    }
+    return;
+  }
+
+  assert(format == kFormatNibble);
+
   // now read all pages
   for (uint32_t i = 0; i < counter; i++) {
     // 4 bits page_counter, 4 bits for number of following bytes
@@ -112,7 +119,8 @@ Freelist::decode_state(uint8_t *data)
     uint64_t id = Pickle::decode_u64(num_bytes, data);
     data += num_bytes;
 
-    free_pages[id * page_size] = page_counter;
+    // sequences of the same run are merged again
+    put(id * page_size, page_counter);
   }
 }
 
@@ -122,20 +130,17 @@ Freelist::alloc(size_t num_pages)
   uint64_t address = 0;
   uint32_t page_size = config.page_size_bytes;
 
-  for (FreeMap::iterator it = free_pages.begin();
-            it != free_pages.end();
-            it++) {
-    if (it->second == num_pages) {
-      address = it->first;
-      free_pages.erase(it);
-      break;
-    }
-    if (it->second > num_pages) {
-      address = it->first;
-      free_pages[it->first + num_pages * page_size] = it->second - num_pages;
-      free_pages.erase(it);
-      break;
-    }
+  // best fit: pick the smallest run with at least |num_pages| pages; if
+  // there are several, then pick the one with the lowest address
+  SizeIndex::iterator it = size_index.lower_bound(
+                  std::make_pair(num_pages, (uint64_t)0));
+  if (it != size_index.end()) {
+    address = it->second;
+    size_t page_count = it->first;
+    size_index.erase(it);
+    free_pages.erase(address);
+    if (page_count > num_pages)
+      insert_run(address + num_pages * page_size, page_count - num_pages);
   }
 
   if (address != 0)
@@ -149,13 +154,44 @@ Freelist::alloc(size_t num_pages)
 void
 Freelist::put(uint64_t page_id, size_t page_count)
 {
-  free_pages[page_id] = page_count;
+  uint32_t page_size = config.page_size_bytes;
+
+  // pages which are already free are ignored
+  if (unlikely(has(page_id)))
+    return;
+
+  // merge with the following run
+  FreeMap::iterator next = free_pages.lower_bound(page_id);
+  if (next != free_pages.end()
+        && next->first == page_id + page_count * page_size) {
+    page_count += next->second;
+    FreeMap::iterator it = next++;
+    erase_run(it);
+  }
+
+  // merge with the preceding run
+  if (next != free_pages.begin()) {
+    FreeMap::iterator prev = next;
+    prev--;
+    if (prev->first + prev->second * page_size == page_id) {
+      page_id = prev->first;
+      page_count += prev->second;
+      erase_run(prev);
+    }
+  }
+
+  insert_run(page_id, page_count);
 }
 
 bool
 Freelist::has(uint64_t page_id) const
 {
-  return free_pages.find(page_id) != free_pages.end();
+  // find the run which starts at or before |page_id|
+  FreeMap::const_iterator it = free_pages.upper_bound(page_id);
+  if (it == free_pages.begin())
+    return false;
+  it--;
+  return page_id < it->first + it->second * config.page_size_bytes;
 }
 
 uint64_t
@@ -177,9 +213,8 @@ Freelist::truncate(uint64_t file_size)
   }
 
   // remove all truncated pages
-  while (!free_pages.empty() && free_pages.rbegin()->first >= lower_bound) {
-    free_pages.erase(free_pages.rbegin()->first);
-  }
+  while (!free_pages.empty() && free_pages.rbegin()->first >= lower_bound)
+    erase_run(--free_pages.end());
 
   return lower_bound;
 }
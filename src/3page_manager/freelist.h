@@ -19,6 +19,18 @@
 /*
  * The Freelist manages the list of currently unused (free) pages.
  *
+ * Free pages are stored as runs of adjacent pages, indexed by their address.
+ * Adjacent runs are coalesced when pages are added. A second index sorts
+ * the runs by their length, therefore the smallest run which is big enough
+ * for an allocation (best fit) is found in logarithmic time.
+ *
+ * The persisted state stores each run as a pair of varints: the distance
+ * (in pages) from the end of the previous run, and the length of the run.
+ * Files which were created by older versions store runs of up to 15 pages
+ * with a 4-bit length (kFormatNibble); this format is still read, but
+ * the state is always written in the new format. The format is stored
+ * in the Environment header.
+ *
  * @exception_safe: basic
  * @thread_safe: no
  */
@@ -29,6 +41,7 @@
 #include "0root/root.h"
 
 #include <map>
+#include <set>
 
 // Always verify that a file of level N does not include headers > N!
 #include "2config/env_config.h"
@@ -44,6 +57,32 @@ struct Freelist
   // The freelist maps page-id to number of free pages (usually 1)
   typedef std::map<uint64_t, size_t> FreeMap;
 
+  // Index of the runs, sorted by length and page-id
+  typedef std::set<std::pair<size_t, uint64_t> > SizeIndex;
+
+  // The formats of the persisted state
+  enum {
+    // 4 bits run length, 4 bits size of the page-id, followed by the
+    // page-id (see Pickle::encode_u64)
+    kFormatNibble = 0,
+
+    // varint distance to the previous run, varint run length
+    kFormatVarint = 1
+  };
+
+  // The position of encode_state() in the freelist
+  struct EncodeCursor {
+    EncodeCursor()
+      : more(false) {
+    }
+
+    // false for the first call; true if there is more data to encode
+    bool more;
+
+    // the run which is encoded next
+    FreeMap::const_iterator it;
+  };
+
   // Constructor
   Freelist(const EnvConfig &config_)
     : config(config_) {
@@ -55,6 +94,7 @@ struct Freelist
     freelist_hits = 0;
     freelist_misses = 0;
     free_pages.clear();
+    size_index.clear();
   }
 
   // Returns true if the freelist is empty
@@ -62,24 +102,23 @@ struct Freelist
     return free_pages.empty();
   }
 
-  // Encodes the freelist's state in |data|. Returns a bool which is set to
-  // true if there is additional data, or false if the whole state was
-  // encoded.
-  // Set |cont.first| to false for the first call.
-  std::pair<bool, Freelist::FreeMap::const_iterator>
-                    encode_state(
-                        std::pair<bool, Freelist::FreeMap::const_iterator> cont,
-                        uint8_t *data, size_t data_size);
+  // Encodes the freelist's state in |data| (in kFormatVarint). Returns a
+  // cursor; its |more| flag is set to true if there is additional data, or
+  // false if the whole state was encoded.
+  // Use a default-constructed cursor for the first call.
+  EncodeCursor encode_state(EncodeCursor cont, uint8_t *data,
+                  size_t data_size);
 
-  // Decodes the freelist's state from raw data and adds it to the internal
-  // map
-  void decode_state(uint8_t *data);
+  // Decodes the freelist's state from raw data in the specified |format|
+  // and adds it to the internal map
+  void decode_state(uint8_t *data, int format = kFormatVarint);
 
   // Allocates |num_pages| sequential pages from the freelist; returns the
-  // page id of the first page, or 0 if not successfull
+  // page id of the first page, or 0 if not successfull. Uses the smallest
+  // run which is big enough.
   uint64_t alloc(size_t num_pages);
 
-  // Stores a page in the freelist
+  // Stores a page in the freelist; merges it with adjacent runs
   void put(uint64_t page_id, size_t page_count);
 
   // Returns true if a page is in the freelist
@@ -90,12 +129,27 @@ struct Freelist
   // if there are no unused pages at the end.
   uint64_t truncate(uint64_t file_size);
 
+  // Adds a run to both indices
+  void insert_run(uint64_t page_id, size_t page_count) {
+    free_pages[page_id] = page_count;
+    size_index.insert(std::make_pair(page_count, page_id));
+  }
+
+  // Removes a run from both indices
+  void erase_run(FreeMap::iterator it) {
+    size_index.erase(std::make_pair(it->second, it->first));
+    free_pages.erase(it);
+  }
+
   // Copy of the Environment's configuration
   const EnvConfig &config;
 
   // The map with free pages
   FreeMap free_pages;
 
+  // The runs of |free_pages|, sorted by their length
+  SizeIndex size_index;
+
   // number of successful freelist hits
   uint64_t freelist_hits;
 
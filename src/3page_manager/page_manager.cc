@@ -21,11 +21,12 @@
 #include "0root/root.h"
 
 #include <string.h>
+#include <algorithm>
 
-#include "3rdparty/murmurhash3/MurmurHash3.h"
 // Always verify that a file of level N does not include headers > N!
 #include "1base/signal.h"
 #include "1base/dynamic_array.h"
+#include "1os/file.h"
 #include "2page/page.h"
 #include "2device/device.h"
 #include "3page_manager/page_manager.h"
@@ -59,7 +60,7 @@ struct AsyncFlushMessage
   AsyncFlushMessage(PageManager *page_manager_, Device *device_,
           Signal *signal_)
     : page_manager(page_manager_), device(device_), signal(signal_),
-      in_progress(false) {
+      in_progress(false), pending(0) {
   }
 
   PageManager *page_manager;
@@ -67,44 +68,71 @@ struct AsyncFlushMessage
   Signal *signal;
   boost::atomic<bool> in_progress;
   std::vector<uint64_t> page_ids;
+
+  // the number of partitions which are not yet flushed
+  boost::atomic<size_t> pending;
 };
 
+// Flushes the pages in |message->page_ids[begin, end)|; the last partition
+// which finishes notifies the caller
 static void
-async_flush_pages(AsyncFlushMessage *message)
+async_flush_pages(AsyncFlushMessage *message, size_t begin, size_t end)
 {
-  for (std::vector<uint64_t>::iterator it = message->page_ids.begin();
-                  it != message->page_ids.end();
+  std::vector<Page *> pages;
+  pages.reserve(end - begin);
+
+  for (std::vector<uint64_t>::iterator it = message->page_ids.begin() + begin;
+                  it != message->page_ids.begin() + end;
                   it++) {
     // skip page if it's already in use
     Page *page = message->page_manager->try_lock_purge_candidate(*it);
     if (!page)
       continue;
     assert(page->mutex().try_lock() == false);
+    pages.push_back(page);
+  }
 
-    // flush page if it's dirty
-    if (page->is_dirty()) {
-      try {
-        page->flush();
-      }
-      catch (Exception &) {
-        // ignore page, fall through
-      }
-    }
-    page->mutex().unlock();
+  // flush the dirty pages; the ids are sorted, therefore adjacent pages
+  // are written with a single call
+  try {
+    Page::flush(pages.data(), pages.size());
   }
+  catch (Exception &) {
+    // ignore the pages, fall through; they remain dirty
+  }
+
+  for (std::vector<Page *>::iterator it = pages.begin();
+                  it != pages.end();
+                  it++)
+    (*it)->mutex().unlock();
+
+  if (--message->pending > 0)
+    return;
   if (message->in_progress)
     message->in_progress = false;
   if (message->signal)
     message->signal->notify();
 }
 
+// Sorts the pages of |message| by address and splits them into adjacent
+// ranges, which are flushed by different worker threads
+static void
+schedule_flush(PageManager *page_manager, AsyncFlushMessage *message)
+{
+  std::vector<uint64_t> &ids = message->page_ids;
+  std::sort(ids.begin(), ids.end());
+  size_t partitions = page_manager->flush_partitions(ids.size());
+  message->pending = partitions;
+  for (size_t i = 0; i < partitions; i++)
+    page_manager->run_async(boost::bind(&async_flush_pages, message,
+                            i * ids.size() / partitions,
+                            (i + 1) * ids.size() / partitions), i);
+}
+
 static inline void
 verify_crc32(Page *page)
 {
-  uint32_t crc32;
-  MurmurHash3_x86_32(page->payload(),
-                  page->persisted_data.size - (sizeof(PPageHeader) - 1),
-                  (uint32_t)page->address(), &crc32);
+  uint32_t crc32 = page->calculate_crc32();
   if (crc32 != page->crc32()) {
     ups_trace(("crc32 mismatch in page %lu: 0x%lx != 0x%lx",
                     page->address(), crc32, page->crc32()));
@@ -112,6 +140,222 @@ verify_crc32(Page *page)
   }
 }
 
+// The header of the cache warm-up manifest; it is followed by |count|
+// page addresses, the most recently used pages first
+UPS_PACK_0 struct UPS_PACK_1 PWarmupManifest
+{
+  // the magic; always 'W', 'R', 'M', '1'
+  uint32_t magic;
+
+  // the page size of the Environment
+  uint32_t page_size;
+
+  // the number of stored page addresses
+  uint64_t count;
+} UPS_PACK_2;
+
+enum {
+  // the magic of the warm-up manifest
+  kWarmupMagic = ('W' << 24) | ('R' << 16) | ('M' << 8) | '1',
+
+  // the number of addresses which are loaded by one message of the
+  // worker thread; other messages (i.e. for flushing) are not delayed
+  // for long
+  kWarmupBatchSize = 256,
+
+  // the maximum number of adjacent pages which are read at once
+  kWarmupMaxRunPages = 32
+};
+
+struct AsyncWarmupMessage
+{
+  AsyncWarmupMessage(PageManager *page_manager_)
+    : page_manager(page_manager_), next(0), cancelled(false) {
+  }
+
+  PageManager *page_manager;
+
+  // the addresses of the pages, the most recently used pages first
+  std::vector<uint64_t> addresses;
+
+  // index of the next address in |addresses| which is loaded
+  size_t next;
+
+  // set when the PageManager is closed
+  boost::atomic<bool> cancelled;
+};
+
+static inline std::string
+warmup_manifest_path(PageManagerState *state)
+{
+  return state->config.filename + ".wrm";
+}
+
+// Records the recently used pages for the warm-up manifest. This is
+// also called before a database is closed, because the pages of a closed
+// database are removed from the cache. The pages which are currently
+// cached are moved to the front.
+static inline void
+record_recent_pages(PageManagerState *state)
+{
+  if (state->config.cache_warmup_pages == 0
+        || IS_SET(state->config.flags, UPS_IN_MEMORY)
+        || IS_SET(state->config.flags, UPS_READ_ONLY))
+    return;
+
+  size_t limit = (size_t)std::min((uint64_t)state->config.cache_warmup_pages,
+                          state->cache.capacity()
+                                / state->config.page_size_bytes);
+
+  std::vector<uint64_t> addresses;
+  state->cache.recent_pages(addresses, limit);
+  std::vector<uint64_t> sorted(addresses);
+  std::sort(sorted.begin(), sorted.end());
+
+  for (std::vector<uint64_t>::iterator it = state->recent_pages.begin();
+          it != state->recent_pages.end() && addresses.size() < limit;
+          it++) {
+    if (!std::binary_search(sorted.begin(), sorted.end(), *it))
+      addresses.push_back(*it);
+  }
+  state->recent_pages.swap(addresses);
+}
+
+// Reads the pages at the (sorted) |addresses| and stores them in the
+// cache. Adjacent pages are read with a single I/O operation, all others
+// are submitted to the device as a batch. The pages are read without
+// holding the PageManager's mutex, therefore a live request for one of
+// these pages is not blocked; it reads the page itself, and the prefetched
+// copy is discarded. Returns false if the cache is full or the PageManager
+// is closed.
+static bool
+warm_up_pages(PageManagerState *state, AsyncWarmupMessage *message,
+                const std::vector<uint64_t> &addresses)
+{
+  uint32_t page_size = state->config.page_size_bytes;
+  size_t count = addresses.size();
+  uint64_t address = addresses.front();
+  std::vector<Page *> pages;
+  pages.reserve(count);
+
+  // pages are only written by Page::flush(); if a page was flushed while
+  // the data was read then the data might be outdated
+  uint64_t flushed = Page::ms_page_count_flushed;
+
+  try {
+    // encrypted pages are decrypted one by one; mapped pages do not
+    // require any I/O
+    if (count > 1
+          && addresses.back() == address + (count - 1) * page_size
+          && !state->config.is_encryption_enabled
+          && !state->device->is_mapped(address, count * page_size)) {
+      std::vector<uint8_t> buffer(count * page_size);
+      state->device->read(address, buffer.data(), buffer.size());
+      for (size_t i = 0; i < count; i++) {
+        Page *page = new Page(state->device);
+        pages.push_back(page);
+        state->device->allocate_page_buffer(page, address + i * page_size);
+        ::memcpy(page->data(), &buffer[i * page_size], page_size);
+      }
+    }
+    else {
+      for (size_t i = 0; i < count; i++)
+        pages.push_back(new Page(state->device));
+      state->device->read_pages(pages.data(), addresses.data(), count);
+    }
+  }
+  catch (Exception &) {
+    std::for_each(pages.begin(), pages.end(), Deleter<Page>());
+    return true;
+  }
+
+  bool proceed = true;
+  ScopedSpinlock lock(state->mutex);
+  for (size_t i = 0; i < pages.size(); i++) {
+    Page *page = pages[i];
+    if (proceed && (message->cancelled || state->cache.is_cache_full()))
+      proceed = false;
+
+    if (!proceed
+          || flushed != Page::ms_page_count_flushed
+          || state->cache.has(page->address())
+          || (state->state_page
+                && state->state_page->address() == page->address())) {
+      delete page;
+      continue;
+    }
+
+    if (IS_SET(state->config.flags, UPS_ENABLE_CRC32)) {
+      try {
+        verify_crc32(page);
+      }
+      catch (Exception &) {
+        delete page;
+        continue;
+      }
+    }
+
+    state->cache.put(page);
+    state->page_count_fetched++;
+  }
+  return proceed;
+}
+
+// Loads the next batch of pages of the warm-up manifest. The addresses
+// of a batch are sorted, and adjacent pages are read with a single I/O
+// operation. The remaining single pages are read as one batch (see
+// Device::read_pages). Then the next batch is scheduled.
+static void
+async_warm_up(AsyncWarmupMessage *message)
+{
+  PageManagerState *state = message->page_manager->state.get();
+  uint32_t page_size = state->config.page_size_bytes;
+
+  if (message->cancelled)
+    return;
+
+  size_t end = std::min(message->next + kWarmupBatchSize,
+                  message->addresses.size());
+  std::vector<uint64_t> batch(message->addresses.begin() + message->next,
+                  message->addresses.begin() + end);
+  message->next = end;
+  std::sort(batch.begin(), batch.end());
+  batch.erase(std::unique(batch.begin(), batch.end()), batch.end());
+
+  uint64_t file_size = state->device->file_size();
+  std::vector<uint64_t> scattered;
+
+  // ask the operating system to read all pages of the batch
+  // asynchronously; then they are fetched
+  for (size_t i = 0; i < batch.size(); i++)
+    if (batch[i] + page_size <= file_size)
+      state->device->advise(batch[i], page_size, Device::kAdviceWillNeed);
+
+  for (size_t i = 0; i < batch.size(); ) {
+    size_t count = 1;
+    while (i + count < batch.size()
+            && count < kWarmupMaxRunPages
+            && batch[i + count] == batch[i] + count * page_size)
+      count++;
+
+    if (batch[i] + count * page_size <= file_size) {
+      if (count == 1)
+        scattered.push_back(batch[i]);
+      else if (!warm_up_pages(state, message,
+                      std::vector<uint64_t>(batch.begin() + i,
+                              batch.begin() + i + count)))
+        return;
+    }
+    i += count;
+  }
+
+  if (!scattered.empty() && !warm_up_pages(state, message, scattered))
+    return;
+
+  if (message->next < message->addresses.size() && !message->cancelled)
+    message->page_manager->run_async(boost::bind(&async_warm_up, message));
+}
+
 static inline Page *
 add_to_changeset(Changeset *changeset, Page *page)
 {
@@ -170,9 +414,7 @@ store_state_impl(PageManagerState *state, Context *context)
     return state->state_page->address();
   }
 
-  std::pair<bool, Freelist::FreeMap::const_iterator> continuation;
-  continuation.first = false;   // initialization
-  continuation.second = state->freelist.free_pages.end();
+  Freelist::EncodeCursor continuation;
   do {
     int offset = page == state->state_page
                       ? sizeof(uint64_t)
@@ -183,7 +425,7 @@ store_state_impl(PageManagerState *state, Context *context)
                                 - Page::kSizeofPersistentHeader
                                 - offset);
 
-    if (continuation.first == false)
+    if (continuation.more == false)
       break;
 
     // load the next page
@@ -216,8 +458,13 @@ maybe_store_state(PageManagerState *state, Context *context, bool force)
 {
   if (force || state->env->journal.get()) {
     uint64_t new_blobid = store_state_impl(state, context);
-    if (new_blobid != state->header->page_manager_blobid()) {
+    // the state is always written in the current format; files of older
+    // versions are upgraded
+    if (new_blobid != state->header->page_manager_blobid()
+          || (new_blobid != 0 && state->header->freelist_format()
+                                      != Freelist::kFormatVarint)) {
       state->header->set_page_manager_blobid(new_blobid);
+      state->header->set_freelist_format(Freelist::kFormatVarint);
       // don't bother to lock the header page
       state->header->header_page->set_dirty(true);
       context->changeset.put(state->header->header_page);
@@ -237,10 +484,14 @@ fetch_unlocked(PageManagerState *state, Context *context, uint64_t address,
   else if (state->state_page && address == state->state_page->address())
     page = state->state_page;
   else
-    page = state->cache.get(address);
+    page = state->cache.get(address, IS_SET(flags, PageManager::kScan));
 
   if (page) {
     page->set_without_header(IS_SET(flags, PageManager::kNoHeader));
+    // pages which were loaded when the cache was warmed up do not yet
+    // know their database
+    if (!page->db() && context->db)
+      page->set_db(context->db);
     return add_to_changeset(&context->changeset, page);
   }
 
@@ -248,9 +499,12 @@ fetch_unlocked(PageManagerState *state, Context *context, uint64_t address,
           || IS_SET(state->config.flags, UPS_IN_MEMORY))
     return 0;
 
+  /* pages which are read from the file (and not mapped) are verified
+   * by the device; only verify crc if the page has a header */
   page = new Page(state->device, context->db);
+  page->set_without_header(IS_SET(flags, PageManager::kNoHeader));
   try {
-    page->fetch(address);
+    page->fetch(address, true);
   }
   catch (Exception &ex) {
     delete page;
@@ -260,16 +514,15 @@ fetch_unlocked(PageManagerState *state, Context *context, uint64_t address,
   assert(page->data());
 
   /* store the page in the list */
-  state->cache.put(page);
+  state->cache.put(page, IS_SET(flags, PageManager::kScan));
 
   /* write state to disk (if necessary) */
   if (NOT_SET(flags, PageManager::kDisableStoreState)
           && NOT_SET(flags, PageManager::kReadOnly))
     maybe_store_state(state, context, false);
 
-  /* only verify crc if the page has a header */
-  page->set_without_header(IS_SET(flags, PageManager::kNoHeader));
   if (!page->is_without_header()
+          && !page->is_allocated()
           && IS_SET(state->config.flags, UPS_ENABLE_CRC32))
     verify_crc32(page);
 
@@ -373,12 +626,20 @@ PageManagerState::PageManagerState(LocalEnv *_env)
     state_page(0), last_blob_page(0), last_blob_page_id(0),
     page_count_fetched(0), page_count_index(0), page_count_blob(0),
     page_count_page_manager(0), cache_hits(0), cache_misses(0), message(0),
-    worker(new WorkerPool(1))
+    warmup(0), worker(new WorkerPool(config.flush_threads))
 {
 }
 
 PageManagerState::~PageManagerState()
 {
+  // stop the cache warm-up before its message is deleted
+  if (warmup) {
+    warmup->cancelled = true;
+    worker.reset(0);
+  }
+  delete warmup;
+  warmup = 0;
+
   delete message;
   message = 0;
 
@@ -397,8 +658,9 @@ PageManager::initialize(uint64_t pageid)
   if (state->state_page)
     delete state->state_page;
   state->state_page = new Page(state->device);
-  state->state_page->fetch(pageid);
-  if (IS_SET(state->config.flags, UPS_ENABLE_CRC32))
+  state->state_page->fetch(pageid, true);
+  if (IS_SET(state->config.flags, UPS_ENABLE_CRC32)
+          && !state->state_page->is_allocated())
     verify_crc32(state->state_page);
 
   Page *page = state->state_page;
@@ -417,7 +679,7 @@ PageManager::initialize(uint64_t pageid)
     uint64_t overflow = *(uint64_t *)p;
     p += 8;
 
-    state->freelist.decode_state(p);
+    state->freelist.decode_state(p, state->header->freelist_format());
 
     // load the overflow page
     if (overflow)
@@ -434,6 +696,22 @@ PageManager::fetch(Context *context, uint64_t address, uint32_t flags)
   return fetch_unlocked(state.get(), context, address, flags);
 }
 
+void
+PageManager::prefetch(uint64_t address)
+{
+  if (IS_SET(state->config.flags, UPS_IN_MEMORY))
+    return;
+
+  {
+    ScopedSpinlock lock(state->mutex);
+    if (state->cache.has(address))
+      return;
+  }
+
+  state->device->advise(address, state->config.page_size_bytes,
+                  Device::kAdviceWillNeed);
+}
+
 Page *
 PageManager::alloc(Context *context, uint32_t page_type, uint32_t flags)
 {
@@ -523,6 +801,10 @@ struct FlushAllPagesVisitor
 void
 PageManager::flush_all_pages()
 {
+  // previously scheduled flushes (i.e. of a Changeset) have to complete;
+  // otherwise their pages are still locked, and would be skipped
+  state->worker->wait_for_pending();
+
   Signal signal;
   AsyncFlushMessage *message = new AsyncFlushMessage(this, state->device,
                                     &signal);
@@ -542,13 +824,131 @@ PageManager::flush_all_pages()
   }
 
   if (message->page_ids.size() > 0) {
-    run_async(boost::bind(&async_flush_pages, message));
+    schedule_flush(this, message);
     signal.wait();
   }
 
   delete message;
 }
 
+void
+PageManager::add_pending_changeset(uint64_t lsn,
+                const std::vector<Page *> &pages)
+{
+  std::vector<uint64_t> addresses;
+  addresses.reserve(pages.size());
+  for (std::vector<Page *>::const_iterator it = pages.begin();
+                  it != pages.end();
+                  ++it)
+    addresses.push_back((*it)->address());
+
+  ScopedSpinlock lock(state->mutex);
+  state->pending_changesets[lsn].swap(addresses);
+}
+
+void
+PageManager::remove_pending_changeset(uint64_t lsn)
+{
+  ScopedSpinlock lock(state->mutex);
+  state->pending_changesets.erase(lsn);
+}
+
+void
+PageManager::fill_dirty_page_table(std::map<uint64_t, uint64_t> &table)
+{
+  ScopedSpinlock lock(state->mutex);
+  for (std::map<uint64_t, std::vector<uint64_t> >::iterator it
+                  = state->pending_changesets.begin();
+                  it != state->pending_changesets.end();
+                  ++it) {
+    for (std::vector<uint64_t>::iterator p = it->second.begin();
+                    p != it->second.end();
+                    ++p)
+      table.insert(std::make_pair(*p, it->first)); // keeps the oldest lsn
+  }
+}
+
+void
+PageManager::store_warmup_manifest()
+{
+  if (state->config.cache_warmup_pages == 0
+        || IS_SET(state->config.flags, UPS_IN_MEMORY)
+        || IS_SET(state->config.flags, UPS_READ_ONLY))
+    return;
+
+  std::vector<uint64_t> addresses;
+  {
+    ScopedSpinlock lock(state->mutex);
+    record_recent_pages(state.get());
+    addresses = state->recent_pages;
+  }
+
+  PWarmupManifest header;
+  header.magic = kWarmupMagic;
+  header.page_size = state->config.page_size_bytes;
+  header.count = addresses.size();
+
+  // the manifest is only a hint; failures are not fatal
+  try {
+    File file;
+    file.create(warmup_manifest_path(state.get()).c_str(),
+                    state->config.file_mode);
+    file.write(&header, sizeof(header));
+    if (!addresses.empty())
+      file.write(addresses.data(), addresses.size() * sizeof(uint64_t));
+    file.close();
+  }
+  catch (Exception &ex) {
+    ups_trace(("failed to write the cache warm-up manifest: %d",
+                    (int)ex.code));
+  }
+}
+
+void
+PageManager::warm_up()
+{
+  if (state->config.cache_warmup_pages == 0
+        || IS_SET(state->config.flags, UPS_IN_MEMORY))
+    return;
+
+  std::unique_ptr<AsyncWarmupMessage> message(new AsyncWarmupMessage(this));
+
+  // a missing or invalid manifest is ignored
+  try {
+    File file;
+    file.open(warmup_manifest_path(state.get()).c_str(), true);
+
+    PWarmupManifest header;
+    uint64_t file_size = file.file_size();
+    if (file_size < sizeof(header))
+      return;
+    file.pread(0, &header, sizeof(header));
+    if (header.magic != kWarmupMagic
+          || header.page_size != state->config.page_size_bytes
+          || header.count != (file_size - sizeof(header)) / sizeof(uint64_t))
+      return;
+
+    message->addresses.resize(std::min(header.count,
+                            (uint64_t)state->config.cache_warmup_pages));
+    if (!message->addresses.empty())
+      file.pread(sizeof(header), message->addresses.data(),
+                      message->addresses.size() * sizeof(uint64_t));
+    file.close();
+  }
+  catch (Exception &) {
+    return;
+  }
+
+  if (message->addresses.empty())
+    return;
+
+  ScopedSpinlock lock(state->mutex);
+  if (state->warmup)
+    return;
+  state->warmup = message.release();
+  run_async(boost::bind(&async_warm_up, state->warmup));
+}
+
 void
 PageManager::purge_cache(Context *)
 {
@@ -575,9 +975,13 @@ PageManager::purge_cache(Context *)
   // don't bother if there are only few pages
   if (state->message->page_ids.size() > 10) {
     state->message->in_progress = true;
-    run_async(boost::bind(&async_flush_pages, state->message));
+    schedule_flush(this, state->message);
   }
 
+  // the memory of evicted mapped pages is released; they are clean and
+  // will be re-read from the file
+  std::vector<uint64_t> unmapped;
+
   for (std::vector<Page *>::iterator it = state->garbage.begin();
                   it != state->garbage.end();
                   it++) {
@@ -586,9 +990,24 @@ PageManager::purge_cache(Context *)
       assert(page->cursor_list.is_empty());
       state->cache.del(page);
       page->mutex().unlock();
+      if (!page->is_allocated() && !page->is_dirty())
+        unmapped.push_back(page->address());
       delete page;
     }
   }
+
+  // adjacent pages are released with a single call
+  uint32_t page_size = state->config.page_size_bytes;
+  std::sort(unmapped.begin(), unmapped.end());
+  for (size_t i = 0; i < unmapped.size(); ) {
+    size_t count = 1;
+    while (i + count < unmapped.size()
+            && unmapped[i + count] == unmapped[i] + count * page_size)
+      count++;
+    state->device->advise(unmapped[i], count * page_size,
+                    Device::kAdviceDontNeed);
+    i += count;
+  }
 }
 
 void
@@ -651,6 +1070,9 @@ struct CloseDatabaseVisitor
 void
 PageManager::close_database(Context *context, LocalDb *db)
 {
+  // wait till all pages of the database are unlocked
+  state->worker->wait_for_pending();
+
   Signal signal;
   AsyncFlushMessage *message = new AsyncFlushMessage(this, state->device,
                                     &signal);
@@ -666,6 +1088,7 @@ PageManager::close_database(Context *context, LocalDb *db)
     }
 
     context->changeset.clear();
+    record_recent_pages(state.get());
     state->cache.purge_if(visitor);
 
     if (state->header->header_page->is_dirty())
@@ -673,7 +1096,7 @@ PageManager::close_database(Context *context, LocalDb *db)
   }
 
   if (message->page_ids.size() > 0) {
-    run_async(boost::bind(&async_flush_pages, message));
+    schedule_flush(this, message);
     signal.wait();
   }
 
@@ -731,6 +1154,10 @@ PageManager::close(Context *context)
 {
   // no need to lock the mutex; this method is called during shutdown
 
+  // stop loading pages into the cache
+  if (state->warmup)
+    state->warmup->cancelled = true;
+
   // cut off unused space at the end of the file; this space is managed
   // by the device
   state->device->reclaim_space();
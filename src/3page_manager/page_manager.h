@@ -67,7 +67,15 @@ struct PageManager
     kReadOnly = 2,
 
     // Flag for fetch(): page is part of a multi-page blob, has no header
-    kNoHeader = 4
+    kNoHeader = 4,
+
+    // Flag for fetch(): page is read by a sequential scan; the cache will
+    // not treat it as a frequently used page
+    kScan = 8,
+
+    // The minimum number of pages which are flushed by one thread; smaller
+    // lists are not split
+    kMinPagesPerPartition = 16
   };
 
   // Constructor
@@ -83,10 +91,14 @@ struct PageManager
   void fill_metrics(ups_env_metrics_t *metrics) const;
 
   // Fetches a page from disk. |flags| are bitwise OR'd: kOnlyFromCache,
-  // kReadOnly, kNoHeader...
+  // kReadOnly, kNoHeader, kScan...
   // The page is locked and stored in |context->changeset|.
   Page *fetch(Context *context, uint64_t address, uint32_t flags = 0);
 
+  // Asks the device to read the page at |address| asynchronously, unless
+  // it is already cached. Used to read ahead the next leaf of a scan.
+  void prefetch(uint64_t address);
+
   // Allocates a new page. |page_type| is one of Page::kType* in page.h.
   // |flags| are either 0 or kClearWithZero
   // The page is locked and stored in |context->changeset|.
@@ -101,6 +113,26 @@ struct PageManager
   // Flushes all pages to disk
   void flush_all_pages();
 
+  // Registers the pages of a Changeset, which are written asynchronously
+  // by the worker threads
+  void add_pending_changeset(uint64_t lsn, const std::vector<Page *> &pages);
+
+  // Called by the worker threads when all pages of a Changeset were
+  // written
+  void remove_pending_changeset(uint64_t lsn);
+
+  // Returns the pages which are not yet written to the file, and the lsn
+  // of their Changeset (the "dirty page table" of a checkpoint)
+  void fill_dirty_page_table(std::map<uint64_t, uint64_t> &table);
+
+  // Stores the addresses of the most recently used pages in the warm-up
+  // manifest (see UPS_PARAM_CACHE_WARMUP)
+  void store_warmup_manifest();
+
+  // Reads the warm-up manifest, then asks the worker thread to load the
+  // recorded pages into the cache
+  void warm_up();
+
   // Asks the worker thread to purge the cache if the cache limits are
   // exceeded
   void purge_cache(Context *context);
@@ -148,6 +180,22 @@ struct PageManager
     return state->worker->enqueue(message);
   }
 
+  // Adds a message to the queue of the worker thread which is responsible
+  // for |partition|
+  template<typename WorkerMessage>
+  void run_async(WorkerMessage message, size_t partition) {
+    return state->worker->enqueue(message, partition);
+  }
+
+  // Returns the number of partitions (and worker threads) which flush
+  // |num_pages| pages
+  size_t flush_partitions(size_t num_pages) const {
+    size_t partitions = num_pages / kMinPagesPerPartition;
+    if (partitions > state->worker->size())
+      partitions = state->worker->size();
+    return partitions > 0 ? partitions : 1;
+  }
+
   // Stores the state to disk. Returns the page-Id with the persisted state.
   // Exposed here because it's required by the unittests.
   uint64_t test_store_state();
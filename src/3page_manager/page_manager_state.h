@@ -30,6 +30,8 @@
 
 #include "0root/root.h"
 
+#include <map>
+#include <vector>
 #include <boost/atomic.hpp>
 
 // Always verify that a file of level N does not include headers > N!
@@ -50,6 +52,7 @@ struct LocalDb;
 struct LocalEnv;
 struct LsnManager;
 struct AsyncFlushMessage;
+struct AsyncWarmupMessage;
 struct WorkerPool;
 
 /*
@@ -121,9 +124,22 @@ struct PageManagerState {
   // allocations
   AsyncFlushMessage *message;
 
+  // The pages which are loaded by the worker thread when the cache is
+  // warmed up; null if there is nothing to load
+  AsyncWarmupMessage *warmup;
+
+  // The recently used pages which are recorded for the next warm-up,
+  // the most recently used pages first
+  std::vector<uint64_t> recent_pages;
+
   // For collecting unused pages; cached to avoid memory allocations
   std::vector<Page *> garbage;
 
+  // The Changesets which are not yet completely written to the file;
+  // maps the lsn of each Changeset to the addresses of its pages. These
+  // pages form the dirty page table of a checkpoint
+  std::map<uint64_t, std::vector<uint64_t> > pending_changesets;
+
   // The worker thread which flushes dirty pages
   std::unique_ptr<WorkerPool> worker;
 };
@@ -20,6 +20,7 @@
 
 // Always verify that a file of level N does not include headers > N!
 #include "1globals/callbacks.h"
+#include "2device/device.h"
 #include "3page_manager/page_manager.h"
 #include "3journal/journal.h"
 #include "3blob_manager/blob_manager.h"
@@ -655,6 +656,7 @@ LocalDb::create(Context *context, PBtreeHeader *btree_header)
   uint32_t persistent_flags = flags();
   persistent_flags &= ~(UPS_CACHE_UNLIMITED
             | UPS_DISABLE_MMAP
+            | UPS_DIRECT_IO
             | UPS_ENABLE_FSYNC
             | UPS_READ_ONLY
             | UPS_AUTO_RECOVERY
@@ -1464,6 +1466,9 @@ LocalDb::select_range(SelectStatement *stmt, LocalCursor *begin,
 
   Context context(lenv(this), 0, this);
 
+  // the leaf nodes are read sequentially
+  ScopedSequentialAdvice advice(lenv(this)->device.get());
+
   Result *result = new Result;
 
   // purge cache if necessary
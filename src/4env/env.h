@@ -91,6 +91,9 @@ struct Env
   // Accepted flags: UPS_FLUSH_BLOCKING
   virtual ups_status_t flush(uint32_t flags) = 0;
 
+  // Writes a checkpoint to the journal (ups_env_checkpoint)
+  virtual ups_status_t checkpoint(uint32_t flags) = 0;
+
   // Creates a new database in the environment (ups_env_create_db)
   Db *create_db(DbConfig &config, const ups_parameter_t *param);
 
@@ -49,8 +49,12 @@ typedef UPS_PACK_0 struct UPS_PACK_1
   // version information - major, minor, rev, file
   uint8_t version[4];
 
+  // the algorithm of the page checksums (UPS_CRC32_*); 0 in files
+  // created by older versions
+  uint8_t crc32_algorithm;
+
   // reserved
-  uint64_t _reserved1;
+  uint8_t _reserved1[7];
 
   // size of the page
   uint32_t page_size;
@@ -61,8 +65,9 @@ typedef UPS_PACK_0 struct UPS_PACK_1
   // for storing journal compression algorithm
   uint8_t journal_compression;
 
-  // reserved
-  uint8_t _reserved2;
+  // format of the persisted freelist (see Freelist::kFormatVarint); 0 in
+  // files created by older versions
+  uint8_t freelist_format;
 
   // blob id of the PageManager's state
   uint64_t page_manager_blobid;
@@ -159,6 +164,26 @@ struct EnvHeader
     header()->journal_compression = algorithm << 4;
   }
 
+  // Returns the format of the persisted freelist
+  int freelist_format() {
+    return header()->freelist_format;
+  }
+
+  // Sets the format of the persisted freelist
+  void set_freelist_format(int format) {
+    header()->freelist_format = (uint8_t)format;
+  }
+
+  // Returns the algorithm of the page checksums
+  int crc32_algorithm() {
+    return header()->crc32_algorithm;
+  }
+
+  // Sets the algorithm of the page checksums
+  void set_crc32_algorithm(int algorithm) {
+    header()->crc32_algorithm = (uint8_t)algorithm;
+  }
+
   // Returns a pointer to the header data
   PEnvironmentHeader *header() {
     return (PEnvironmentHeader *)(header_page->payload());
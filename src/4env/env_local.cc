@@ -144,6 +144,8 @@ LocalEnv::create()
           UPS_FILE_VERSION);
   header->set_page_size(config.page_size_bytes);
   header->set_max_databases(config.max_databases);
+  header->set_freelist_format(Freelist::kFormatVarint);
+  header->set_crc32_algorithm(config.crc32_algorithm);
 
   /* load page manager after setting up the blobmanager and the device! */
   page_manager.reset(new PageManager(this));
@@ -227,6 +229,7 @@ LocalEnv::open()
     header.reset(new EnvHeader(&fakepage));
 
     config.page_size_bytes = header->page_size();
+    config.crc32_algorithm = header->crc32_algorithm();
 
     /** check the file magic */
     if (unlikely(!header->verify_magic('H', 'A', 'M', '\0'))) {
@@ -282,6 +285,10 @@ fail_with_fake_cleansing:
   if (header->page_manager_blobid() != 0)
     page_manager->initialize(header->page_manager_blobid());
 
+  /* load the recently used pages of the previous session in the
+   * background */
+  page_manager->warm_up();
+
   return 0;
 }
 
@@ -347,6 +354,66 @@ LocalEnv::get_parameters(ups_parameter_t *param)
       case UPS_PARAM_POSIX_FADVISE:
         p->value = config.posix_advice;
         break;
+      case UPS_PARAM_CACHE_SHARDS:
+        p->value = config.cache_shards;
+        break;
+      case UPS_PARAM_CACHE_POLICY:
+        p->value = config.cache_policy;
+        break;
+      case UPS_PARAM_CACHE_INTERNAL_NODES:
+        p->value = config.cache_internal_nodes;
+        break;
+      case UPS_PARAM_CACHE_WARMUP:
+        p->value = config.cache_warmup_pages;
+        break;
+      case UPS_PARAM_PAGE_ARENA:
+        p->value = config.page_arena;
+        break;
+      case UPS_PARAM_CACHE_SAMPLING:
+        p->value = config.cache_sampling;
+        break;
+      case UPS_PARAM_FLUSH_THREADS:
+        p->value = config.flush_threads;
+        break;
+      case UPS_PARAM_IO_BACKEND:
+        p->value = config.io_backend;
+        break;
+      case UPS_PARAM_FILE_EXTENT_SIZE:
+        p->value = config.file_extent_size;
+        break;
+      case UPS_PARAM_STRIPE_PATHS:
+        if (config.stripe_paths.size())
+          p->value = (uint64_t)(config.stripe_paths.c_str());
+        else
+          p->value = 0;
+        break;
+      case UPS_PARAM_STRIPE_SIZE:
+        p->value = config.stripe_size;
+        break;
+      case UPS_PARAM_CRC32_ALGORITHM:
+        p->value = config.crc32_algorithm;
+        break;
+      case UPS_PARAM_PAGE_COMPRESSION:
+        p->value = config.page_compressor;
+        break;
+      case UPS_PARAM_JOURNAL_GROUP_COMMIT_DELAY:
+        p->value = config.group_commit_delay_usec;
+        break;
+      case UPS_PARAM_JOURNAL_GROUP_COMMIT_SIZE:
+        p->value = config.group_commit_size;
+        break;
+      case UPS_PARAM_JOURNAL_WRITER_THREAD:
+        p->value = config.journal_writer_thread ? 1 : 0;
+        break;
+      case UPS_PARAM_RECOVERY_THREADS:
+        p->value = config.recovery_threads;
+        break;
+      case UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL:
+        p->value = config.checkpoint_interval_sec;
+        break;
+      case UPS_PARAM_JOURNAL_CHECKPOINT_SIZE:
+        p->value = config.checkpoint_size;
+        break;
       default:
         ups_trace(("unknown parameter %d", (int)p->name));
         return (UPS_INV_PARAMETER);
@@ -373,12 +440,38 @@ LocalEnv::flush(uint32_t flags)
   /* Flush all open pages to disk. This operation is blocking. */
   page_manager->flush_all_pages();
 
+  /* Record the pages for warming up the cache after a restart */
+  page_manager->store_warmup_manifest();
+
   /* Flush the device - this can trigger a fsync() if enabled */
   device->flush();
 
   return 0;
 }
 
+ups_status_t
+LocalEnv::checkpoint(uint32_t)
+{
+  if (!journal)
+    return 0;
+
+  Context context(this, 0, 0);
+
+  // flush the committed transactions; their pages are written by the
+  // worker threads and become part of the dirty page table
+  txn_manager->flush_committed_txns(&context);
+
+  uint64_t lsn = lsn_manager.next();
+  LocalTxn *oldest = (LocalTxn *)txn_manager->oldest_txn();
+  uint64_t oldest_lsn = oldest ? oldest->lsn : lsn;
+
+  std::map<uint64_t, uint64_t> dirty_pages;
+  page_manager->fill_dirty_page_table(dirty_pages);
+
+  journal->append_checkpoint(oldest_lsn, dirty_pages, lsn);
+  return 0;
+}
+
 ups_status_t
 LocalEnv::select_range(const char *query, Cursor *begin,
                             const Cursor *end, Result **result)
@@ -768,7 +861,30 @@ LocalEnv::txn_begin(const char *name, uint32_t flags)
 ups_status_t
 LocalEnv::txn_commit(Txn *txn, uint32_t)
 {
-  return txn_manager->commit(txn);
+  ups_status_t st = txn_manager->commit(txn);
+  if (st != 0 || !journal)
+    return st;
+
+  if (unlikely(journal->is_checkpoint_due()))
+    checkpoint(0);
+
+  if (NOT_SET(flags(), UPS_ENABLE_FSYNC))
+    return 0;
+
+  // the commit is durable after the journal was synced. Release the lock
+  // (it was acquired by ups_txn_commit) while waiting, so that concurrent
+  // commits can share the same sync
+  uint64_t position = journal->appended_position();
+  mutex.unlock();
+  try {
+    journal->sync(position);
+  }
+  catch (Exception &ex) {
+    mutex.lock();
+    return ex.code;
+  }
+  mutex.lock();
+  return 0;
 }
 
 ups_status_t
@@ -786,9 +902,12 @@ LocalEnv::do_close(uint32_t flags)
   if (likely(txn_manager.get() != 0))
     txn_manager->flush_committed_txns(&context);
 
-  /* flush all pages and the freelist, reduce the file size */
-  if (likely(page_manager.get() != 0))
+  /* flush all pages and the freelist, reduce the file size; record the
+   * recently used pages for warming up the cache */
+  if (likely(page_manager.get() != 0)) {
+    page_manager->store_warmup_manifest();
     page_manager->close(&context);
+  }
 
   /* close the header page */
   if (likely(header && header->header_page)) {
@@ -818,6 +937,8 @@ LocalEnv::fill_metrics(ups_env_metrics_t *metrics)
 {
   // PageManager metrics (incl. cache and freelist)
   page_manager->fill_metrics(metrics);
+  // the page arena of the Device
+  device->fill_metrics(metrics);
   // the BlobManagers
   blob_manager->fill_metrics(metrics);
   // the Journal (if available)
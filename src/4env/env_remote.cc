@@ -331,6 +331,12 @@ RemoteEnv::flush(uint32_t flags)
   return reply->env_flush_reply().status();
 }
 
+ups_status_t
+RemoteEnv::checkpoint(uint32_t)
+{
+  return UPS_NOT_IMPLEMENTED;
+}
+
 Db *
 RemoteEnv::do_create_db(DbConfig &config, const ups_parameter_t *param)
 {
@@ -69,6 +69,9 @@ struct RemoteEnv : public Env
   // Flushes the environment and its databases to disk (ups_env_flush)
   virtual ups_status_t flush(uint32_t flags);
 
+  // Writes a checkpoint to the journal (ups_env_checkpoint)
+  virtual ups_status_t checkpoint(uint32_t flags);
+
   // Begins a new transaction (ups_txn_begin)
   virtual Txn *txn_begin(const char *name, uint32_t flags);
 
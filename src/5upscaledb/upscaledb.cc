@@ -319,6 +319,17 @@ ups_env_create(ups_env_t **henv, const char *filename,
     return UPS_INV_PARAMETER;
   }
 
+  /* in-memory? direct I/O is not possible */
+  if (unlikely(IS_SET(flags, UPS_IN_MEMORY) && IS_SET(flags, UPS_DIRECT_IO))) {
+    ups_trace(("combination of UPS_IN_MEMORY and UPS_DIRECT_IO "
+            "not allowed"));
+    return UPS_INV_PARAMETER;
+  }
+
+  /* direct I/O bypasses the page cache; mmap would use it */
+  if (IS_SET(flags, UPS_DIRECT_IO))
+    flags |= UPS_DISABLE_MMAP;
+
   /* flag UPS_AUTO_RECOVERY implies UPS_ENABLE_TRANSACTIONS */
   if (IS_SET(flags, UPS_AUTO_RECOVERY))
     flags |= UPS_ENABLE_TRANSACTIONS;
@@ -388,6 +399,124 @@ ups_env_create(ups_env_t **henv, const char *filename,
       case UPS_PARAM_POSIX_FADVISE:
         config.posix_advice = (uint32_t)param->value;
         break;
+      case UPS_PARAM_CACHE_SHARDS:
+        if (param->value == 0 || param->value > 1024) {
+          ups_trace(("invalid number of cache shards - must be 1..1024"));
+          return UPS_INV_PARAMETER;
+        }
+        config.cache_shards = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_CACHE_POLICY:
+        if (param->value != UPS_CACHE_POLICY_LRU
+              && param->value != UPS_CACHE_POLICY_CLOCK
+              && param->value != UPS_CACHE_POLICY_SLRU) {
+          ups_trace(("invalid cache policy"));
+          return UPS_INV_PARAMETER;
+        }
+        config.cache_policy = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_CACHE_INTERNAL_NODES:
+        if (param->value > 100) {
+          ups_trace(("invalid value for UPS_PARAM_CACHE_INTERNAL_NODES - "
+                  "must be 0..100"));
+          return UPS_INV_PARAMETER;
+        }
+        config.cache_internal_nodes = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_CACHE_WARMUP:
+        config.cache_warmup_pages = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_PAGE_ARENA:
+        if (param->value != UPS_PAGE_ARENA_DISABLED
+              && param->value != UPS_PAGE_ARENA_ENABLED
+              && param->value != UPS_PAGE_ARENA_HUGE_PAGES) {
+          ups_trace(("invalid value for UPS_PARAM_PAGE_ARENA"));
+          return UPS_INV_PARAMETER;
+        }
+        config.page_arena = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_CACHE_SAMPLING:
+        if (param->value > 1000) {
+          ups_trace(("invalid value for UPS_PARAM_CACHE_SAMPLING - "
+                  "must be 0..1000"));
+          return UPS_INV_PARAMETER;
+        }
+        config.cache_sampling = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_FLUSH_THREADS:
+        if (param->value < 1 || param->value > 64) {
+          ups_trace(("invalid value for UPS_PARAM_FLUSH_THREADS - "
+                  "must be 1..64"));
+          return UPS_INV_PARAMETER;
+        }
+        config.flush_threads = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_IO_BACKEND:
+        if (param->value != UPS_IO_BACKEND_PREAD
+              && param->value != UPS_IO_BACKEND_IO_URING) {
+          ups_trace(("invalid value for UPS_PARAM_IO_BACKEND"));
+          return UPS_INV_PARAMETER;
+        }
+        config.io_backend = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_FILE_EXTENT_SIZE:
+        config.file_extent_size = param->value;
+        break;
+      case UPS_PARAM_STRIPE_PATHS:
+        if (param->value)
+          config.stripe_paths = (const char *)param->value;
+        break;
+      case UPS_PARAM_STRIPE_SIZE:
+        config.stripe_size = param->value;
+        break;
+      case UPS_PARAM_PAGE_COMPRESSION:
+        if (param->value != UPS_COMPRESSOR_NONE
+              && ((param->value != UPS_COMPRESSOR_ZLIB
+                    && param->value != UPS_COMPRESSOR_SNAPPY
+                    && param->value != UPS_COMPRESSOR_LZF)
+                || !CompressorFactory::is_available((int)param->value))) {
+          ups_trace(("unknown algorithm for page compression"));
+          return UPS_INV_PARAMETER;
+        }
+        config.page_compressor = (int)param->value;
+        break;
+      case UPS_PARAM_JOURNAL_GROUP_COMMIT_DELAY:
+        config.group_commit_delay_usec = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_JOURNAL_GROUP_COMMIT_SIZE:
+        if (param->value == 0 || param->value > 0xffffffffu) {
+          ups_trace(("invalid value for "
+                  "UPS_PARAM_JOURNAL_GROUP_COMMIT_SIZE"));
+          return UPS_INV_PARAMETER;
+        }
+        config.group_commit_size = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_JOURNAL_WRITER_THREAD:
+        if (param->value > 1) {
+          ups_trace(("invalid value for UPS_PARAM_JOURNAL_WRITER_THREAD"));
+          return UPS_INV_PARAMETER;
+        }
+        config.journal_writer_thread = param->value != 0;
+        break;
+      case UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL:
+        if (param->value > 0xffffffffu) {
+          ups_trace(("invalid value for "
+                  "UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL"));
+          return UPS_INV_PARAMETER;
+        }
+        config.checkpoint_interval_sec = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_JOURNAL_CHECKPOINT_SIZE:
+        config.checkpoint_size = param->value;
+        break;
+      case UPS_PARAM_CRC32_ALGORITHM:
+        if (param->value != UPS_CRC32_MURMUR3
+              && param->value != UPS_CRC32_CRC32C) {
+          ups_trace(("invalid value for UPS_PARAM_CRC32_ALGORITHM"));
+          return UPS_INV_PARAMETER;
+        }
+        config.crc32_algorithm = (uint32_t)param->value;
+        break;
       default:
         ups_trace(("unknown parameter %d", (int)param->name));
         return UPS_INV_PARAMETER;
@@ -400,6 +529,31 @@ ups_env_create(ups_env_t **henv, const char *filename,
     return UPS_INV_PARAMETER;
   }
 
+  /* the pages must not span several stripes; encryption is not supported */
+  if (!config.stripe_paths.empty() && NOT_SET(flags, UPS_IN_MEMORY)) {
+    if (config.stripe_size == 0
+          || config.stripe_size % config.page_size_bytes != 0) {
+      ups_trace(("invalid value for UPS_PARAM_STRIPE_SIZE - must be a "
+              "multiple of the page size"));
+      return UPS_INV_PARAMETER;
+    }
+    if (config.is_encryption_enabled) {
+      ups_trace(("striping not allowed in combination with encryption"));
+      return UPS_INV_PARAMETER;
+    }
+  }
+
+  /* compressed pages are neither aligned nor mapped */
+  if (config.page_compressor != 0 && NOT_SET(flags, UPS_IN_MEMORY)) {
+    if (config.is_encryption_enabled
+          || !config.stripe_paths.empty()
+          || IS_SET(flags, UPS_DIRECT_IO)) {
+      ups_trace(("page compression not allowed in combination with "
+              "encryption, striping or UPS_DIRECT_IO"));
+      return UPS_INV_PARAMETER;
+    }
+  }
+
   config.flags = flags;
 
   /*
@@ -486,6 +640,10 @@ ups_env_open(ups_env_t **henv, const char *filename, uint32_t flags,
   if (IS_SET(flags, UPS_AUTO_RECOVERY))
     flags |= UPS_ENABLE_TRANSACTIONS;
 
+  /* direct I/O bypasses the page cache; mmap would use it */
+  if (IS_SET(flags, UPS_DIRECT_IO))
+    flags |= UPS_DISABLE_MMAP;
+
   if (unlikely(config.filename.empty() && NOT_SET(flags, UPS_IN_MEMORY))) {
     ups_trace(("filename is missing"));
     return UPS_INV_PARAMETER;
@@ -534,6 +692,123 @@ ups_env_open(ups_env_t **henv, const char *filename, uint32_t flags,
       case UPS_PARAM_POSIX_FADVISE:
         config.posix_advice = (uint32_t)param->value;
         break;
+      case UPS_PARAM_CACHE_SHARDS:
+        if (param->value == 0 || param->value > 1024) {
+          ups_trace(("invalid number of cache shards - must be 1..1024"));
+          return UPS_INV_PARAMETER;
+        }
+        config.cache_shards = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_CACHE_POLICY:
+        if (param->value != UPS_CACHE_POLICY_LRU
+              && param->value != UPS_CACHE_POLICY_CLOCK
+              && param->value != UPS_CACHE_POLICY_SLRU) {
+          ups_trace(("invalid cache policy"));
+          return UPS_INV_PARAMETER;
+        }
+        config.cache_policy = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_CACHE_INTERNAL_NODES:
+        if (param->value > 100) {
+          ups_trace(("invalid value for UPS_PARAM_CACHE_INTERNAL_NODES - "
+                  "must be 0..100"));
+          return UPS_INV_PARAMETER;
+        }
+        config.cache_internal_nodes = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_CACHE_WARMUP:
+        config.cache_warmup_pages = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_PAGE_ARENA:
+        if (param->value != UPS_PAGE_ARENA_DISABLED
+              && param->value != UPS_PAGE_ARENA_ENABLED
+              && param->value != UPS_PAGE_ARENA_HUGE_PAGES) {
+          ups_trace(("invalid value for UPS_PARAM_PAGE_ARENA"));
+          return UPS_INV_PARAMETER;
+        }
+        config.page_arena = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_CACHE_SAMPLING:
+        if (param->value > 1000) {
+          ups_trace(("invalid value for UPS_PARAM_CACHE_SAMPLING - "
+                  "must be 0..1000"));
+          return UPS_INV_PARAMETER;
+        }
+        config.cache_sampling = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_FLUSH_THREADS:
+        if (param->value < 1 || param->value > 64) {
+          ups_trace(("invalid value for UPS_PARAM_FLUSH_THREADS - "
+                  "must be 1..64"));
+          return UPS_INV_PARAMETER;
+        }
+        config.flush_threads = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_IO_BACKEND:
+        if (param->value != UPS_IO_BACKEND_PREAD
+              && param->value != UPS_IO_BACKEND_IO_URING) {
+          ups_trace(("invalid value for UPS_PARAM_IO_BACKEND"));
+          return UPS_INV_PARAMETER;
+        }
+        config.io_backend = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_FILE_EXTENT_SIZE:
+        config.file_extent_size = param->value;
+        break;
+      case UPS_PARAM_STRIPE_PATHS:
+        if (param->value)
+          config.stripe_paths = (const char *)param->value;
+        break;
+      case UPS_PARAM_STRIPE_SIZE:
+        config.stripe_size = param->value;
+        break;
+      case UPS_PARAM_PAGE_COMPRESSION:
+        if (param->value != UPS_COMPRESSOR_NONE
+              && ((param->value != UPS_COMPRESSOR_ZLIB
+                    && param->value != UPS_COMPRESSOR_SNAPPY
+                    && param->value != UPS_COMPRESSOR_LZF)
+                || !CompressorFactory::is_available((int)param->value))) {
+          ups_trace(("unknown algorithm for page compression"));
+          return UPS_INV_PARAMETER;
+        }
+        config.page_compressor = (int)param->value;
+        break;
+      case UPS_PARAM_JOURNAL_GROUP_COMMIT_DELAY:
+        config.group_commit_delay_usec = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_JOURNAL_GROUP_COMMIT_SIZE:
+        if (param->value == 0 || param->value > 0xffffffffu) {
+          ups_trace(("invalid value for "
+                  "UPS_PARAM_JOURNAL_GROUP_COMMIT_SIZE"));
+          return UPS_INV_PARAMETER;
+        }
+        config.group_commit_size = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_JOURNAL_WRITER_THREAD:
+        if (param->value > 1) {
+          ups_trace(("invalid value for UPS_PARAM_JOURNAL_WRITER_THREAD"));
+          return UPS_INV_PARAMETER;
+        }
+        config.journal_writer_thread = param->value != 0;
+        break;
+      case UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL:
+        if (param->value > 0xffffffffu) {
+          ups_trace(("invalid value for "
+                  "UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL"));
+          return UPS_INV_PARAMETER;
+        }
+        config.checkpoint_interval_sec = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_JOURNAL_CHECKPOINT_SIZE:
+        config.checkpoint_size = param->value;
+        break;
+      case UPS_PARAM_RECOVERY_THREADS:
+        if (param->value == 0 || param->value > 256) {
+          ups_trace(("invalid value for UPS_PARAM_RECOVERY_THREADS"));
+          return UPS_INV_PARAMETER;
+        }
+        config.recovery_threads = (uint32_t)param->value;
+        break;
       default:
         ups_trace(("unknown parameter %d", (int)param->name));
         return UPS_INV_PARAMETER;
@@ -541,6 +816,30 @@ ups_env_open(ups_env_t **henv, const char *filename, uint32_t flags,
     }
   }
 
+  /* the page size is not yet known; it was verified when the Environment
+   * was created */
+  if (!config.stripe_paths.empty()) {
+    if (config.stripe_size == 0) {
+      ups_trace(("invalid value for UPS_PARAM_STRIPE_SIZE"));
+      return UPS_INV_PARAMETER;
+    }
+    if (config.is_encryption_enabled) {
+      ups_trace(("striping not allowed in combination with encryption"));
+      return UPS_INV_PARAMETER;
+    }
+  }
+
+  /* compressed pages are neither aligned nor mapped */
+  if (config.page_compressor != 0 && NOT_SET(flags, UPS_IN_MEMORY)) {
+    if (config.is_encryption_enabled
+          || !config.stripe_paths.empty()
+          || IS_SET(flags, UPS_DIRECT_IO)) {
+      ups_trace(("page compression not allowed in combination with "
+              "encryption, striping or UPS_DIRECT_IO"));
+      return UPS_INV_PARAMETER;
+    }
+  }
+
   config.flags = flags;
 
   Env *env = 0;
@@ -809,6 +1108,28 @@ ups_env_flush(ups_env_t *henv, uint32_t flags)
   }
 }
 
+ups_status_t 
+ups_env_checkpoint(ups_env_t *henv, uint32_t flags)
+{
+  Env *env = (Env *)henv;
+  if (unlikely(!env)) {
+    ups_trace(("parameter 'env' must not be NULL"));
+    return UPS_INV_PARAMETER;
+  }
+  if (unlikely(flags)) {
+    ups_trace(("parameter 'flags' is unused, set to 0"));
+    return UPS_INV_PARAMETER;
+  }
+
+  try {
+    ScopedLock lock(env->mutex);
+    return env->checkpoint(flags);
+  }
+  catch (Exception &ex) {
+    return ex.code;
+  }
+}
+
 ups_status_t 
 ups_env_close(ups_env_t *henv, uint32_t flags)
 {
@@ -23,6 +23,7 @@
 
 #include "fixture.hpp"
 
+#include "1base/crc32c.h"
 #include "1os/file.h"
 
 using namespace upscaledb;
@@ -133,3 +134,71 @@ TEST_CASE("Crc32/corruptMultipageBlobTest", "")
   db.require_find("1", v1, UPS_INTEGRITY_VIOLATED);
 }
 
+
+TEST_CASE("Crc32/crc32c", "")
+{
+  // the check value of the CRC32C
+  REQUIRE(0xe3069283u == crc32c("123456789", 9));
+  REQUIRE(0xe3069283u == crc32c_software("123456789", 9));
+
+  // all lengths and alignments, including the interleaved blocks
+  std::vector<uint8_t> buffer(3 * 8192 + 100);
+  for (size_t i = 0; i < buffer.size(); i++)
+    buffer[i] = (uint8_t)(i * 7 + (i >> 8));
+
+  size_t sizes[] = { 0, 1, 7, 8, 9, 255, 767, 768, 769, 6143, 6144, 6145,
+                     16 * 1024 - 15, 3 * 8192 };
+  for (size_t size : sizes) {
+    for (size_t offset = 0; offset < 9; offset++) {
+      uint32_t seed = (uint32_t)(size * 16 + offset);
+      REQUIRE(crc32c_software(&buffer[offset], size, seed)
+                      == crc32c(&buffer[offset], size, seed));
+    }
+  }
+
+  // the checksum can be continued
+  REQUIRE(crc32c(&buffer[0], 5000)
+                  == crc32c(&buffer[1000], 4000, crc32c(&buffer[0], 1000)));
+}
+
+TEST_CASE("Crc32/crc32cEnv", "")
+{
+  ups_parameter_t invalid[] = {
+      { UPS_PARAM_CRC32_ALGORITHM, 2 },
+      { 0, 0 }
+  };
+  BaseFixture f;
+  f.require_create(UPS_ENABLE_CRC32, invalid, UPS_INV_PARAMETER);
+
+  ups_parameter_t params[] = {
+      { UPS_PARAM_CRC32_ALGORITHM, UPS_CRC32_CRC32C },
+      { 0, 0 }
+  };
+  f.require_create(UPS_ENABLE_CRC32, params)
+   .require_parameter(UPS_PARAM_CRC32_ALGORITHM, UPS_CRC32_CRC32C);
+
+  DbProxy db(f.db);
+  db.require_insert("1", nullptr);
+  f.close();
+
+  // the algorithm is stored in the header; the pages are read from the
+  // file and verified by the device
+  f.require_open(UPS_ENABLE_CRC32 | UPS_DISABLE_MMAP)
+   .require_parameter(UPS_PARAM_CRC32_ALGORITHM, UPS_CRC32_CRC32C);
+  db = DbProxy(f.db);
+  db.require_find("1", nullptr);
+  f.close();
+
+  // flip a few bytes in page 16 * 1024
+  garbagify_file("test.db", 1024 * 16 + 200);
+
+  f.require_open(UPS_ENABLE_CRC32 | UPS_DISABLE_MMAP);
+  db = DbProxy(f.db);
+  db.require_find("1", nullptr, UPS_INTEGRITY_VIOLATED);
+  f.close();
+
+  // mapped pages are verified as well
+  f.require_open(UPS_ENABLE_CRC32);
+  db = DbProxy(f.db);
+  db.require_find("1", nullptr, UPS_INTEGRITY_VIOLATED);
+}
@@ -18,7 +18,15 @@
 
 #include "3rdparty/catch/catch.hpp"
 
+#include <set>
+
+#include "1mem/page_arena.h"
 #include "2device/device.h"
+#include "2device/device_disk.h"
+#include "2device/device_compressed.h"
+#include "2device/device_striped.h"
+#include "2device/device_uring.h"
+#include "2page/page.h"
 
 #include "os.hpp"
 #include "fixture.hpp"
@@ -26,8 +34,16 @@
 using namespace upscaledb;
 
 struct DeviceFixture : BaseFixture {
-  DeviceFixture(bool inmemory) {
-    require_create(inmemory ? UPS_IN_MEMORY : 0);
+  DeviceFixture(bool inmemory, uint32_t page_arena = 0,
+                  uint32_t io_backend = UPS_IO_BACKEND_PREAD,
+                  uint64_t extent_size = 0) {
+    ups_parameter_t params[] = {
+        { UPS_PARAM_PAGE_ARENA, page_arena },
+        { UPS_PARAM_IO_BACKEND, io_backend },
+        { UPS_PARAM_FILE_EXTENT_SIZE, extent_size },
+        { 0, 0 }
+    };
+    require_create(inmemory ? UPS_IN_MEMORY : 0, params);
   }
 
   void createCloseTest() {
@@ -116,6 +132,129 @@ struct DeviceFixture : BaseFixture {
     }
   }
 
+  void growMappingTest() {
+    uint32_t page_size = EnvConfig::UPS_DEFAULT_PAGE_SIZE;
+    std::vector<uint8_t> buffer(page_size);
+
+    DeviceProxy dp(lenv());
+    dp.close()
+      .open();
+
+    // the file grows; the new pages are mapped when they are read
+    for (uint8_t step = 1; step <= 3; step++) {
+      dp.require_truncate(page_size * 10 * step);
+      for (uint32_t i = 10 * (step - 1); i < 10u * step; i++) {
+        std::fill(buffer.begin(), buffer.end(), (uint8_t)i);
+        dp.require_write(i * page_size, buffer.data(), page_size);
+      }
+
+      PageProxy pp(lenv());
+      dp.require_read_page(pp, page_size * (10 * step - 1));
+      pp.require_allocated(false);
+      REQUIRE(device()->is_mapped(0, page_size * 10 * step));
+
+      std::fill(buffer.begin(), buffer.end(), (uint8_t)(10 * step - 1));
+      REQUIRE(0 == ::memcmp(pp.page->data(), buffer.data(), page_size));
+    }
+
+    // the pointers to the pages which were mapped first are still valid
+    uint8_t *first = ((DiskDevice *)device())->mapped_pointer(0);
+    std::fill(buffer.begin(), buffer.end(), 0);
+    REQUIRE(0 == ::memcmp(first, buffer.data(), page_size));
+
+    // pages beyond the end of the file are no longer mapped
+    dp.require_truncate(page_size * 5);
+    REQUIRE(device()->is_mapped(0, page_size * 5));
+    REQUIRE(!device()->is_mapped(0, page_size * 6));
+  }
+
+  uint64_t allocated_bytes() {
+    struct stat st;
+    REQUIRE(0 == ::stat("test.db", &st));
+    return (uint64_t)st.st_blocks * 512;
+  }
+
+  void fileExtentsTest(uint64_t extent_size) {
+    // is fallocate supported by the file system?
+    {
+      File probe;
+      probe.create("test.probe", 0644);
+      bool supported = probe.allocate(0, extent_size);
+      probe.close();
+      ::unlink("test.probe");
+      if (!supported)
+        return;
+    }
+
+    uint32_t page_size = EnvConfig::UPS_DEFAULT_PAGE_SIZE;
+    DeviceProxy dp(lenv());
+
+    // the first extent was reserved when the header page was allocated
+    uint64_t file_size = device()->file_size();
+    REQUIRE(file_size < extent_size);
+    REQUIRE(allocated_bytes() >= extent_size);
+
+    // pages are allocated from the reserved extent
+    for (int i = 0; i < 4; i++) {
+      PageProxy pp(lenv());
+      dp.alloc_page(pp);
+    }
+    REQUIRE(device()->file_size() == file_size + 4 * page_size);
+    REQUIRE(allocated_bytes() >= extent_size);
+    REQUIRE(allocated_bytes() < 2 * extent_size);
+
+    // the unused reserve is released
+    device()->reclaim_space();
+    REQUIRE(allocated_bytes() < extent_size);
+  }
+
+  void adviseTest() {
+    uint32_t page_size = EnvConfig::UPS_DEFAULT_PAGE_SIZE;
+    std::vector<uint8_t> buffer(page_size);
+
+    DeviceProxy dp(lenv());
+    dp.require_truncate(page_size * 10);
+    for (uint32_t i = 0; i < 10; i++) {
+      std::fill(buffer.begin(), buffer.end(), (uint8_t)i);
+      dp.require_write(i * page_size, buffer.data(), page_size);
+    }
+
+    // map the first 5 pages; the others are not mapped
+    dp.close()
+      .open()
+      .require_truncate(page_size * 5)
+      .require_truncate(page_size * 10);
+    for (uint32_t i = 5; i < 10; i++) {
+      std::fill(buffer.begin(), buffer.end(), (uint8_t)i);
+      dp.require_write(i * page_size, buffer.data(), page_size);
+    }
+    REQUIRE(device()->is_mapped(0, page_size * 5));
+    REQUIRE(!device()->is_mapped(0, page_size * 6));
+
+    // the hints do not modify the data
+    device()->advise(0, page_size * 10, Device::kAdviceSequential);
+    device()->advise(0, page_size * 10, Device::kAdviceWillNeed);
+    device()->advise(0, page_size * 10, Device::kAdviceNormal);
+
+    PageProxy pp(lenv());
+    dp.require_read_page(pp, page_size * 2);
+    pp.require_allocated(false);
+    std::fill(buffer.begin(), buffer.end(), 2);
+    REQUIRE(0 == ::memcmp(pp.page->data(), buffer.data(), page_size));
+
+    // a modified copy of a mapped page is dropped; the page is re-read
+    // from the file
+    ::memset(pp.page->data(), 0xff, page_size);
+    device()->advise(page_size * 2, page_size, Device::kAdviceDontNeed);
+    REQUIRE(0 == ::memcmp(pp.page->data(), buffer.data(), page_size));
+
+    // pages which are not mapped are not affected
+    device()->advise(page_size * 5, page_size * 5, Device::kAdviceDontNeed);
+    std::fill(buffer.begin(), buffer.end(), 7);
+    dp.require_read(page_size * 7, buffer.data(), page_size);
+    REQUIRE(buffer[0] == 7);
+  }
+
   void readWriteTest() {
     int i;
     uint32_t page_size = EnvConfig::UPS_DEFAULT_PAGE_SIZE;
@@ -151,8 +290,11 @@ struct DeviceFixture : BaseFixture {
     EnvConfig &cfg = const_cast<EnvConfig &>(lenv()->config);
     cfg.flags |= UPS_DISABLE_MMAP;
 
+    // re-open the device; a newly created file is mapped, too
     DeviceProxy dp(lenv());
-    dp.require_open()
+    dp.close()
+      .open()
+      .require_open()
       .require_truncate(page_size * 2);
 
     for (uint8_t i = 0; i < 2; i++) {
@@ -178,6 +320,108 @@ struct DeviceFixture : BaseFixture {
       pp.require_payload(temp, page_size - Page::kSizeofPersistentHeader);
     }
   }
+
+  void arenaTest() {
+    size_t slot_size = EnvConfig::UPS_DEFAULT_PAGE_SIZE;
+    PageArena arena(slot_size, 2 * PageArena::kChunkSize, false);
+    size_t slots = 2 * PageArena::kChunkSize / slot_size;
+
+    std::vector<void *> v;
+    std::set<void *> unique;
+    for (size_t i = 0; i < slots; i++) {
+      void *p = arena.allocate();
+      REQUIRE(p != 0);
+      REQUIRE(arena.owns(p));
+      ::memset(p, 0xff, slot_size);
+      v.push_back(p);
+      unique.insert(p);
+    }
+    REQUIRE(unique.size() == slots);
+
+    // the arena is exhausted
+    REQUIRE((void *)0 == arena.allocate());
+
+    ups_env_metrics_t metrics = {0};
+    arena.fill_metrics(&metrics);
+    REQUIRE(metrics.page_arena_committed_bytes == 2 * PageArena::kChunkSize);
+    REQUIRE(metrics.page_arena_used_bytes == slots * slot_size);
+
+    // released slots are re-used
+    for (size_t i = 0; i < slots; i += 2)
+      arena.release(v[i]);
+    arena.fill_metrics(&metrics);
+    REQUIRE(metrics.page_arena_used_bytes == slots / 2 * slot_size);
+    for (size_t i = 0; i < slots; i += 2) {
+      void *p = arena.allocate();
+      REQUIRE(unique.find(p) != unique.end());
+    }
+    REQUIRE((void *)0 == arena.allocate());
+  }
+
+  void pageArenaTest() {
+    require_parameter(UPS_PARAM_PAGE_ARENA, UPS_PAGE_ARENA_ENABLED);
+
+    char buffer[512] = {0};
+    for (uint32_t i = 0; i < 500; i++) {
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t rec = ups_make_record(buffer, sizeof(buffer));
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &rec, 0));
+    }
+
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.page_arena_committed_bytes > 0);
+    REQUIRE(metrics.page_arena_used_bytes > 0);
+    REQUIRE(metrics.page_arena_used_bytes
+                    <= metrics.page_arena_committed_bytes);
+
+    for (uint32_t i = 0; i < 500; i++) {
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t rec = ups_make_record(0, 0);
+      REQUIRE(0 == ups_db_find(db, 0, &key, &rec, 0));
+      REQUIRE(sizeof(buffer) == rec.size);
+    }
+  }
+
+  void readPagesTest(bool disable_mmap) {
+    require_parameter(UPS_PARAM_IO_BACKEND, UPS_IO_BACKEND_IO_URING);
+    REQUIRE(dynamic_cast<UringDevice *>(device()) != 0);
+
+    const size_t kPages = 200;
+    uint32_t page_size = EnvConfig::UPS_DEFAULT_PAGE_SIZE;
+    std::vector<uint8_t> buffer(page_size);
+
+    EnvConfig &cfg = const_cast<EnvConfig &>(lenv()->config);
+    if (disable_mmap)
+      cfg.flags |= UPS_DISABLE_MMAP;
+
+    DeviceProxy dp(lenv());
+    dp.require_truncate(page_size * kPages);
+    for (size_t i = 0; i < kPages; i++) {
+      std::fill(buffer.begin(), buffer.end(), (uint8_t)i);
+      dp.require_write(i * page_size, buffer.data(), page_size);
+    }
+
+    // re-open the device; the file is mapped (unless mmap is disabled)
+    dp.close()
+      .open();
+
+    // read the pages in reverse order, more than fit into the queue
+    std::vector<Page *> pages;
+    std::vector<uint64_t> addresses;
+    for (size_t i = 0; i < kPages; i++) {
+      pages.push_back(new Page(device()));
+      addresses.push_back((kPages - i - 1) * page_size);
+    }
+    device()->read_pages(pages.data(), addresses.data(), kPages);
+
+    for (size_t i = 0; i < kPages; i++) {
+      REQUIRE(pages[i]->address() == addresses[i]);
+      std::fill(buffer.begin(), buffer.end(), (uint8_t)(kPages - i - 1));
+      REQUIRE(0 == ::memcmp(pages[i]->data(), buffer.data(), page_size));
+      delete pages[i];
+    }
+  }
 };
 
 TEST_CASE("Device/newDelete", "")
@@ -222,6 +466,24 @@ TEST_CASE("Device/mmapUnmap", "")
   f.mmapUnmapTest();
 }
 
+TEST_CASE("Device/growMapping", "")
+{
+  DeviceFixture f(false);
+  f.growMappingTest();
+}
+
+TEST_CASE("Device/fileExtents", "")
+{
+  DeviceFixture f(false, 0, UPS_IO_BACKEND_PREAD, 1024 * 1024);
+  f.fileExtentsTest(1024 * 1024);
+}
+
+TEST_CASE("Device/advise", "")
+{
+  DeviceFixture f(false);
+  f.adviseTest();
+}
+
 TEST_CASE("Device/readWrite", "")
 {
   DeviceFixture f(false);
@@ -235,6 +497,333 @@ TEST_CASE("Device/readWritePage", "")
 }
 
 
+TEST_CASE("Device/arena", "")
+{
+  DeviceFixture f(false);
+  f.arenaTest();
+}
+
+TEST_CASE("Device/pageArena", "")
+{
+  DeviceFixture f(false, UPS_PAGE_ARENA_ENABLED);
+  f.pageArenaTest();
+}
+
+TEST_CASE("Device/readPages", "")
+{
+  DeviceFixture f(false, 0, UPS_IO_BACKEND_IO_URING);
+  f.readPagesTest(false);
+}
+
+TEST_CASE("Device/readPagesNoMmap", "")
+{
+  DeviceFixture f(false, 0, UPS_IO_BACKEND_IO_URING);
+  f.readPagesTest(true);
+}
+
+TEST_CASE("Device/directIo", "")
+{
+  BaseFixture f;
+  f.require_create(UPS_IN_MEMORY | UPS_DIRECT_IO, 0, UPS_INV_PARAMETER);
+
+  ups_parameter_t params[] = {
+      { UPS_PARAM_CACHE_SIZE, 64 * 1024 },
+      { 0, 0 }
+  };
+  f.require_create(UPS_DIRECT_IO, params)
+   .require_flags(UPS_DISABLE_MMAP);
+
+  // small records are stored in the pages, large records are written as
+  // blobs at unaligned offsets
+  std::vector<uint8_t> buffer(3000);
+  for (uint32_t i = 0; i < 2000; i++) {
+    ups_key_t key = ups_make_key(&i, sizeof(i));
+    std::fill(buffer.begin(), buffer.end(), (uint8_t)i);
+    ups_record_t rec = ups_make_record(buffer.data(),
+                    (uint32_t)(i % 2 ? 16 : 100 + i));
+    REQUIRE(0 == ups_db_insert(f.db, 0, &key, &rec, 0));
+  }
+
+  f.close()
+   .require_open(UPS_DIRECT_IO, params);
+
+  for (uint32_t i = 0; i < 2000; i++) {
+    ups_key_t key = ups_make_key(&i, sizeof(i));
+    ups_record_t rec = ups_make_record(0, 0);
+    REQUIRE(0 == ups_db_find(f.db, 0, &key, &rec, 0));
+    REQUIRE(rec.size == (uint32_t)(i % 2 ? 16 : 100 + i));
+    std::fill(buffer.begin(), buffer.begin() + rec.size, (uint8_t)i);
+    REQUIRE(0 == ::memcmp(rec.data, buffer.data(), rec.size));
+  }
+}
+
+TEST_CASE("Device/striped", "")
+{
+  uint32_t page_size = EnvConfig::UPS_DEFAULT_PAGE_SIZE;
+  const char *files[] = { "test.db", "test.db.1", "test.db.2" };
+
+  BaseFixture f;
+  ups_parameter_t invalid[] = {
+      { UPS_PARAM_STRIPE_PATHS, (uint64_t)"test.db.1;test.db.2" },
+      { UPS_PARAM_STRIPE_SIZE, page_size + 1 },
+      { 0, 0 }
+  };
+  f.require_create(0, invalid, UPS_INV_PARAMETER);
+
+  // stripes of two pages
+  ups_parameter_t params[] = {
+      { UPS_PARAM_STRIPE_PATHS, (uint64_t)"test.db.1;test.db.2" },
+      { UPS_PARAM_STRIPE_SIZE, 2 * page_size },
+      { 0, 0 }
+  };
+  f.require_create(0, params);
+
+  StripedDevice *sd = dynamic_cast<StripedDevice *>(f.device());
+  REQUIRE(sd != 0);
+  REQUIRE(sd->stripe_count() == 3);
+  REQUIRE(!sd->is_mapped(0, page_size));
+
+  // the stripes are assigned round-robin
+  std::vector<StripedDevice::Extent> extents = sd->split(page_size,
+                  6 * page_size);
+  REQUIRE(extents.size() == 4);
+  REQUIRE(extents[0].file == 0);
+  REQUIRE(extents[0].file_offset == page_size);
+  REQUIRE(extents[0].size == page_size);
+  REQUIRE(extents[1].file == 1);
+  REQUIRE(extents[1].file_offset == 0);
+  REQUIRE(extents[2].file == 2);
+  REQUIRE(extents[2].file_offset == 0);
+  REQUIRE(extents[2].size == 2 * page_size);
+  REQUIRE(extents[3].file == 0);
+  REQUIRE(extents[3].file_offset == 2 * page_size);
+  REQUIRE(extents[3].size == page_size);
+
+  // the files grow with the device
+  const size_t kPages = 20;
+  DeviceProxy dp(f.lenv());
+  dp.require_truncate(kPages * page_size);
+  for (size_t i = 0; i < 3; i++) {
+    struct stat st;
+    REQUIRE(0 == ::stat(files[i], &st));
+    REQUIRE((uint64_t)st.st_size == sd->file_size_of(i, kPages * page_size));
+  }
+  REQUIRE(sd->file_size_of(0, kPages * page_size) == 8 * page_size);
+  REQUIRE(sd->file_size_of(1, kPages * page_size) == 6 * page_size);
+
+  // a large write spans all files; the pages are written as vectors
+  std::vector<uint8_t> buffer(kPages * page_size);
+  for (size_t i = 0; i < kPages; i++)
+    std::fill(buffer.begin() + i * page_size,
+                    buffer.begin() + (i + 1) * page_size, (uint8_t)i);
+  dp.require_write(0, buffer.data(), 10 * page_size);
+  std::vector<struct iovec> iov(kPages - 10);
+  for (size_t i = 10; i < kPages; i++) {
+    iov[i - 10].iov_base = &buffer[i * page_size];
+    iov[i - 10].iov_len = page_size;
+  }
+  sd->write_vectored(10 * page_size, iov.data(), iov.size());
+  dp.require_flush();
+
+  std::vector<uint8_t> copy(buffer.size());
+  dp.require_read(0, copy.data(), copy.size());
+  REQUIRE(copy == buffer);
+
+  // the third stripe is the first one of the last file
+  FILE *fp = ::fopen(files[2], "rb");
+  REQUIRE(fp != 0);
+  REQUIRE(page_size == ::fread(copy.data(), 1, page_size, fp));
+  REQUIRE(0 == ::memcmp(copy.data(), &buffer[4 * page_size], page_size));
+  ::fclose(fp);
+
+  // the files are re-opened; the size is restored
+  dp.close()
+    .open();
+  REQUIRE(sd->file_size() == kPages * page_size);
+
+  // read a batch of pages from all files
+  std::vector<Page *> pages;
+  std::vector<uint64_t> addresses;
+  for (size_t i = 0; i < kPages; i++) {
+    pages.push_back(new Page(f.device()));
+    addresses.push_back((kPages - i - 1) * page_size);
+  }
+  sd->read_pages(pages.data(), addresses.data(), kPages);
+  for (size_t i = 0; i < kPages; i++) {
+    REQUIRE(pages[i]->address() == addresses[i]);
+    REQUIRE(0 == ::memcmp(pages[i]->data(), &buffer[addresses[i]],
+                            page_size));
+    delete pages[i];
+  }
+}
+
+TEST_CASE("Device/stripedEnv", "")
+{
+  ups_parameter_t params[] = {
+      { UPS_PARAM_STRIPE_PATHS, (uint64_t)"test.db.1;test.db.2;test.db.3" },
+      { UPS_PARAM_CACHE_SIZE, 64 * 1024 },
+      { 0, 0 }
+  };
+
+  BaseFixture f;
+  f.require_create(0, params)
+   .require_parameter(UPS_PARAM_STRIPE_SIZE, EnvConfig::UPS_DEFAULT_PAGE_SIZE);
+
+  std::vector<uint8_t> buffer(3000);
+  for (uint32_t i = 0; i < 2000; i++) {
+    ups_key_t key = ups_make_key(&i, sizeof(i));
+    std::fill(buffer.begin(), buffer.end(), (uint8_t)i);
+    ups_record_t rec = ups_make_record(buffer.data(),
+                    (uint32_t)(i % 2 ? 16 : 100 + i));
+    REQUIRE(0 == ups_db_insert(f.db, 0, &key, &rec, 0));
+  }
+
+  f.close()
+   .require_open(0, params);
+  REQUIRE(dynamic_cast<StripedDevice *>(f.device()) != 0);
+
+  for (uint32_t i = 0; i < 2000; i++) {
+    ups_key_t key = ups_make_key(&i, sizeof(i));
+    ups_record_t rec = ups_make_record(0, 0);
+    REQUIRE(0 == ups_db_find(f.db, 0, &key, &rec, 0));
+    REQUIRE(rec.size == (uint32_t)(i % 2 ? 16 : 100 + i));
+    std::fill(buffer.begin(), buffer.begin() + rec.size, (uint8_t)i);
+    REQUIRE(0 == ::memcmp(rec.data, buffer.data(), rec.size));
+  }
+}
+
+TEST_CASE("Device/compressed", "")
+{
+  uint32_t page_size = EnvConfig::UPS_DEFAULT_PAGE_SIZE;
+
+  BaseFixture f;
+  ups_parameter_t invalid[] = {
+      { UPS_PARAM_PAGE_COMPRESSION, UPS_COMPRESSOR_UINT32_VARBYTE },
+      { 0, 0 }
+  };
+  f.require_create(0, invalid, UPS_INV_PARAMETER);
+  ups_parameter_t params[] = {
+      { UPS_PARAM_PAGE_COMPRESSION, UPS_COMPRESSOR_LZF },
+      { 0, 0 }
+  };
+  f.require_create(UPS_DIRECT_IO, params, UPS_INV_PARAMETER);
+  f.require_create(0, params);
+
+  CompressedDevice *cd = dynamic_cast<CompressedDevice *>(f.device());
+  REQUIRE(cd != 0);
+  REQUIRE(!cd->is_mapped(0, page_size));
+
+  // compressible pages: half of each page is filled with zeroes
+  const size_t kPages = 20;
+  const uint64_t base = cd->file_size();
+  DeviceProxy dp(f.lenv());
+  dp.require_truncate(base + kPages * page_size);
+  REQUIRE(cd->file_size() == base + kPages * page_size);
+
+  std::vector<uint8_t> buffer(kPages * page_size);
+  for (size_t i = 0; i < buffer.size(); i++)
+    buffer[i] = (i % page_size) < page_size / 2 ? (uint8_t)(i * 7 + i / 13) : 0;
+  dp.require_write(base, buffer.data(), buffer.size());
+  dp.require_flush();
+  REQUIRE(cd->physical_size() < base + kPages * page_size * 3 / 4);
+
+  std::vector<uint8_t> copy(buffer.size());
+  dp.require_read(base, copy.data(), copy.size());
+  REQUIRE(copy == buffer);
+
+  // partial reads and writes across page boundaries
+  std::vector<uint8_t> part(page_size + 100, 0xab);
+  dp.require_write(base + 2 * page_size + 50, part.data(), part.size());
+  std::fill(buffer.begin() + 2 * page_size + 50,
+                  buffer.begin() + 3 * page_size + 150, 0xab);
+  dp.require_read(base + page_size + 10, copy.data(), 3 * page_size);
+  REQUIRE(0 == ::memcmp(copy.data(), &buffer[page_size + 10],
+                          3 * page_size));
+
+  // a page which no longer compresses moves to a larger slot
+  uint64_t size = cd->physical_size();
+  for (size_t i = 0; i < page_size; i++)
+    buffer[5 * page_size + i] = (uint8_t)((i * 2654435761u) >> 13);
+  dp.require_write(base + 5 * page_size, &buffer[5 * page_size], page_size);
+  REQUIRE(cd->physical_size() > size);
+
+  // the page table is loaded again; the old slot is free
+  dp.close()
+    .open();
+  REQUIRE(cd->file_size() == base + kPages * page_size);
+  dp.require_read(base, copy.data(), copy.size());
+  REQUIRE(copy == buffer);
+  size = cd->physical_size();
+  std::fill(buffer.begin() + 7 * page_size,
+                  buffer.begin() + 8 * page_size, 0x11);
+  dp.require_write(base + 7 * page_size, &buffer[7 * page_size], page_size);
+  REQUIRE(cd->physical_size() == size);
+
+  // truncating releases the slots; they are reclaimed after a flush
+  dp.require_truncate(base + 5 * page_size);
+  dp.require_flush();
+  f.device()->reclaim_space();
+  REQUIRE(cd->physical_size() < size);
+  struct stat st;
+  REQUIRE(0 == ::stat("test.db", &st));
+  REQUIRE((uint64_t)st.st_size == cd->physical_size());
+  dp.require_read(base, copy.data(), 5 * page_size);
+  REQUIRE(0 == ::memcmp(copy.data(), buffer.data(), 5 * page_size));
+}
+
+TEST_CASE("Device/compressedEnv", "")
+{
+  ups_parameter_t params[] = {
+      { UPS_PARAM_PAGE_COMPRESSION, UPS_COMPRESSOR_LZF },
+      { UPS_PARAM_CACHE_SIZE, 64 * 1024 },
+      { 0, 0 }
+  };
+
+  BaseFixture f;
+  f.require_create(0, params)
+   .require_parameter(UPS_PARAM_PAGE_COMPRESSION, UPS_COMPRESSOR_LZF);
+
+  std::vector<uint8_t> buffer(3000);
+  for (uint32_t i = 0; i < 2000; i++) {
+    ups_key_t key = ups_make_key(&i, sizeof(i));
+    std::fill(buffer.begin(), buffer.end(), (uint8_t)i);
+    ups_record_t rec = ups_make_record(buffer.data(),
+                    (uint32_t)(i % 2 ? 16 : 100 + i));
+    REQUIRE(0 == ups_db_insert(f.db, 0, &key, &rec, 0));
+  }
+
+  f.close();
+
+  // the compressed file is much smaller than the pages
+  struct stat st;
+  REQUIRE(0 == ::stat("test.db", &st));
+  uint64_t physical_size = st.st_size;
+  REQUIRE(0 == ::stat("test.db.pagemap", &st));
+  uint64_t pages = (st.st_size - sizeof(PPageTableHeader))
+                / sizeof(PPageTableEntry);
+  REQUIRE(physical_size < pages * EnvConfig::UPS_DEFAULT_PAGE_SIZE / 2);
+
+  // the algorithm has to be specified when the file is opened
+  f.require_open(0, 0, UPS_INV_FILE_HEADER);
+  ups_parameter_t zlib[] = {
+      { UPS_PARAM_PAGE_COMPRESSION, UPS_COMPRESSOR_ZLIB },
+      { 0, 0 }
+  };
+  f.require_open(0, zlib, UPS_INV_PARAMETER);
+
+  f.require_open(0, params);
+  REQUIRE(dynamic_cast<CompressedDevice *>(f.device()) != 0);
+
+  for (uint32_t i = 0; i < 2000; i++) {
+    ups_key_t key = ups_make_key(&i, sizeof(i));
+    ups_record_t rec = ups_make_record(0, 0);
+    REQUIRE(0 == ups_db_find(f.db, 0, &key, &rec, 0));
+    REQUIRE(rec.size == (uint32_t)(i % 2 ? 16 : 100 + i));
+    std::fill(buffer.begin(), buffer.begin() + rec.size, (uint8_t)i);
+    REQUIRE(0 == ::memcmp(rec.data, buffer.data(), rec.size));
+  }
+}
+
 TEST_CASE("Device/inmem/newDelete", "")
 {
   DeviceFixture f(true);
@@ -253,3 +842,8 @@ TEST_CASE("Device/inmem/flush", "")
   f.flushTest();
 }
 
+TEST_CASE("Device/inmem/pageArena", "")
+{
+  DeviceFixture f(true, UPS_PAGE_ARENA_ENABLED);
+  f.pageArenaTest();
+}
@@ -18,6 +18,8 @@
 
 #include "3rdparty/catch/catch.hpp"
 
+#include <thread>
+
 #include "2lsn_manager/lsn_manager.h"
 #include "3journal/journal.h"
 #include "4txn/txn_local.h"
@@ -1107,6 +1109,264 @@ struct JournalFixture : BaseFixture {
     require_flags(UPS_ENABLE_CRC32, true);
     require_flags(UPS_ENABLE_FSYNC, true);
   }
+
+  void groupCommitTest(bool writer_thread) {
+    close();
+    ups_parameter_t params[] = {
+        {UPS_PARAM_JOURNAL_GROUP_COMMIT_DELAY, 2000},
+        {UPS_PARAM_JOURNAL_GROUP_COMMIT_SIZE, 4},
+        {UPS_PARAM_JOURNAL_WRITER_THREAD, writer_thread ? 1u : 0u},
+        {0, 0}
+    };
+    uint32_t flags = UPS_ENABLE_TRANSACTIONS | UPS_ENABLE_FSYNC;
+    require_create(flags, params, 0, 0);
+    require_parameter(UPS_PARAM_JOURNAL_GROUP_COMMIT_DELAY, 2000);
+    require_parameter(UPS_PARAM_JOURNAL_GROUP_COMMIT_SIZE, 4);
+    require_parameter(UPS_PARAM_JOURNAL_WRITER_THREAD, writer_thread);
+
+    // four threads commit concurrently (catch is not thread-safe; the
+    // results are verified afterwards)
+    const int kThreads = 4;
+    const int kCommits = 25;
+    std::vector<std::thread> threads;
+    ups_status_t results[kThreads] = {0};
+    for (int t = 0; t < kThreads; t++) {
+      threads.push_back(std::thread([this, t, &results] {
+        for (int i = 0; i < kCommits && results[t] == 0; i++) {
+          uint32_t k = t * kCommits + i;
+          ups_key_t key = ups_make_key(&k, sizeof(k));
+          ups_record_t rec = ups_make_record(&k, sizeof(k));
+          ups_txn_t *txn;
+          results[t] = ups_txn_begin(&txn, env, 0, 0, 0);
+          if (results[t] == 0)
+            results[t] = ups_db_insert(db, txn, &key, &rec, 0);
+          if (results[t] == 0)
+            results[t] = ups_txn_commit(txn, 0);
+        }
+      }));
+    }
+    for (auto &t : threads)
+      t.join();
+    for (int t = 0; t < kThreads; t++)
+      REQUIRE(results[t] == 0);
+
+    // every commit was made durable by exactly one sync
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.journal_group_commit_txns
+                    == (uint64_t)(kThreads * kCommits));
+    REQUIRE(metrics.journal_group_commits > 0);
+    REQUIRE(metrics.journal_group_commits
+                    <= metrics.journal_group_commit_txns);
+    REQUIRE(metrics.journal_group_commit_max_size >= 1);
+
+    // the committed keys are recovered
+    close(UPS_AUTO_CLEANUP | UPS_DONT_CLEAR_LOG);
+    require_open(flags | UPS_AUTO_RECOVERY);
+    DbProxy dbp(db);
+    for (uint32_t k = 0; k < kThreads * kCommits; k++) {
+      std::vector<uint8_t> rec((uint8_t *)&k, (uint8_t *)&k + sizeof(k));
+      dbp.require_find(k, rec);
+    }
+
+    // a group size of 0 is invalid
+    close();
+    params[1].value = 0;
+    require_create(flags, params, UPS_INV_PARAMETER);
+  }
+
+  void writerThreadTest() {
+    close();
+    ups_parameter_t params[] = {
+        {UPS_PARAM_JOURNAL_WRITER_THREAD, 1},
+        {0, 0}
+    };
+    require_create(UPS_ENABLE_TRANSACTIONS, params, 0, 0);
+    require_parameter(UPS_PARAM_JOURNAL_WRITER_THREAD, 1);
+
+    // commit enough transactions to switch the log files, and insert a
+    // few keys with temporary transactions
+    DbProxy dbp(db);
+    std::vector<uint8_t> record = {'r', 'e', 'c', '\0'};
+    for (uint32_t i = 0; i < 100; i++) {
+      TxnProxy tp(env);
+      dbp.require_insert(tp.txn, i, record);
+      tp.commit();
+    }
+    for (uint32_t i = 100; i < 110; i++)
+      dbp.require_insert(i, record);
+
+    JournalProxy jp(lenv());
+    jp.flush_buffers();
+
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.journal_bytes_flushed > 0);
+
+    // closing without clearing the journal writes the remaining data;
+    // the recovery restores all keys
+    close(UPS_AUTO_CLEANUP | UPS_DONT_CLEAR_LOG);
+    require_open(UPS_ENABLE_TRANSACTIONS | UPS_AUTO_RECOVERY, params);
+    dbp = DbProxy(db);
+    for (uint32_t i = 0; i < 110; i++)
+      dbp.require_find(i, record);
+
+    // the value must be 0 or 1
+    close();
+    params[0].value = 2;
+    require_create(UPS_ENABLE_TRANSACTIONS, params, UPS_INV_PARAMETER);
+  }
+
+  // With |flags| == 0, the journal stores changesets with many (small)
+  // pages; with UPS_DONT_FLUSH_TRANSACTIONS, it stores the compressed
+  // inserts/erases of the transactions which were not yet flushed
+  void recoverWithThreadsTest(uint32_t flags) {
+#ifndef WIN32
+    close();
+    ups_parameter_t params[] = {
+        {UPS_PARAM_JOURNAL_COMPRESSION, UPS_COMPRESSOR_LZF},
+        {UPS_PARAM_PAGE_SIZE, 1024},
+        {0, 0}
+    };
+    require_create(UPS_ENABLE_TRANSACTIONS | flags, params, 0, 0);
+
+    DbProxy dbp(db);
+    std::vector<uint8_t> record(300, 'r');
+    for (uint32_t i = 0; i < 65; i++) {
+      TxnProxy tp(env);
+      for (uint32_t k = i * 32; k < i * 32 + 32; k++)
+        dbp.require_insert(tp.txn, k, record);
+      uint32_t k = i * 32;
+      ups_key_t key = ups_make_key(&k, sizeof(k));
+      REQUIRE(0 == ups_db_erase(db, tp.txn, &key, 0));
+      tp.commit();
+    }
+
+    JournalProxy jp(lenv());
+    jp.flush_buffers();
+    backup();
+    close(UPS_AUTO_CLEANUP | UPS_DONT_CLEAR_LOG);
+    restore();
+
+    ups_parameter_t open_params[] = {
+        {UPS_PARAM_RECOVERY_THREADS, 4},
+        {0, 0}
+    };
+    require_open(UPS_ENABLE_TRANSACTIONS | UPS_AUTO_RECOVERY, open_params);
+    require_parameter(UPS_PARAM_RECOVERY_THREADS, 4);
+
+    dbp = DbProxy(db);
+    for (uint32_t k = 0; k < 65 * 32; k++) {
+      if (k % 32 == 0) // erased
+        dbp.require_find(k, record, UPS_KEY_NOT_FOUND);
+      else
+        dbp.require_find(k, record);
+    }
+
+    // 0 threads are invalid
+    close();
+    open_params[0].value = 0;
+    require_open(UPS_ENABLE_TRANSACTIONS, open_params, UPS_INV_PARAMETER);
+#endif
+  }
+
+  void checkpointTest() {
+#ifndef WIN32
+    REQUIRE(UPS_INV_PARAMETER == ups_env_checkpoint(0, 0));
+    REQUIRE(UPS_INV_PARAMETER == ups_env_checkpoint(env, 1));
+
+    DbProxy dbp(db);
+    std::vector<uint8_t> record(100, 'r');
+    for (uint32_t i = 0; i < 100; i++) {
+      TxnProxy tp(env);
+      dbp.require_insert(tp.txn, i, record);
+      tp.commit();
+    }
+
+    // all pages are written; afterwards each checkpoint clears the
+    // other file and continues with it
+    REQUIRE(0 == ups_env_flush(env, 0));
+    REQUIRE(0 == ups_env_checkpoint(env, 0));
+    REQUIRE(0 == ups_env_checkpoint(env, 0));
+
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.journal_checkpoints == 2);
+
+    // each file only stores a checkpoint with an empty dirty page table
+    Journal *journal = lenv()->journal.get();
+    for (int i = 0; i < 2; i++)
+      REQUIRE(journal->state.files[i].file_size()
+                      == sizeof(PJournalEntry) + sizeof(PJournalEntryCheckpoint));
+
+    // a long-running transaction prevents the following transactions
+    // from being flushed; the checkpoint keeps them in the journal
+    TxnProxy tlong(env);
+    dbp.require_insert(tlong.txn, 1000u, record);
+    for (uint32_t i = 100; i < 120; i++) {
+      TxnProxy tp(env);
+      dbp.require_insert(tp.txn, i, record);
+      tp.commit();
+    }
+    REQUIRE(0 == ups_env_checkpoint(env, 0));
+    tlong.commit();
+    for (uint32_t i = 120; i < 140; i++) {
+      TxnProxy tp(env);
+      dbp.require_insert(tp.txn, i, record);
+      tp.commit();
+    }
+    REQUIRE(0 == ups_env_checkpoint(env, 0));
+
+    JournalProxy jp(lenv());
+    jp.flush_buffers();
+    backup();
+    close(UPS_AUTO_CLEANUP | UPS_DONT_CLEAR_LOG);
+    restore();
+
+    require_open(UPS_ENABLE_TRANSACTIONS | UPS_AUTO_RECOVERY);
+    dbp = DbProxy(db);
+    for (uint32_t i = 0; i < 140; i++)
+      dbp.require_find(i, record);
+    dbp.require_find(1000u, record);
+#endif
+  }
+
+  void autoCheckpointTest() {
+#ifndef WIN32
+    close();
+    ups_parameter_t params[] = {
+        {UPS_PARAM_JOURNAL_CHECKPOINT_SIZE, 16 * 1024},
+        {UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL, 3600},
+        {0, 0}
+    };
+    require_create(UPS_ENABLE_TRANSACTIONS, params, 0, 0);
+    require_parameter(UPS_PARAM_JOURNAL_CHECKPOINT_SIZE, 16 * 1024);
+    require_parameter(UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL, 3600);
+
+    DbProxy dbp(db);
+    std::vector<uint8_t> record(300, 'r');
+    for (uint32_t i = 0; i < 500; i++) {
+      TxnProxy tp(env);
+      dbp.require_insert(tp.txn, i, record);
+      tp.commit();
+    }
+
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.journal_checkpoints > 0);
+
+    JournalProxy jp(lenv());
+    jp.flush_buffers();
+    backup();
+    close(UPS_AUTO_CLEANUP | UPS_DONT_CLEAR_LOG);
+    restore();
+
+    require_open(UPS_ENABLE_TRANSACTIONS | UPS_AUTO_RECOVERY, params);
+    dbp = DbProxy(db);
+    for (uint32_t i = 0; i < 500; i++)
+      dbp.require_find(i, record);
+#endif
+  }
 };
 
 TEST_CASE("Journal/createClose", "")
@@ -1277,5 +1537,47 @@ TEST_CASE("Journal/recoverWithCrc32Test", "")
   f.recoverWithCrc32Test();
 }
 
+TEST_CASE("Journal/groupCommitTest", "")
+{
+  JournalFixture f;
+  f.groupCommitTest(false);
+}
+
+TEST_CASE("Journal/groupCommitWriterThreadTest", "")
+{
+  JournalFixture f;
+  f.groupCommitTest(true);
+}
+
+TEST_CASE("Journal/writerThreadTest", "")
+{
+  JournalFixture f;
+  f.writerThreadTest();
+}
+
+TEST_CASE("Journal/recoverWithThreadsTest", "")
+{
+  JournalFixture f;
+  f.recoverWithThreadsTest(0);
+}
+
+TEST_CASE("Journal/recoverUnflushedWithThreadsTest", "")
+{
+  JournalFixture f;
+  f.recoverWithThreadsTest(UPS_DONT_FLUSH_TRANSACTIONS);
+}
+
+TEST_CASE("Journal/checkpointTest", "")
+{
+  JournalFixture f;
+  f.checkpointTest();
+}
+
+TEST_CASE("Journal/autoCheckpointTest", "")
+{
+  JournalFixture f;
+  f.autoCheckpointTest();
+}
+
 } // namespace upscaledb
 
@@ -212,6 +212,47 @@ TEST_CASE("Os/readWrite")
   }
 }
 
+TEST_CASE("Os/directIo")
+{
+  FileProxy fp;
+  fp.require_create("test.db", 0664);
+  if (!fp.f.enable_direct_io())
+    return; // not supported by the file system
+  REQUIRE(fp.f.is_direct_io());
+
+  // unaligned writes and reads are copied through a bounce buffer
+  char buffer[100], orig[100];
+  for (uint32_t i = 0; i < 100; i++) {
+    ::memset(buffer, i, sizeof(buffer));
+    fp.require_pwrite(i * sizeof(buffer), buffer, sizeof(buffer));
+    fp.require_size((i + 1) * sizeof(buffer));
+  }
+  for (uint32_t i = 0; i < 100; i++) {
+    ::memset(orig, i, sizeof(orig));
+    ::memset(buffer, 0, sizeof(buffer));
+    fp.require_pread(i * sizeof(buffer), buffer, sizeof(buffer));
+    REQUIRE(0 == ::memcmp(buffer, orig, sizeof(buffer)));
+  }
+
+  // aligned writes and reads are performed directly
+  size_t size = 2 * File::kDirectIoAlignment;
+  void *aligned;
+  REQUIRE(0 == ::posix_memalign(&aligned, File::kDirectIoAlignment, size));
+  ::memset(aligned, 'x', size);
+  fp.require_pwrite(2 * size, aligned, size)
+    .require_size(3 * size);
+  ::memset(aligned, 0, size);
+  fp.require_pread(2 * size, aligned, size);
+  ::memset(orig, 'x', sizeof(orig));
+  REQUIRE(0 == ::memcmp(aligned, orig, sizeof(orig)));
+  ::free(aligned);
+
+  // the unaligned data was not overwritten
+  ::memset(orig, 99, sizeof(orig));
+  fp.require_pread(99 * sizeof(buffer), buffer, sizeof(buffer));
+  REQUIRE(0 == ::memcmp(buffer, orig, sizeof(buffer)));
+}
+
 TEST_CASE("Os/mmap")
 {
   uint32_t page_size = File::granularity();
@@ -66,6 +66,38 @@ struct PageFixture : public BaseFixture {
     tmp.require_fetch(page_size * 2)
        .require_data(pp.page->data(), page_size);
   }
+
+  void flushVectoredTest() {
+    uint32_t page_size = lenv()->config.page_size_bytes;
+
+    // 6 adjacent pages; the 4th page is not dirty, therefore the first
+    // 3 and the last 2 pages are written with one call each
+    PageProxy pp[6];
+    Page *pages[6];
+    for (int i = 0; i < 6; i++) {
+      pp[i].allocate(lenv());
+      pp[i].require_alloc(0, page_size)
+           .require_address(page_size * (i + 2));
+      ::memset(pp[i].page->payload(), i + 1,
+                      page_size - Page::kSizeofPersistentHeader);
+      pp[i].set_dirty();
+      pages[i] = pp[i].page;
+    }
+    pp[3].page->set_dirty(false);
+
+    uint64_t flushed = Page::ms_page_count_flushed;
+    Page::flush(pages, 6);
+    REQUIRE(Page::ms_page_count_flushed == flushed + 5);
+
+    for (int i = 0; i < 6; i++) {
+      pp[i].require_dirty(false);
+      if (i == 3)
+        continue;
+      PageProxy tmp(lenv());
+      tmp.require_fetch(page_size * (i + 2))
+         .require_data(pp[i].page->data(), page_size);
+    }
+  }
 };
 
 TEST_CASE("Page/newDelete", "")
@@ -94,6 +126,18 @@ TEST_CASE("Page/fetchFlush", "")
   f.fetchFlushTest();
 }
 
+TEST_CASE("Page/flushVectored", "")
+{
+  PageFixture f;
+  f.flushVectoredTest();
+}
+
+TEST_CASE("Page/nommap/flushVectored", "")
+{
+  PageFixture f(UPS_DISABLE_MMAP);
+  f.flushVectoredTest();
+}
+
 TEST_CASE("Page/nommap/newDelete", "")
 {
   PageFixture f(UPS_DISABLE_MMAP);
@@ -19,8 +19,11 @@
 #include "3rdparty/catch/catch.hpp"
 
 #include "1base/pickle.h"
+#include "1base/signal.h"
+#include "1os/file.h"
 #include "3page_manager/freelist.h"
 #include "3page_manager/page_manager.h"
+#include "3btree/btree_node.h"
 #include "4context/context.h"
 
 #include "fixture.hpp"
@@ -226,6 +229,444 @@ struct PageManagerFixture : BaseFixture {
     REQUIRE(false == page_manager->state->cache.is_cache_full());
   }
 
+  void shardedCacheTest() {
+    ups_parameter_t param[] = {
+        { UPS_PARAM_CACHE_SIZE, 16 * EnvConfig::UPS_DEFAULT_PAGE_SIZE },
+        { UPS_PARAM_CACHE_SHARDS, 4 },
+        { 0, 0 }
+    };
+
+    close();
+    require_create(0, param);
+    require_parameter(UPS_PARAM_CACHE_SHARDS, 4);
+
+    Cache &cache = lenv()->page_manager->state->cache;
+    REQUIRE(4u == cache.state.shards.size());
+
+    uint32_t page_size = lenv()->config.page_size_bytes;
+    PPageData pers;
+    ::memset(&pers, 0, sizeof(pers));
+    std::vector<Page *> v;
+
+    size_t initial = cache.current_elements();
+    for (unsigned int i = 0; i < 20; i++) {
+      Page *p = new Page(lenv()->device.get());
+      p->set_without_header(true);
+      p->assign_allocated_buffer(&pers, (i + 100) * page_size);
+      v.push_back(p);
+      cache.put(p);
+    }
+
+    REQUIRE(initial + 20 == cache.current_elements());
+    REQUIRE(true == cache.is_cache_full());
+    for (unsigned int i = 0; i < 4; i++)
+      REQUIRE(cache.state.shards[i].totallist.size() >= 5u);
+
+    for (unsigned int i = 0; i < 20; i++) {
+      REQUIRE(v[i] == cache.get(v[i]->address()));
+      REQUIRE(cache.shard_of(v[i]->address())
+                      == &cache.state.shards[(i + 100) % 4]);
+    }
+
+    // each shard contributes its share of the purge candidates
+    std::vector<uint64_t> candidates;
+    std::vector<Page *> garbage;
+    cache.purge_candidates(candidates, garbage, 0);
+    REQUIRE(garbage.size() >= 4u);
+
+    for (unsigned int i = 0; i < 20; i++) {
+      cache.del(v[i]);
+      REQUIRE((Page *)0 == cache.get(v[i]->address()));
+      v[i]->set_data(0);
+      delete v[i];
+    }
+
+    REQUIRE(initial == cache.current_elements());
+  }
+
+  void clockPolicyTest() {
+    ups_parameter_t param[] = {
+        { UPS_PARAM_CACHE_SIZE, 16 * EnvConfig::UPS_DEFAULT_PAGE_SIZE },
+        { UPS_PARAM_CACHE_POLICY, UPS_CACHE_POLICY_CLOCK },
+        { 0, 0 }
+    };
+
+    close();
+    require_create(0, param);
+    require_parameter(UPS_PARAM_CACHE_POLICY, UPS_CACHE_POLICY_CLOCK);
+
+    Cache &cache = lenv()->page_manager->state->cache;
+    uint32_t page_size = lenv()->config.page_size_bytes;
+    PPageData pers;
+    ::memset(&pers, 0, sizeof(pers));
+    std::vector<Page *> v;
+
+    for (unsigned int i = 0; i < 20; i++) {
+      Page *p = new Page(lenv()->device.get());
+      p->set_without_header(true);
+      p->assign_allocated_buffer(&pers, (i + 100) * page_size);
+      v.push_back(p);
+      cache.put(p);
+    }
+
+    // a cache hit does not move the page
+    Page *head = cache.state.shards[0].totallist.head();
+    REQUIRE(v[0] == cache.get(v[0]->address()));
+    REQUIRE(head == cache.state.shards[0].totallist.head());
+
+    // the first sweep only clears the reference bits of the new pages
+    std::vector<uint64_t> candidates;
+    std::vector<Page *> garbage;
+    cache.purge_candidates(candidates, garbage, 0);
+    REQUIRE(garbage.empty());
+
+    // now reference the first 10 pages; they must not be purged
+    for (unsigned int i = 0; i < 10; i++)
+      REQUIRE(v[i] == cache.get(v[i]->address()));
+
+    candidates.clear();
+    garbage.clear();
+    cache.purge_candidates(candidates, garbage, 0);
+    REQUIRE(garbage.size() > 0u);
+    for (unsigned int i = 0; i < garbage.size(); i++) {
+      for (unsigned int j = 0; j < 10; j++)
+        REQUIRE(garbage[i] != v[j]);
+    }
+
+    for (unsigned int i = 0; i < 20; i++) {
+      cache.del(v[i]);
+      v[i]->set_data(0);
+      delete v[i];
+    }
+  }
+
+  void slruPolicyTest() {
+    ups_parameter_t param[] = {
+        { UPS_PARAM_CACHE_SIZE, 16 * EnvConfig::UPS_DEFAULT_PAGE_SIZE },
+        { UPS_PARAM_CACHE_POLICY, UPS_CACHE_POLICY_SLRU },
+        { 0, 0 }
+    };
+
+    close();
+    require_create(0, param);
+
+    Cache &cache = lenv()->page_manager->state->cache;
+    CacheShard &shard = cache.state.shards[0];
+    uint32_t page_size = lenv()->config.page_size_bytes;
+    PPageData pers;
+    ::memset(&pers, 0, sizeof(pers));
+    std::vector<Page *> v;
+
+    // the hot pages are accessed twice and move to the protected segment
+    for (unsigned int i = 0; i < 10; i++) {
+      Page *p = new Page(lenv()->device.get());
+      p->set_without_header(true);
+      p->assign_allocated_buffer(&pers, (i + 100) * page_size);
+      v.push_back(p);
+      cache.put(p);
+      REQUIRE(p == cache.get(p->address()));
+      REQUIRE(true == p->cache_protected);
+    }
+
+    // a scan does not promote its pages
+    for (unsigned int i = 0; i < 20; i++) {
+      Page *p = new Page(lenv()->device.get());
+      p->set_without_header(true);
+      p->assign_allocated_buffer(&pers, (i + 200) * page_size);
+      v.push_back(p);
+      cache.put(p, true);
+      REQUIRE(p == cache.get(p->address(), true));
+      REQUIRE(false == p->cache_protected);
+      REQUIRE(p == shard.totallist.tail());
+    }
+    for (unsigned int i = 0; i < 10; i++)
+      REQUIRE(true == v[i]->cache_protected);
+
+    // the scanned pages are purged first
+    std::vector<uint64_t> candidates;
+    std::vector<Page *> garbage;
+    cache.purge_candidates(candidates, garbage, 0);
+    REQUIRE(garbage.size() > 0u);
+    for (unsigned int i = 0; i < garbage.size(); i++) {
+      for (unsigned int j = 0; j < 10; j++)
+        REQUIRE(garbage[i] != v[j]);
+    }
+
+    // a regular access promotes a scanned page
+    REQUIRE(v[15] == cache.get(v[15]->address()));
+    REQUIRE(true == v[15]->cache_protected);
+
+    for (unsigned int i = 0; i < v.size(); i++) {
+      cache.del(v[i]);
+      REQUIRE(false == v[i]->cache_protected);
+      v[i]->set_data(0);
+      delete v[i];
+    }
+  }
+
+  void internalNodePriorityTest(uint32_t reserve) {
+    ups_parameter_t param[] = {
+        { UPS_PARAM_CACHE_SIZE, 16 * EnvConfig::UPS_DEFAULT_PAGE_SIZE },
+        { UPS_PARAM_CACHE_INTERNAL_NODES, reserve },
+        { 0, 0 }
+    };
+
+    close();
+    require_create(0, param);
+    require_parameter(UPS_PARAM_CACHE_INTERNAL_NODES, reserve);
+
+    Cache &cache = lenv()->page_manager->state->cache;
+    CacheShard &shard = cache.state.shards[0];
+    uint32_t page_size = lenv()->config.page_size_bytes;
+    std::vector<uint8_t> buffer(20 * page_size);
+    std::vector<Page *> v;
+
+    // the first 10 pages (the least recently used ones) are internal nodes,
+    // the others are leaf nodes
+    size_t internal = shard.internal_elements;
+    for (unsigned int i = 0; i < 20; i++) {
+      Page *p = new Page(lenv()->device.get());
+      p->assign_allocated_buffer(&buffer[i * page_size],
+                      (i + 100) * page_size);
+      p->set_type(Page::kTypeBindex);
+      if (i >= 10)
+        PBtreeNode::from_page(p)->set_flags(PBtreeNode::kLeafNode);
+      v.push_back(p);
+      cache.put(p);
+    }
+    REQUIRE(internal + 10 == shard.internal_elements);
+
+    // only leaf nodes are purged
+    std::vector<uint64_t> candidates;
+    std::vector<Page *> garbage;
+    cache.purge_candidates(candidates, garbage, 0);
+    REQUIRE(garbage.size() > 0u);
+    for (unsigned int i = 0; i < garbage.size(); i++)
+      REQUIRE(garbage[i]->cache_priority == Cache::kPriorityDefault);
+
+    // remove the leaf nodes and add more internal nodes; now the
+    // internal nodes are purged, but only those exceeding the budget
+    for (unsigned int i = 10; i < 20; i++) {
+      cache.del(v[i]);
+      PBtreeNode::from_page(v[i])->set_flags(0);
+      cache.put(v[i]);
+    }
+    REQUIRE(internal + 20 == shard.internal_elements);
+
+    candidates.clear();
+    garbage.clear();
+    cache.purge_candidates(candidates, garbage, 0);
+    size_t evicted = 0;
+    for (unsigned int i = 0; i < garbage.size(); i++)
+      if (garbage[i]->cache_priority == Cache::kPriorityInternalNode)
+        evicted++;
+    REQUIRE(evicted > 0u);
+    REQUIRE(evicted <= shard.internal_elements
+                            - cache.state.internal_node_limit);
+
+    for (unsigned int i = 0; i < 20; i++) {
+      cache.del(v[i]);
+      v[i]->set_data(0);
+      delete v[i];
+    }
+    REQUIRE(internal == shard.internal_elements);
+  }
+
+  void growHashTableTest() {
+    Cache &cache = lenv()->page_manager->state->cache;
+    CacheShard *shard = &cache.state.shards[0];
+    size_t initial_buckets = shard->buckets.size();
+    REQUIRE(initial_buckets >= (size_t)CacheState::kMinBuckets);
+    REQUIRE(0u == (initial_buckets & (initial_buckets - 1)));
+
+    uint32_t page_size = lenv()->config.page_size_bytes;
+    PPageData pers;
+    ::memset(&pers, 0, sizeof(pers));
+    std::vector<Page *> v;
+
+    size_t initial = cache.current_elements();
+    for (unsigned int i = 0; i < 8 * initial_buckets; i++) {
+      Page *p = new Page(lenv()->device.get());
+      p->set_without_header(true);
+      p->assign_allocated_buffer(&pers, (i + 100) * page_size);
+      v.push_back(p);
+      cache.put(p);
+
+      // all pages are found while the buckets are migrated
+      if (i % 7 == 0) {
+        for (unsigned int j = 0; j <= i; j++)
+          REQUIRE(v[j] == cache.get(v[j]->address()));
+      }
+    }
+
+    REQUIRE(initial + v.size() == cache.current_elements());
+    REQUIRE(shard->buckets.size() >= 8 * initial_buckets);
+
+    ups_env_metrics_t metrics = {0};
+    cache.fill_metrics(&metrics);
+    REQUIRE(metrics.cache_buckets >= 8 * initial_buckets);
+    REQUIRE(metrics.cache_avg_chain_length >= 1.0);
+    REQUIRE(metrics.cache_avg_chain_length < 2.0);
+
+    for (unsigned int i = 0; i < v.size(); i++) {
+      cache.del(v[i]);
+      REQUIRE((Page *)0 == cache.get(v[i]->address()));
+      v[i]->set_data(0);
+      delete v[i];
+    }
+
+    REQUIRE(initial == cache.current_elements());
+  }
+
+  void flushThreadsTest() {
+    ups_parameter_t param[] = {
+        { UPS_PARAM_CACHE_SIZE, 64 * EnvConfig::UPS_DEFAULT_PAGE_SIZE },
+        { UPS_PARAM_FLUSH_THREADS, 4 },
+        { 0, 0 }
+    };
+
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS, param);
+    require_parameter(UPS_PARAM_FLUSH_THREADS, 4);
+    REQUIRE(4u == lenv()->page_manager->state->worker->size());
+
+    // the small cache is purged frequently, and large Changesets are
+    // flushed by several threads
+    char buffer[200] = {0};
+    for (uint32_t i = 0; i < 20000; i += 100) {
+      ups_txn_t *txn;
+      REQUIRE(0 == ups_txn_begin(&txn, env, 0, 0, 0));
+      for (uint32_t j = i; j < i + 100; j++) {
+        ups_key_t key = ups_make_key(&j, sizeof(j));
+        ups_record_t rec = ups_make_record(buffer, sizeof(buffer));
+        REQUIRE(0 == ups_db_insert(db, txn, &key, &rec, 0));
+      }
+      REQUIRE(0 == ups_txn_commit(txn, 0));
+    }
+
+    // all queued work items are processed
+    lenv()->page_manager->state->worker->wait_for_pending();
+    REQUIRE(lenv()->page_manager->state->worker->pending.empty());
+
+    close();
+    require_open(UPS_ENABLE_TRANSACTIONS, param);
+    for (uint32_t i = 0; i < 20000; i++) {
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t rec = ups_make_record(0, 0);
+      REQUIRE(0 == ups_db_find(db, 0, &key, &rec, 0));
+    }
+
+    // invalid parameters
+    close();
+    param[1].value = 0;
+    REQUIRE(UPS_INV_PARAMETER == ups_env_create(&env, "test.db", 0, 0644,
+                            param));
+    param[1].value = 65;
+    REQUIRE(UPS_INV_PARAMETER == ups_env_create(&env, "test.db", 0, 0644,
+                            param));
+  }
+
+  void warmupTest() {
+    ups_parameter_t param[] = {
+        { UPS_PARAM_CACHE_SIZE, 64 * EnvConfig::UPS_DEFAULT_PAGE_SIZE },
+        { UPS_PARAM_CACHE_WARMUP, 32 },
+        { 0, 0 }
+    };
+
+    close();
+    require_create(0, param);
+    require_parameter(UPS_PARAM_CACHE_WARMUP, 32);
+
+    char buffer[200] = {0};
+    for (uint32_t i = 0; i < 2000; i++) {
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t rec = ups_make_record(buffer, sizeof(buffer));
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &rec, 0));
+    }
+    close();
+
+    File file;
+    file.open("test.db.wrm", true);
+    REQUIRE(file.file_size() > 16u * sizeof(uint64_t));
+    file.close();
+
+    // without the parameter, only the root page is loaded
+    require_open(0, 0);
+    size_t cold = lenv()->page_manager->state->cache.current_elements();
+    close();
+
+    // the worker thread loads the pages; wait till it processed the
+    // warm-up message
+    require_open(0, param);
+    Signal signal;
+    lenv()->page_manager->run_async(boost::bind(&Signal::notify, &signal));
+    signal.wait();
+    Cache &cache = lenv()->page_manager->state->cache;
+    REQUIRE(cache.current_elements() >= cold + 16);
+
+    for (uint32_t i = 0; i < 2000; i++) {
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t rec = ups_make_record(0, 0);
+      REQUIRE(0 == ups_db_find(db, 0, &key, &rec, 0));
+      REQUIRE(sizeof(buffer) == rec.size);
+    }
+  }
+
+  void cacheSamplerTest() {
+    // a loop over 150 pages is served by a LRU cache with at least 150
+    // pages, but never by a smaller one
+    CacheSampler sampler(CacheSampler::kRateScale, 100);
+    for (int round = 0; round < 20; round++)
+      for (uint64_t i = 0; i < 150; i++)
+        sampler.access(i * 1024);
+
+    ups_env_metrics_t metrics;
+    ::memset(&metrics, 0, sizeof(metrics));
+    sampler.fill_metrics(&metrics, 1024);
+    REQUIRE(metrics.cache_advice_size_bytes[0] == 12 * 1024u);
+    REQUIRE(metrics.cache_advice_size_bytes[3] == 100 * 1024u);
+    REQUIRE(metrics.cache_advice_size_bytes[7] == 1600 * 1024u);
+    for (int i = 0; i < 4; i++)
+      REQUIRE(metrics.cache_advice_hit_ratio[i] == 0.0);
+    for (int i = 4; i < UPS_CACHE_ADVICE_SIZES; i++)
+      REQUIRE(metrics.cache_advice_hit_ratio[i] == Approx(0.95));
+
+    // enable the sampler in the environment
+    ups_parameter_t param[] = {
+        { UPS_PARAM_CACHE_SIZE, 64 * EnvConfig::UPS_DEFAULT_PAGE_SIZE },
+        { UPS_PARAM_CACHE_SAMPLING, 1000 },
+        { 0, 0 }
+    };
+
+    close();
+    require_create(0, param);
+    require_parameter(UPS_PARAM_CACHE_SAMPLING, 1000);
+    REQUIRE(lenv()->page_manager->state->cache.state.sampler.get() != 0);
+
+    char buffer[200] = {0};
+    for (uint32_t i = 0; i < 2000; i++) {
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t rec = ups_make_record(buffer, sizeof(buffer));
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &rec, 0));
+    }
+
+    ::memset(&metrics, 0, sizeof(metrics));
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.cache_advice_size_bytes[3]
+                == 64 * EnvConfig::UPS_DEFAULT_PAGE_SIZE);
+    for (int i = 1; i < UPS_CACHE_ADVICE_SIZES; i++)
+      REQUIRE(metrics.cache_advice_hit_ratio[i]
+                >= metrics.cache_advice_hit_ratio[i - 1]);
+    REQUIRE(metrics.cache_advice_hit_ratio[7] > 0.0);
+    REQUIRE(metrics.cache_advice_hit_ratio[7] <= 1.0);
+
+    // invalid sampling rate
+    close();
+    param[1].value = 1001;
+    REQUIRE(UPS_INV_PARAMETER == ups_env_create(&env, "test.db", 0, 0644,
+                            param));
+  }
+
   void storeStateTest() {
     PageManagerState *state = lenv()->page_manager->state.get();
     uint32_t page_size = lenv()->config.page_size_bytes;
@@ -340,9 +781,87 @@ struct PageManagerFixture : BaseFixture {
 
     page_manager->initialize(page_id);
 
-    REQUIRE(10 == page_manager->state->freelist.free_pages.size());
-    for (int i = 1; i < 10; i++)
-      REQUIRE(page_manager->state->freelist.free_pages[page_size * (1 + i * 15)] == 15);
+    // the sequences of 15 pages are merged into a single run
+    REQUIRE(1 == page_manager->state->freelist.free_pages.size());
+    REQUIRE(page_manager->state->freelist.free_pages[page_size] == 150);
+    REQUIRE(1 == page_manager->state->freelist.size_index.size());
+  }
+
+  void bestFitFreelistTest() {
+    Freelist freelist(lenv()->config);
+    uint32_t page_size = lenv()->config.page_size_bytes;
+
+    // runs with 5, 2 and 3 pages
+    freelist.put(page_size * 10, 5);
+    freelist.put(page_size * 20, 2);
+    freelist.put(page_size * 30, 3);
+    REQUIRE(3 == freelist.free_pages.size());
+    REQUIRE(3 == freelist.size_index.size());
+    REQUIRE(true == freelist.has(page_size * 14));
+    REQUIRE(false == freelist.has(page_size * 15));
+    REQUIRE(true == freelist.has(page_size * 21));
+    REQUIRE(false == freelist.has(page_size * 22));
+
+    // the smallest run which is big enough is used
+    REQUIRE(page_size * 20 == freelist.alloc(2));
+    REQUIRE(page_size * 30 == freelist.alloc(1));
+    REQUIRE(page_size * 31 == freelist.alloc(2));
+    REQUIRE(page_size * 10 == freelist.alloc(3));
+    REQUIRE(0 == freelist.alloc(3));
+    REQUIRE(1 == freelist.free_pages.size());
+    REQUIRE(freelist.free_pages[page_size * 13] == 2);
+
+    // adjacent runs are merged with their predecessor and/or successor
+    freelist.put(page_size * 11, 1);
+    REQUIRE(2 == freelist.free_pages.size());
+    freelist.put(page_size * 12, 1);
+    REQUIRE(1 == freelist.free_pages.size());
+    REQUIRE(freelist.free_pages[page_size * 11] == 4);
+    freelist.put(page_size * 10, 1);
+    REQUIRE(freelist.free_pages[page_size * 10] == 5);
+    freelist.put(page_size * 21, 2);
+    REQUIRE(2 == freelist.free_pages.size());
+    freelist.put(page_size * 15, 5);
+    freelist.put(page_size * 20, 1);
+    REQUIRE(1 == freelist.free_pages.size());
+    REQUIRE(1 == freelist.size_index.size());
+    REQUIRE(freelist.free_pages[page_size * 10] == 13);
+
+    // pages which are already free are ignored
+    freelist.put(page_size * 12, 1);
+    REQUIRE(freelist.free_pages[page_size * 10] == 13);
+
+    // the whole run is truncated
+    REQUIRE(page_size * 10 == freelist.truncate(page_size * 23));
+    REQUIRE(true == freelist.empty());
+    REQUIRE(0 == freelist.size_index.size());
+  }
+
+  void storeLongRunTest() {
+    PageManager *page_manager = lenv()->page_manager.get();
+    uint32_t page_size = lenv()->config.page_size_bytes;
+
+    // a run which does not fit into a single page
+    page_manager->state->freelist.put(page_size * 100, 100000);
+    page_manager->state->freelist.put(page_size * 200000, 3);
+
+    page_manager->state->needs_flush = true;
+    uint64_t page_id = page_manager->test_store_state();
+
+    // both runs fit into the state page
+    REQUIRE(0 == *(uint64_t *)(page_manager->state->state_page->payload()
+                                + sizeof(uint64_t)));
+
+    page_manager->flush_all_pages();
+    page_manager->state->freelist.clear();
+
+    page_manager->initialize(page_id);
+
+    REQUIRE(2 == page_manager->state->freelist.free_pages.size());
+    REQUIRE(page_manager->state->freelist.free_pages[page_size * 100]
+                    == 100000);
+    REQUIRE(page_manager->state->freelist.free_pages[page_size * 200000]
+                    == 3);
   }
 
   void encodeDecodeTest() {
@@ -352,6 +871,43 @@ struct PageManagerFixture : BaseFixture {
       int num_bytes = Pickle::encode_u64(&buffer[0], i * 13);
       REQUIRE(Pickle::decode_u64(num_bytes, &buffer[0]) == (uint64_t)i * 13);
     }
+
+    uint64_t values[] = {0, 1, 0x7f, 0x80, 0x3fff, 0x4000, 1ull << 35,
+                         0xffffffffffffffffull};
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+      size_t num_bytes = Pickle::encode_varint(&buffer[0], values[i]);
+      REQUIRE(num_bytes <= (size_t)Pickle::kMaxVarintSize);
+      uint64_t n = 0;
+      REQUIRE(Pickle::decode_varint(&buffer[0], &n) == num_bytes);
+      REQUIRE(n == values[i]);
+    }
+    REQUIRE(Pickle::encode_varint(&buffer[0], 0x7f) == 1u);
+    REQUIRE(Pickle::encode_varint(&buffer[0], 0x80) == 2u);
+  }
+
+  void decodeNibbleFormatTest() {
+    PageManager *page_manager = lenv()->page_manager.get();
+    uint32_t page_size = lenv()->config.page_size_bytes;
+
+    // new files use the varint format
+    REQUIRE(lenv()->header->freelist_format() == Freelist::kFormatVarint);
+
+    // the state of older files: 15 pages at id 0x10, 1 page at 0x100, and
+    // 15 pages at 0x101 which are merged with the previous page
+    uint8_t data[] = {
+      3, 0, 0, 0,                 // counter
+      (15 << 4) | 2, 0x0, 0x1,    // 0x10
+      (1 << 4) | 3, 0x0, 0x0, 0x1, // 0x100
+      (15 << 4) | 3, 0x1, 0x0, 0x1 // 0x101
+    };
+    Freelist &freelist = page_manager->state->freelist;
+    freelist.clear();
+    freelist.decode_state(data, Freelist::kFormatNibble);
+
+    REQUIRE(2 == freelist.free_pages.size());
+    REQUIRE(freelist.free_pages[page_size * 0x10] == 15);
+    REQUIRE(freelist.free_pages[page_size * 0x100] == 16);
+    freelist.clear();
   }
 
   void storeBigStateTest() {
@@ -383,7 +939,8 @@ struct PageManagerFixture : BaseFixture {
         REQUIRE(page_manager->state->freelist.free_pages[page_size * i] == 1);
     }
 
-    REQUIRE(page_manager->state->page_count_page_manager == 4u);
+    // each run is encoded in 2 bytes; the state needs one overflow page
+    REQUIRE(page_manager->state->page_count_page_manager == 1u);
   }
 
   void allocMultiBlobs() {
@@ -466,6 +1023,60 @@ TEST_CASE("PageManager/cacheFullTest", "")
   f.cacheFullTest();
 }
 
+TEST_CASE("PageManager/shardedCacheTest", "")
+{
+  PageManagerFixture f;
+  f.shardedCacheTest();
+}
+
+TEST_CASE("PageManager/clockPolicyTest", "")
+{
+  PageManagerFixture f;
+  f.clockPolicyTest();
+}
+
+TEST_CASE("PageManager/slruPolicyTest", "")
+{
+  PageManagerFixture f;
+  f.slruPolicyTest();
+}
+
+TEST_CASE("PageManager/internalNodePriorityTest", "")
+{
+  PageManagerFixture f;
+  f.internalNodePriorityTest(0);
+}
+
+TEST_CASE("PageManager/internalNodeBudgetTest", "")
+{
+  PageManagerFixture f;
+  f.internalNodePriorityTest(50);
+}
+
+TEST_CASE("PageManager/growHashTableTest", "")
+{
+  PageManagerFixture f(false, 16 * EnvConfig::UPS_DEFAULT_PAGE_SIZE);
+  f.growHashTableTest();
+}
+
+TEST_CASE("PageManager/flushThreadsTest", "")
+{
+  PageManagerFixture f;
+  f.flushThreadsTest();
+}
+
+TEST_CASE("PageManager/warmupTest", "")
+{
+  PageManagerFixture f;
+  f.warmupTest();
+}
+
+TEST_CASE("PageManager/cacheSamplerTest", "")
+{
+  PageManagerFixture f;
+  f.cacheSamplerTest();
+}
+
 TEST_CASE("PageManager/storeStateTest", "")
 {
   PageManagerFixture f(false, 16 * EnvConfig::UPS_DEFAULT_PAGE_SIZE);
@@ -490,12 +1101,30 @@ TEST_CASE("PageManager/collapseFreelistTest", "")
   f.collapseFreelistTest();
 }
 
+TEST_CASE("PageManager/bestFitFreelistTest", "")
+{
+  PageManagerFixture f;
+  f.bestFitFreelistTest();
+}
+
+TEST_CASE("PageManager/storeLongRunTest", "")
+{
+  PageManagerFixture f;
+  f.storeLongRunTest();
+}
+
 TEST_CASE("PageManager/encodeDecodeTest", "")
 {
   PageManagerFixture f(false);
   f.encodeDecodeTest();
 }
 
+TEST_CASE("PageManager/decodeNibbleFormatTest", "")
+{
+  PageManagerFixture f;
+  f.decodeNibbleFormatTest();
+}
+
 TEST_CASE("PageManager/storeBigStateTest", "")
 {
   PageManagerFixture f(false);